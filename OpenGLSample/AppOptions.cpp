@@ -0,0 +1,464 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: AppOptions.cpp                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Command line options that select how the scene is run.                      //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "AppOptions.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+using namespace std; // Standard namespace
+
+namespace
+{
+    void printUsage(const char* program)
+    {
+        cout << "Usage: " << program << " [options]\n"
+            << "  --on-demand            redraw only when something in the scene changes\n"
+            << "  --max-idle <seconds>   with --on-demand, redraw at least this often\n"
+            << "  --sim-rate <hz>        fixed simulation steps per second (default 120)\n"
+            << "  --fps <hz>             limit the frame rate, 0 = uncapped (default)\n"
+            << "  --fps-adaptive         with --fps, fall back to 1/2, 1/3 or 1/4 of the rate while frames miss it\n"
+            << "  --vsync <n>            swap interval, -1 = driver default (default)\n"
+            << "  --frames-ahead <n>     frames the CPU may run ahead of the GPU, 0 = no limit (default 2)\n"
+            << "  --frame-log <seconds>  print frame time percentiles periodically\n"
+            << "  --dynamic-res          scale the render resolution to fit the GPU budget\n"
+            << "  --gpu-budget <ms>      GPU time per frame for --dynamic-res (default 16.7)\n"
+            << "  --min-scale <0..1>     lowest render scale for --dynamic-res (default 0.5)\n"
+            << "  --stats                show live statistics in the window title\n"
+            << "  --gpu-profile          time render passes and objects on the GPU, drawn as bars\n"
+            << "  --trace <file>         write profiled scopes as Chrome trace JSON on exit\n"
+            << "  --render-stats <file>  stream per-frame render counters as CSV (or JSON lines for .json)\n"
+            << "  --benchmark <file>     render a scripted camera path offscreen, write results and exit\n"
+            << "  --benchmark-out <file> benchmark results file (default benchmark_results.json)\n"
+            << "  --record <file>        record all input to a binary log\n"
+            << "  --replay <file>        replay a recorded input log step for step\n"
+            << "  --offscreen <W>x<H>    render into an offscreen framebuffer of this size\n"
+            << "  --msaa <samples>       multisampling for the offscreen framebuffer\n"
+            << "  --headless <egl|osmesa> render without a window system (needs GLFW 3.4)\n"
+            << "  --output <file>        save the last offscreen frame as .png or raw RGBA\n"
+            << "  --frames <count>       exit after this many frames\n"
+            << "  --capture <file>       record frames to a .y4m video or a numbered PNG sequence\n"
+            << "  --capture-fps <rate>   frame rate stored in the Y4M header (default 60)\n"
+            << "  --batch <file>         render a PNG for every camera pose in the list and exit\n"
+            << "  --batch-out <folder>   folder for the batch images (default batch)\n"
+            << "  --software             render on the CPU, no GPU or window needed\n"
+            << "  --software-threads <n> threads for --software, 0 = all cores (default)\n"
+            << "  --compare <file>       compare the last offscreen frame against a reference PNG\n"
+            << "  --path-trace <samples> path trace the last frame on the CPU and save it with --output\n"
+            << "  --path-trace-bounces <n> bounces per path for --path-trace (default 4)\n"
+            << "  --texture-arrays <grouped|size> draw from texture arrays, grouped by size or all size x size\n"
+            << "  --texture-filter <bilinear|trilinear|N> texture minification, N = anisotropy (default trilinear)\n"
+            << "  --texture-budget <MB>  stream texture mips on demand within this GPU memory budget\n"
+            << "  --texture-threads <n>  decode textures on n workers, uploading through a PBO ring\n"
+            << "  --no-texture-dedup     upload identical and flat textures in full instead of sharing them\n"
+            << "  --texture-rgba         expand RGB textures to RGBA while flipping them for upload\n"
+            << "  --image-benchmark <n>  time flipping and converting every texture n times, then exit\n"
+            << "  --pack-textures <dir>  block compress every texture into .btex files in dir, then exit\n"
+            << "  --compressed-textures <dir> upload the .btex files in dir instead of decoding images\n"
+            << "  --lazy-resources       create meshes and textures when first used, not all at startup\n"
+            << "  --bindless             pick material textures through resident handles (GL_ARB_bindless_texture)\n"
+            << "  --material-benchmark <draws> time draws with unique materials, bound and bindless, then exit\n";
+    }
+}
+
+bool parseOptions(int argc, char* argv[], AppOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--on-demand")
+        {
+            options.onDemand = true;
+        }
+        else if (arg == "--max-idle" && hasValue)
+        {
+            options.maxIdleSeconds = atof(argv[++i]);
+        }
+        else if (arg == "--sim-rate" && hasValue)
+        {
+            options.simulationHz = atof(argv[++i]);
+            if (options.simulationHz <= 0.0)
+            {
+                cout << "--sim-rate must be positive" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--fps" && hasValue)
+        {
+            options.targetFps = atof(argv[++i]);
+        }
+        else if (arg == "--fps-adaptive")
+        {
+            options.adaptiveFps = true;
+        }
+        else if (arg == "--vsync" && hasValue)
+        {
+            options.swapInterval = atoi(argv[++i]);
+        }
+        else if (arg == "--frames-ahead" && hasValue)
+        {
+            options.maxFramesAhead = atoi(argv[++i]);
+        }
+        else if (arg == "--frame-log" && hasValue)
+        {
+            options.frameLogSeconds = atof(argv[++i]);
+        }
+        else if (arg == "--dynamic-res")
+        {
+            options.dynamicResolution = true;
+        }
+        else if (arg == "--gpu-budget" && hasValue)
+        {
+            options.gpuBudgetMs = (float)atof(argv[++i]);
+        }
+        else if (arg == "--min-scale" && hasValue)
+        {
+            options.minScale = (float)atof(argv[++i]);
+            if (options.minScale <= 0.0f || options.minScale > 1.0f)
+            {
+                cout << "--min-scale must be between 0 and 1" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--stats")
+        {
+            options.showStats = true;
+        }
+        else if (arg == "--gpu-profile")
+        {
+            options.gpuProfile = true;
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            options.tracePath = argv[++i];
+        }
+        else if (arg == "--render-stats" && hasValue)
+        {
+            options.renderStatsPath = argv[++i];
+        }
+        else if (arg == "--benchmark" && hasValue)
+        {
+            options.benchmarkPath = argv[++i];
+        }
+        else if (arg == "--benchmark-out" && hasValue)
+        {
+            options.benchmarkResultsPath = argv[++i];
+        }
+        else if (arg == "--record" && hasValue)
+        {
+            options.recordPath = argv[++i];
+        }
+        else if (arg == "--replay" && hasValue)
+        {
+            options.replayPath = argv[++i];
+        }
+        else if (arg == "--offscreen" && hasValue)
+        {
+            if (sscanf(argv[++i], "%dx%d", &options.offscreenWidth, &options.offscreenHeight) != 2
+                || options.offscreenWidth <= 0 || options.offscreenHeight <= 0)
+            {
+                cout << "--offscreen needs a size like 1920x1080" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--msaa" && hasValue)
+        {
+            options.msaaSamples = atoi(argv[++i]);
+        }
+        else if (arg == "--headless" && hasValue)
+        {
+            options.headlessApi = argv[++i];
+            if (options.headlessApi != "egl" && options.headlessApi != "osmesa")
+            {
+                cout << "--headless must be egl or osmesa" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            options.outputPath = argv[++i];
+        }
+        else if (arg == "--frames" && hasValue)
+        {
+            options.frameLimit = atoi(argv[++i]);
+        }
+        else if (arg == "--capture" && hasValue)
+        {
+            options.capturePath = argv[++i];
+        }
+        else if (arg == "--capture-fps" && hasValue)
+        {
+            options.captureFps = atoi(argv[++i]);
+        }
+        else if (arg == "--batch" && hasValue)
+        {
+            options.batchPath = argv[++i];
+        }
+        else if (arg == "--batch-out" && hasValue)
+        {
+            options.batchOutputDir = argv[++i];
+        }
+        else if (arg == "--software")
+        {
+            options.software = true;
+        }
+        else if (arg == "--software-threads" && hasValue)
+        {
+            options.softwareThreads = atoi(argv[++i]);
+        }
+        else if (arg == "--compare" && hasValue)
+        {
+            options.comparePath = argv[++i];
+        }
+        else if (arg == "--path-trace" && hasValue)
+        {
+            options.pathTraceSamples = atoi(argv[++i]);
+            if (options.pathTraceSamples <= 0)
+            {
+                cout << "--path-trace needs a positive sample count" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--path-trace-bounces" && hasValue)
+        {
+            options.pathTraceBounces = atoi(argv[++i]);
+        }
+        else if (arg == "--texture-arrays" && hasValue)
+        {
+            string value = argv[++i];
+            options.textureArraySize = value == "grouped" ? 0 : atoi(value.c_str());
+            if (options.textureArraySize < 0 || (options.textureArraySize == 0 && value != "grouped"))
+            {
+                cout << "--texture-arrays needs grouped or a layer size" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--texture-filter" && hasValue)
+        {
+            string value = argv[++i];
+            if (value == "bilinear")
+                options.textureFilter = 0;
+            else if (value == "trilinear")
+                options.textureFilter = 1;
+            else
+            {
+                options.textureFilter = atoi(value.c_str());
+                if (options.textureFilter < 2)
+                {
+                    cout << "--texture-filter needs bilinear, trilinear or an anisotropy of 2 or more" << endl;
+                    return false;
+                }
+            }
+        }
+        else if (arg == "--texture-budget" && hasValue)
+        {
+            options.textureBudgetMB = (float)atof(argv[++i]);
+            if (options.textureBudgetMB <= 0.0f)
+            {
+                cout << "--texture-budget needs a positive size in MB" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--texture-threads" && hasValue)
+        {
+            options.textureThreads = atoi(argv[++i]);
+        }
+        else if (arg == "--no-texture-dedup")
+        {
+            options.textureDedup = false;
+        }
+        else if (arg == "--texture-rgba")
+        {
+            options.textureRGBA = true;
+        }
+        else if (arg == "--pack-textures" && hasValue)
+        {
+            options.packTexturesDir = argv[++i];
+        }
+        else if (arg == "--compressed-textures" && hasValue)
+        {
+            options.compressedTexturesDir = argv[++i];
+        }
+        else if (arg == "--image-benchmark" && hasValue)
+        {
+            options.imageBenchmarkRepeats = atoi(argv[++i]);
+            if (options.imageBenchmarkRepeats < 1)
+            {
+                cout << "--image-benchmark needs at least one repeat" << endl;
+                return false;
+            }
+        }
+        else if (arg == "--lazy-resources")
+        {
+            options.lazyResources = true;
+        }
+        else if (arg == "--bindless")
+        {
+            options.bindless = true;
+        }
+        else if (arg == "--material-benchmark" && hasValue)
+        {
+            options.materialBenchmarkDraws = atoi(argv[++i]);
+            if (options.materialBenchmarkDraws < 1)
+            {
+                cout << "--material-benchmark needs at least one draw" << endl;
+                return false;
+            }
+        }
+        else
+        {
+            cout << "Unknown or incomplete option: " << arg << endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void AppOptions::resolve()
+{
+    bool batch = !batchPath.empty();
+    bool benchmark = !batch && !benchmarkPath.empty();
+    bool replay = !batch && !benchmark && !replayPath.empty();
+
+    // benchmarks and batches render every frame as fast as possible, with no vsync or frame cap
+    if (batch || benchmark)
+    {
+        onDemand = false;
+        targetFps = 0.0;
+        swapInterval = 0;
+    }
+    if (batch && !capturePath.empty())
+    {
+        cout << "--capture is ignored with --batch" << endl;
+        capturePath.clear();
+    }
+    // the log decides how many steps each frame takes, so every frame is drawn
+    if (replay)
+        onDemand = false;
+
+    // the benchmark compares the bind path against the bindless one
+    if (materialBenchmarkDraws > 0)
+        bindless = true;
+    // the path tracer reads the scene from the software backend's draws
+    if (pathTraceSamples > 0)
+    {
+        software = true;
+        if (outputPath.empty())
+            outputPath = "pathtrace.png";
+    }
+    // the software renderer has no context to present to, only the offscreen image
+    if (software)
+    {
+        if (!headlessApi.empty())
+        {
+            cout << "--headless is ignored with --software, no context is created" << endl;
+            headlessApi.clear();
+        }
+        if (dynamicResolution || gpuProfile || msaaSamples > 1)
+        {
+            cout << "--dynamic-res, --gpu-profile and --msaa are ignored with --software" << endl;
+            dynamicResolution = false;
+            gpuProfile = false;
+            msaaSamples = 0;
+        }
+        swapInterval = -1;
+        if (textureArraySize >= 0)
+        {
+            cout << "--texture-arrays is ignored with --software, it has no array textures" << endl;
+            textureArraySize = -1;
+        }
+        // it has no sampler objects either, textures use their own filter
+        if (textureFilter > 1)
+            cout << "--texture-filter is ignored with --software" << endl;
+        textureFilter = 0;
+        // nor mip levels other than the first
+        if (textureBudgetMB > 0.0f)
+        {
+            cout << "--texture-budget is ignored with --software" << endl;
+            textureBudgetMB = 0.0f;
+        }
+        // nor block compressed formats
+        if (!compressedTexturesDir.empty())
+        {
+            cout << "--compressed-textures is ignored with --software" << endl;
+            compressedTexturesDir.clear();
+        }
+        // nor texture handles
+        if (bindless)
+        {
+            cout << "--bindless is ignored with --software" << endl;
+            bindless = false;
+        }
+    }
+    // the arrays are rebuilt from the files with every layer resident, which streaming can't shrink
+    if (textureBudgetMB > 0.0f && textureArraySize >= 0)
+    {
+        cout << "--texture-arrays is ignored with --texture-budget" << endl;
+        textureArraySize = -1;
+    }
+    // the streamer builds its mips from decoded images, packed files already have theirs
+    if (textureBudgetMB > 0.0f && !compressedTexturesDir.empty())
+    {
+        cout << "--compressed-textures is ignored with --texture-budget" << endl;
+        compressedTexturesDir.clear();
+    }
+    // a texture with a handle can't change its levels any more, which streaming does all the time
+    if (textureBudgetMB > 0.0f && bindless)
+    {
+        cout << "--bindless is ignored with --texture-budget" << endl;
+        bindless = false;
+    }
+    // bindless materials reach every texture already, without resampling them into arrays
+    if (bindless && textureArraySize >= 0)
+    {
+        cout << "--texture-arrays is ignored with --bindless" << endl;
+        textureArraySize = -1;
+    }
+    // textures load one at a time as the scene asks, which leaves the workers nothing to overlap and
+    // the streamer no set of images to budget
+    if (lazyResources && (textureThreads > 0 || textureBudgetMB > 0.0f))
+    {
+        cout << "--texture-threads and --texture-budget are ignored with --lazy-resources" << endl;
+        textureThreads = 0;
+        textureBudgetMB = 0.0f;
+    }
+    // packing and the image benchmark go through every texture file
+    if (lazyResources && (!packTexturesDir.empty() || imageBenchmarkRepeats > 0))
+    {
+        cout << "--lazy-resources is ignored with --pack-textures and --image-benchmark" << endl;
+        lazyResources = false;
+    }
+    // the streamer keeps every decoded image, which the workers hand over in the upload ring
+    if (textureBudgetMB > 0.0f && textureThreads > 0)
+    {
+        cout << "--texture-threads is ignored with --texture-budget" << endl;
+        textureThreads = 0;
+    }
+    if (offscreen())
+    {
+        onDemand = false;
+        // a single image is enough unless something else decides when to stop
+        bool headless = !headlessApi.empty();
+        if (frameLimit == 0 && !benchmark && !batch && !replay
+            && (headless || software || !outputPath.empty() || !comparePath.empty()))
+            frameLimit = 1;
+    }
+    if (msaaSamples > 1 && dynamicResolution)
+    {
+        cout << "--msaa is ignored with --dynamic-res, the upscale can't write into a multisampled target" << endl;
+        msaaSamples = 0;
+    }
+}
+
+bool AppOptions::offscreen() const
+{
+    return !batchPath.empty() || !benchmarkPath.empty() || !headlessApi.empty() || software || offscreenWidth > 0
+        || !outputPath.empty() || !comparePath.empty();
+}
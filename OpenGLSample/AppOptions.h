@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: AppOptions.h                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Command line options that select how the scene is run.                      //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+
+// Settings read from the command line, defaults match the interactive window
+struct AppOptions
+{
+    // --on-demand: only redraw when the camera, lights, toggles or window change
+    bool onDemand = false;
+    // --max-idle <seconds>: in on-demand mode, redraw at least this often
+    double maxIdleSeconds = 0.0;
+    // --sim-rate <hz>: fixed simulation steps per second, independent of the frame rate
+    double simulationHz = 120.0;
+
+    // --fps <hz>: frame rate limit, 0 leaves the loop uncapped
+    double targetFps = 0.0;
+    // --fps-adaptive: while frames keep missing the --fps budget, limit to an even fraction of it instead of stuttering
+    bool adaptiveFps = false;
+    // --vsync <n>: glfwSwapInterval value, -1 keeps the driver default
+    int swapInterval = -1;
+    // --frames-ahead <n>: most frames the CPU may queue before waiting on the GPU, 0 = no limit
+    int maxFramesAhead = 2;
+    // --frame-log <seconds>: print frame time percentiles this often, 0 only prints on exit
+    double frameLogSeconds = 0.0;
+
+    // --dynamic-res: render offscreen at a scale chosen from the measured GPU time
+    bool dynamicResolution = false;
+    // --gpu-budget <ms>: GPU time per frame the dynamic resolution aims for
+    float gpuBudgetMs = 1000.0f / 60.0f;
+    // --min-scale <0..1>: lowest render scale dynamic resolution may pick
+    float minScale = 0.5f;
+    // --stats: show live statistics in the window title
+    bool showStats = false;
+
+    // --gpu-profile: time passes and scene objects on the GPU and draw the results as bars
+    bool gpuProfile = false;
+    // --trace <file>: write the profiled scopes as a Chrome trace when the program exits
+    std::string tracePath;
+
+    // --render-stats <file>: stream per-frame draw, bind and upload counters, .json for JSON lines, else CSV
+    std::string renderStatsPath;
+
+    // --benchmark <file>: play a scripted camera path offscreen for a fixed number of frames, then exit
+    std::string benchmarkPath;
+    // --benchmark-out <file>: where the benchmark results are written
+    std::string benchmarkResultsPath = "benchmark_results.json";
+
+    // --record <file>: log every input event and polled key state for later replay
+    std::string recordPath;
+    // --replay <file>: play a recorded log instead of live input, with its fixed time step
+    std::string replayPath;
+
+    // --offscreen <W>x<H>: draw into a framebuffer of this size behind a hidden window
+    int offscreenWidth = 0;
+    int offscreenHeight = 0;
+    // --msaa <samples>: multisampling for the offscreen framebuffer
+    int msaaSamples = 0;
+    // --headless <egl|osmesa>: no window system at all, the context comes from EGL or OSMesa (implies --offscreen)
+    std::string headlessApi;
+    // --output <file>: save the last offscreen frame as .png, anything else is written as raw RGBA
+    std::string outputPath;
+    // --frames <count>: exit after this many frames, 0 runs until the window closes
+    int frameLimit = 0;
+
+    // --capture <file>: record every frame, .y4m writes a video stream, anything else a PNG sequence
+    std::string capturePath;
+    // --capture-fps <rate>: frame rate written into the Y4M header
+    int captureFps = 60;
+
+    // --batch <file>: render one image per camera pose in the list offscreen, then exit
+    std::string batchPath;
+    // --batch-out <folder>: folder the batch images are written to, created if missing
+    std::string batchOutputDir = "batch";
+
+    // --software: render on the CPU instead of the GPU, without a window (implies --offscreen)
+    bool software = false;
+    // --software-threads <n>: rasterizer threads, 0 uses every core
+    int softwareThreads = 0;
+    // --compare <file>: compare the last offscreen frame against a reference PNG and write a diff image
+    std::string comparePath;
+    // --path-trace <samples>: path trace the last frame at this many samples per pixel instead (implies --software)
+    int pathTraceSamples = 0;
+    // --path-trace-bounces <n>: longest path after the camera ray
+    int pathTraceBounces = 4;
+
+    // --texture-arrays <grouped|size>: material textures as texture array layers, grouped by their
+    // own power of two size, or all resampled to size x size; -1 keeps separate textures, 0 is grouped
+    int textureArraySize = -1;
+    // --texture-filter <bilinear|trilinear|N>: how material textures are minified; bilinear keeps each texture's
+    // own GL_LINEAR filter, trilinear samples the mipmaps through sampler objects, N >= 2 adds N x anisotropic
+    int textureFilter = 1;
+    // --texture-budget <MB>: stream material texture mips by screen size within this much GPU memory, 0 keeps all resident
+    float textureBudgetMB = 0.0f;
+    // --texture-threads <n>: decode textures on this many workers and upload them through a pixel buffer ring, 0 loads them on the main thread
+    int textureThreads = 0;
+    // --no-texture-dedup: give every loaded image its own full size texture, even when identical or a flat color
+    bool textureDedup = true;
+    // --texture-rgba: expand textures without alpha to RGBA in the same pass that flips them
+    bool textureRGBA = false;
+    // --image-benchmark <n>: time the flip and conversion passes on every texture file n times, then exit
+    int imageBenchmarkRepeats = 0;
+    // --pack-textures <dir>: encode every texture with its mip chain into a block compressed .btex file in dir, then exit
+    std::string packTexturesDir;
+    // --compressed-textures <dir>: load textures from the .btex files packed into dir, decoding the images without one
+    std::string compressedTexturesDir;
+    // --lazy-resources: create meshes and textures when the scene first asks for them instead of all at startup,
+    // one texture at a time and without dedup, which needs every image
+    bool lazyResources = false;
+    // --bindless: with GL_ARB_bindless_texture, draws pick their material from a table of resident texture handles instead of binding them
+    bool bindless = false;
+    // --material-benchmark <draws>: time submitting this many draws with unique materials, bound per draw and bindless, then exit (implies --bindless)
+    int materialBenchmarkDraws = 0;
+
+    // Settles options that conflict with each other or with the mode, printing the ones ignored;
+    // call once after parseOptions
+    void resolve();
+    // True when frames go into an offscreen target instead of the window
+    bool offscreen() const;
+};
+
+// Fills options from argv, prints usage and returns false on a bad argument
+bool parseOptions(int argc, char* argv[], AppOptions& options);
@@ -0,0 +1,310 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: Benchmark.cpp                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Scripted benchmark run. Reads a camera path with light moves and toggles   //
+// from a text file, gives the scene state for every frame of a fixed length run, and      //
+// writes frame time statistics and render counters when the run is over.                  //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Value at the given fraction of a sorted list
+    float percentile(const vector<float>& sorted, double fraction)
+    {
+        size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    // Uniform Catmull-Rom between p1 and p2
+    template <typename T>
+    T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float u)
+    {
+        float u2 = u * u;
+        float u3 = u2 * u;
+        return 0.5f * ((2.0f * p1) + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2
+            + (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+    }
+
+    // Index of the key that starts the segment containing time, keys sorted by time
+    template <typename Key>
+    size_t segmentAt(const vector<Key>& keys, float time)
+    {
+        size_t index = 0;
+        while (index + 2 < keys.size() && keys[index + 1].time <= time)
+            ++index;
+        return index;
+    }
+
+    template <typename Key>
+    bool byTime(const Key& a, const Key& b)
+    {
+        return a.time < b.time;
+    }
+}
+
+/*
+  Path file format, one entry per line, '#' starts a comment:
+
+    frames 600                      measured frames
+    warmup 30                       frames rendered first and not measured
+    resolution 1280 720             offscreen render size
+    interpolation spline|linear     camera interpolation between keys
+    camera <t> <x y z> <yaw> <pitch>
+    light <t> <1|2> <x y z>         point light position, linear between keys
+    toggle <t> perspective|flashlight|skybox
+
+  Times are in path seconds; the path is stretched over the measured frames so every run
+  visits exactly the same poses no matter how fast the machine is.
+*/
+bool Benchmark::load(const string& path)
+{
+    ifstream file(path);
+    if (!file.is_open())
+    {
+        cout << "Could not open benchmark path " << path << endl;
+        return false;
+    }
+    pathFile = path;
+
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line))
+    {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != string::npos)
+            line.erase(comment);
+
+        istringstream in(line);
+        string command;
+        if (!(in >> command))
+            continue;
+
+        bool ok = true;
+        if (command == "frames")
+            ok = static_cast<bool>(in >> frames) && frames > 0;
+        else if (command == "warmup")
+            ok = static_cast<bool>(in >> warmupFrames) && warmupFrames >= 0;
+        else if (command == "resolution")
+            ok = static_cast<bool>(in >> width >> height) && width > 0 && height > 0;
+        else if (command == "interpolation")
+        {
+            string mode;
+            ok = static_cast<bool>(in >> mode) && (mode == "spline" || mode == "linear");
+            spline = (mode == "spline");
+        }
+        else if (command == "camera")
+        {
+            CameraKey key;
+            ok = static_cast<bool>(in >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch);
+            if (ok)
+                cameraKeys.push_back(key);
+        }
+        else if (command == "light")
+        {
+            LightKey key;
+            int light = 0;
+            ok = static_cast<bool>(in >> key.time >> light >> key.position.x >> key.position.y >> key.position.z)
+                && (light == 1 || light == 2);
+            if (ok)
+                lightKeys[light - 1].push_back(key);
+        }
+        else if (command == "toggle")
+        {
+            Toggle toggle;
+            ok = static_cast<bool>(in >> toggle.time >> toggle.name)
+                && (toggle.name == "perspective" || toggle.name == "flashlight" || toggle.name == "skybox");
+            if (ok)
+                toggles.push_back(toggle);
+        }
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            cout << path << ":" << lineNumber << ": can't read '" << line << "'" << endl;
+            return false;
+        }
+    }
+
+    if (cameraKeys.empty())
+    {
+        cout << path << ": needs at least one camera key" << endl;
+        return false;
+    }
+    stable_sort(cameraKeys.begin(), cameraKeys.end(), byTime<CameraKey>);
+    stable_sort(lightKeys[0].begin(), lightKeys[0].end(), byTime<LightKey>);
+    stable_sort(lightKeys[1].begin(), lightKeys[1].end(), byTime<LightKey>);
+    stable_sort(toggles.begin(), toggles.end(), byTime<Toggle>);
+
+    frameTimes.reserve(frames);
+    return true;
+}
+
+float Benchmark::duration() const
+{
+    float end = cameraKeys.back().time;
+    for (const auto& keys : lightKeys)
+        if (!keys.empty())
+            end = max(end, keys.back().time);
+    if (!toggles.empty())
+        end = max(end, toggles.back().time);
+    return end;
+}
+
+void Benchmark::cameraAt(float time, glm::vec3& position, float& yaw, float& pitch) const
+{
+    const CameraKey& first = cameraKeys.front();
+    const CameraKey& last = cameraKeys.back();
+    if (cameraKeys.size() == 1 || time <= first.time)
+    {
+        position = first.position;
+        yaw = first.yaw;
+        pitch = first.pitch;
+        return;
+    }
+    if (time >= last.time)
+    {
+        position = last.position;
+        yaw = last.yaw;
+        pitch = last.pitch;
+        return;
+    }
+
+    size_t i = segmentAt(cameraKeys, time);
+    const CameraKey& k1 = cameraKeys[i];
+    const CameraKey& k2 = cameraKeys[i + 1];
+    float span = k2.time - k1.time;
+    float u = (span > 0.0f) ? (time - k1.time) / span : 1.0f;
+
+    if (!spline)
+    {
+        position = glm::mix(k1.position, k2.position, u);
+        yaw = k1.yaw + (k2.yaw - k1.yaw) * u;
+        pitch = k1.pitch + (k2.pitch - k1.pitch) * u;
+        return;
+    }
+
+    // the end keys are repeated so the curve starts and stops on them
+    const CameraKey& k0 = cameraKeys[(i > 0) ? i - 1 : i];
+    const CameraKey& k3 = cameraKeys[min(i + 2, cameraKeys.size() - 1)];
+    position = catmullRom(k0.position, k1.position, k2.position, k3.position, u);
+    yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, u);
+    pitch = glm::clamp(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, u), -89.0f, 89.0f);
+}
+
+glm::vec3 Benchmark::lightAt(const vector<LightKey>& keys, float time)
+{
+    if (keys.size() == 1 || time <= keys.front().time)
+        return keys.front().position;
+    if (time >= keys.back().time)
+        return keys.back().position;
+
+    size_t i = segmentAt(keys, time);
+    float span = keys[i + 1].time - keys[i].time;
+    float u = (span > 0.0f) ? (time - keys[i].time) / span : 1.0f;
+    return glm::mix(keys[i].position, keys[i + 1].position, u);
+}
+
+BenchmarkFrame Benchmark::nextFrame()
+{
+    // warm-up frames sit at time 0, measured frames spread evenly over the path
+    int measured = frameIndex - warmupFrames;
+    float time = 0.0f;
+    if (measured > 0 && frames > 1)
+        time = duration() * (float)measured / (float)(frames - 1);
+    ++frameIndex;
+
+    BenchmarkFrame frame;
+    cameraAt(time, frame.cameraPosition, frame.yaw, frame.pitch);
+    for (int light = 0; light < 2; ++light)
+    {
+        frame.moveLight[light] = !lightKeys[light].empty();
+        if (frame.moveLight[light])
+            frame.lightPositions[light] = lightAt(lightKeys[light], time);
+    }
+
+    // toggles fire once, on the first measured frame at or past their time
+    if (measured >= 0)
+    {
+        for (const Toggle& toggle : toggles)
+            if (toggle.time <= time && toggle.time > lastTime)
+                frame.toggles.push_back(toggle.name);
+        lastTime = time;
+    }
+    return frame;
+}
+
+void Benchmark::recordFrame(double frameMs, const FrameStats& counters)
+{
+    // the frame just recorded is frameIndex - 1
+    if (frameIndex <= warmupFrames)
+        return;
+
+    frameTimes.push_back((float)frameMs);
+    measuredMs += frameMs;
+    totals.drawCalls += counters.drawCalls;
+    totals.triangles += counters.triangles;
+    totals.vertices += counters.vertices;
+    totals.programBinds += counters.programBinds;
+    totals.vaoBinds += counters.vaoBinds;
+    totals.textureBinds += counters.textureBinds;
+    totals.uniformCalls += counters.uniformCalls;
+    totals.bufferBytes += counters.bufferBytes;
+    totals.textureBytes += counters.textureBytes;
+}
+
+bool Benchmark::writeResults(const string& path) const
+{
+    if (frameTimes.empty())
+    {
+        cout << "Benchmark recorded no frames" << endl;
+        return false;
+    }
+
+    vector<float> sorted = frameTimes;
+    sort(sorted.begin(), sorted.end());
+    double n = (double)frameTimes.size();
+    double averageMs = measuredMs / n;
+
+    cout << "Benchmark: " << frameTimes.size() << " frames at " << width << "x" << height << ", "
+        << 1000.0 / averageMs << " fps average, frame time p50 " << percentile(sorted, 0.50) << "ms, p95 "
+        << percentile(sorted, 0.95) << "ms, p99 " << percentile(sorted, 0.99) << "ms, max " << sorted.back() << "ms" << endl;
+
+    ofstream file(path);
+    if (!file.is_open())
+    {
+        cout << "Could not write benchmark results to " << path << endl;
+        return false;
+    }
+    file << "{\n"
+        << "  \"path\": \"" << pathFile << "\",\n"
+        << "  \"width\": " << width << ",\n"
+        << "  \"height\": " << height << ",\n"
+        << "  \"frames\": " << frameTimes.size() << ",\n"
+        << "  \"warmup_frames\": " << warmupFrames << ",\n"
+        << "  \"total_ms\": " << measuredMs << ",\n"
+        << "  \"fps\": " << 1000.0 / averageMs << ",\n"
+        << "  \"frame_ms\": {\"mean\": " << averageMs << ", \"min\": " << sorted.front()
+        << ", \"p50\": " << percentile(sorted, 0.50) << ", \"p95\": " << percentile(sorted, 0.95)
+        << ", \"p99\": " << percentile(sorted, 0.99) << ", \"max\": " << sorted.back() << "},\n"
+        << "  \"per_frame\": {\"draw_calls\": " << totals.drawCalls / n << ", \"triangles\": " << totals.triangles / n
+        << ", \"vertices\": " << totals.vertices / n << ", \"program_binds\": " << totals.programBinds / n
+        << ", \"vao_binds\": " << totals.vaoBinds / n << ", \"texture_binds\": " << totals.textureBinds / n
+        << ", \"uniform_calls\": " << totals.uniformCalls / n << ", \"buffer_bytes\": " << totals.bufferBytes / n
+        << ", \"texture_bytes\": " << totals.textureBytes / n << "},\n"
+        << "  \"frame_times_ms\": [";
+    for (size_t i = 0; i < frameTimes.size(); ++i)
+        file << (i ? "," : "") << frameTimes[i];
+    file << "]\n}\n";
+    cout << "Wrote benchmark results to " << path << endl;
+    return true;
+}
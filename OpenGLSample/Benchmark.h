@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: Benchmark.h                                                                        //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Scripted benchmark run. Reads a camera path with light moves and toggles   //
+// from a text file, gives the scene state for every frame of a fixed length run, and      //
+// writes frame time statistics and render counters when the run is over.                  //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "RenderStats.h"
+
+// Scene state the benchmark wants for one frame
+struct BenchmarkFrame
+{
+    glm::vec3 cameraPosition;
+    float yaw;
+    float pitch;
+    bool moveLight[2];
+    glm::vec3 lightPositions[2];
+    std::vector<std::string> toggles;  // "perspective", "flashlight" or "skybox", flipped this frame
+};
+
+// Plays a keyframed camera path for a fixed number of frames and measures each frame
+class Benchmark
+{
+public:
+    // Settings, the path file can override all of them
+    int frames = 600;
+    int warmupFrames = 30;
+    int width = 1280;
+    int height = 720;
+    bool spline = true;  // Catmull-Rom through the camera keys, linear otherwise
+
+    // Parses the path file, prints the problem and returns false if it is unusable
+    bool load(const std::string& path);
+
+    // Frames rendered in total, warm-up included
+    int totalFrames() const { return warmupFrames + frames; }
+    bool finished() const { return frameIndex >= totalFrames(); }
+    // State for the next frame; warm-up frames hold the first pose
+    BenchmarkFrame nextFrame();
+    // Adds the frame that just finished, measured from the end of the previous one
+    void recordFrame(double frameMs, const FrameStats& counters);
+
+    // Writes the results as JSON and prints a short summary
+    bool writeResults(const std::string& path) const;
+
+private:
+    struct CameraKey
+    {
+        float time;
+        glm::vec3 position;
+        float yaw;
+        float pitch;
+    };
+    struct LightKey
+    {
+        float time;
+        glm::vec3 position;
+    };
+    struct Toggle
+    {
+        float time;
+        std::string name;
+    };
+
+    float duration() const;
+    void cameraAt(float time, glm::vec3& position, float& yaw, float& pitch) const;
+    static glm::vec3 lightAt(const std::vector<LightKey>& keys, float time);
+
+    std::string pathFile;
+    std::vector<CameraKey> cameraKeys;
+    std::vector<LightKey> lightKeys[2];
+    std::vector<Toggle> toggles;
+
+    int frameIndex = 0;
+    float lastTime = -1.0f;
+
+    std::vector<float> frameTimes;  // measured frames only, in milliseconds
+    FrameStats totals;
+    double measuredMs = 0.0;
+};
@@ -0,0 +1,137 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: BindlessMaterials.cpp                                                              //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Material table of resident texture handles for GL_ARB_bindless_texture, so //
+// a draw switches material by setting one index instead of binding its textures.          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BindlessMaterials.h"
+#include "RenderStats.h"
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std; // Standard namespace
+
+namespace
+{
+    void putHandle(uint32_t* words, GLuint64 handle)
+    {
+        words[0] = (uint32_t)handle;
+        words[1] = (uint32_t)(handle >> 32);
+    }
+
+    uint32_t floatBits(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+bool BindlessMaterials::load(GLADloadproc getProc)
+{
+    getTextureHandle = (GetTextureHandleProc)getProc("glGetTextureHandleARB");
+    getTextureSamplerHandle = (GetTextureSamplerHandleProc)getProc("glGetTextureSamplerHandleARB");
+    makeResident = (HandleResidencyProc)getProc("glMakeTextureHandleResidentARB");
+    makeNonResident = (HandleResidencyProc)getProc("glMakeTextureHandleNonResidentARB");
+    return getTextureHandle && getTextureSamplerHandle && makeResident && makeNonResident;
+}
+
+GLuint64 BindlessMaterials::handleFor(GLuint texture, const TextureSamplers* samplers)
+{
+    if (texture == 0)
+        return 0;
+    auto found = handles.find(texture);
+    if (found != handles.end())
+        return found->second;
+    // textures that failed to load have no image, so GL refuses them a handle and they stay 0
+    GLuint sampler = samplers ? samplers->samplerFor(texture) : 0;
+    GLuint64 handle = sampler != 0 ? getTextureSamplerHandle(texture, sampler) : getTextureHandle(texture);
+    if (handle != 0)
+        makeResident(handle);
+    handles[texture] = handle;
+    return handle;
+}
+
+void BindlessMaterials::upload(const Materials& materials, const TextureSamplers* samplers)
+{
+    vector<uint32_t> table(materials.size() * TEXELS_PER_MATERIAL * 4, 0);
+    for (size_t i = 0; i < materials.size(); ++i)
+    {
+        const Material& material = materials.get((Materials::Id)i);
+        uint32_t* words = &table[i * TEXELS_PER_MATERIAL * 4];
+        putHandle(words, handleFor(material.diffuse, samplers));
+        putHandle(words + 2, handleFor(material.specular, samplers));
+        putHandle(words + 4, handleFor(material.overlay, samplers));
+        words[6] = floatBits(material.shininess);
+        words[8] = floatBits(material.uvScale.x);
+        words[9] = floatBits(material.uvScale.y);
+    }
+
+    if (tableBuffer == 0)
+    {
+        glGenBuffers(1, &tableBuffer);
+        glGenTextures(1, &tableTexture);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, tableBuffer);
+    RenderStats::bufferData(GL_TEXTURE_BUFFER, table.size() * sizeof(uint32_t), table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0 + TABLE_UNIT);
+    RenderStats::bindTexture(GL_TEXTURE_BUFFER, tableTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, tableBuffer);
+    glActiveTexture(GL_TEXTURE0);
+    materialCount = materials.size();
+    currentIndex = -1;
+}
+
+void BindlessMaterials::destroy()
+{
+    for (auto& handle : handles)
+    {
+        if (handle.second != 0)
+            makeNonResident(handle.second);
+    }
+    handles.clear();
+    if (tableBuffer != 0)
+    {
+        glDeleteTextures(1, &tableTexture);
+        glDeleteBuffers(1, &tableBuffer);
+        tableTexture = 0;
+        tableBuffer = 0;
+    }
+    materialCount = 0;
+    currentIndex = -1;
+}
+
+void BindlessMaterials::bind(const Shader& shader)
+{
+    glActiveTexture(GL_TEXTURE0 + TABLE_UNIT);
+    RenderStats::bindTexture(GL_TEXTURE_BUFFER, tableTexture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("materialTable", TABLE_UNIT);
+    // the index may have been left by another program
+    currentIndex = -1;
+}
+
+void BindlessMaterials::use(const Shader& shader, Materials::Id id)
+{
+    ++useRequests;
+    if (currentIndex != id)
+    {
+        shader.setInt("materialIndex", id);
+        currentIndex = id;
+        ++indexChanges;
+    }
+}
+
+void BindlessMaterials::printStats() const
+{
+    if (tableBuffer == 0)
+        return;
+    size_t resident = 0;
+    for (const auto& handle : handles)
+        resident += handle.second != 0 ? 1 : 0;
+    cout << "Bindless materials: " << materialCount << " materials over " << resident << " resident textures, "
+        << useRequests << " material switches became " << indexChanges << " index uniform changes" << endl;
+}
@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: BindlessMaterials.h                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Material table of resident texture handles for GL_ARB_bindless_texture, so //
+// a draw switches material by setting one index instead of binding its textures.          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <unordered_map>
+#include "Materials.h"
+#include "TextureSamplers.h"
+#include "shader.h"
+
+// The table is a buffer texture of three RGBA32UI texels per material, read by
+// 6.multiple_lights_bindless.fs: the diffuse and specular handles, the overlay handle and the
+// shininess, the UV scale. Handles freeze their textures, so nothing may change them after
+class BindlessMaterials
+{
+public:
+    typedef GLuint64 (APIENTRYP GetTextureHandleProc)(GLuint texture);
+    typedef GLuint64 (APIENTRYP GetTextureSamplerHandleProc)(GLuint texture, GLuint sampler);
+    typedef void (APIENTRYP HandleResidencyProc)(GLuint64 handle);
+
+    // Unit of the table, past the three material units
+    static const int TABLE_UNIT = 3;
+    static const int TEXELS_PER_MATERIAL = 3;
+
+    // Fetches the GL_ARB_bindless_texture entry points, false when any is missing
+    bool load(GLADloadproc getProc);
+    // Makes the textures of every material resident and uploads the table, replacing the last
+    // one. With samplers, each handle samples through the sampler its texture would be bound with
+    void upload(const Materials& materials, const TextureSamplers* samplers);
+    void destroy();
+
+    // Points the lit shader at the table; the shader must be in use
+    void bind(const Shader& shader);
+    // Stands in for binding the material's textures and setting its shininess and UV scale
+    void use(const Shader& shader, Materials::Id id);
+
+    void printStats() const;
+
+private:
+    // Resident handle of the texture, 0 for no texture or one that can't have a handle
+    GLuint64 handleFor(GLuint texture, const TextureSamplers* samplers);
+
+    GetTextureHandleProc getTextureHandle = nullptr;
+    GetTextureSamplerHandleProc getTextureSamplerHandle = nullptr;
+    HandleResidencyProc makeResident = nullptr;
+    HandleResidencyProc makeNonResident = nullptr;
+
+    std::unordered_map<GLuint, GLuint64> handles;
+    GLuint tableBuffer = 0;
+    GLuint tableTexture = 0;
+    size_t materialCount = 0;
+    int currentIndex = -1;
+
+    uint64_t useRequests = 0;
+    uint64_t indexChanges = 0;
+};
@@ -0,0 +1,488 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: BlockCompression.cpp                                                               //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: BC1, BC3 and BC4 block compression of RGBA images and their mip chains,     //
+// the matching decoders for measuring quality, and the .btex container the packed         //
+// textures are stored in and uploaded from.                                                //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BlockCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+using namespace std; // Standard namespace
+
+/*
+  .btex layout, little endian:
+
+    header:  "BTEX" | uint32 version | uint32 format | uint32 gray | uint32 level count
+    level:   uint32 width | uint32 height | uint32 byte count | blocks
+
+  Blocks are in rows from the bottom of the image, as uploaded.
+*/
+namespace
+{
+    const char MAGIC[4] = { 'B', 'T', 'E', 'X' };
+    const uint32_t VERSION = 1;
+    // More levels than any texture that fits in GL can have
+    const uint32_t MAX_LEVELS = 32;
+
+    template <typename T>
+    void put(ofstream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool get(ifstream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    uint16_t pack565(const float color[3])
+    {
+        int r = (int)floor(min(max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+        int g = (int)floor(min(max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+        int b = (int)floor(min(max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void unpack565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31;
+        int g = (packed >> 5) & 63;
+        int b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // The four colors of a block in four color mode (color0 > color1)
+    void bc1Palette(uint16_t color0, uint16_t color1, int palette[4][3])
+    {
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    // Picks the closest palette color for every texel, returns the squared error. The
+    // endpoints are put in four color order, so equal ones give a single color block
+    int bc1Indices(const uint8_t texels[16][4], uint16_t& color0, uint16_t& color1, uint32_t& indices)
+    {
+        if (color0 < color1)
+            swap(color0, color1);
+        int palette[4][3];
+        bc1Palette(color0, color1, palette);
+        int count = color0 == color1 ? 1 : 4;
+
+        int error = 0;
+        indices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int bestError = INT32_MAX;
+            for (int p = 0; p < count; ++p)
+            {
+                int dr = texels[i][0] - palette[p][0];
+                int dg = texels[i][1] - palette[p][1];
+                int db = texels[i][2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestError)
+                {
+                    bestError = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+            error += bestError;
+        }
+        return error;
+    }
+
+    // Value i of an 8 value BC4 block (value0 > value1)
+    int bc4Value(int value0, int value1, int index)
+    {
+        if (index == 0)
+            return value0;
+        if (index == 1)
+            return value1;
+        return ((8 - index) * value0 + (index - 1) * value1 + 3) / 7;
+    }
+}
+
+uint64_t CompressedImage::bytes() const
+{
+    uint64_t total = 0;
+    for (const Level& level : levels)
+        total += level.blocks.size();
+    return total;
+}
+
+size_t BlockCompression::imageBytes(BlockFormat format, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+}
+
+// Endpoints at the extremes of the colors along their principal axis, then moved to the
+// least squares fit of the chosen indices when that lowers the error
+void BlockCompression::encodeBC1(const uint8_t texels[16][4], uint8_t* block)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+            mean[c] += texels[i][c];
+    }
+    for (int c = 0; c < 3; ++c)
+        mean[c] /= 16.0f;
+
+    float covariance[3][3] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[3] = { texels[i][0] - mean[0], texels[i][1] - mean[1], texels[i][2] - mean[2] };
+        for (int a = 0; a < 3; ++a)
+        {
+            for (int b = 0; b < 3; ++b)
+                covariance[a][b] += d[a] * d[b];
+        }
+    }
+
+    // power iteration, starting on the gray axis
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration)
+    {
+        float next[3];
+        for (int a = 0; a < 3; ++a)
+            next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+        float largest = max(fabs(next[0]), max(fabs(next[1]), fabs(next[2])));
+        if (largest < 1e-6f)
+            break;
+        for (int a = 0; a < 3; ++a)
+            axis[a] = next[a] / largest;
+    }
+    float length = sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (int a = 0; a < 3; ++a)
+        axis[a] /= length;
+
+    float lowest = 0.0f;
+    float highest = 0.0f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2];
+        lowest = min(lowest, t);
+        highest = max(highest, t);
+    }
+    float high[3], low[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        high[c] = mean[c] + axis[c] * highest;
+        low[c] = mean[c] + axis[c] * lowest;
+    }
+
+    uint16_t color0 = pack565(high);
+    uint16_t color1 = pack565(low);
+    uint32_t indices;
+    int error = bc1Indices(texels, color0, color1, indices);
+
+    // least squares endpoints for these indices: texel = alpha * color0 + beta * color1
+    if (color0 != color1 && error > 0)
+    {
+        const float WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        float ax[3] = {}, bx[3] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float alpha = WEIGHTS[(indices >> (2 * i)) & 3];
+            float beta = 1.0f - alpha;
+            aa += alpha * alpha;
+            bb += beta * beta;
+            ab += alpha * beta;
+            for (int c = 0; c < 3; ++c)
+            {
+                ax[c] += alpha * texels[i][c];
+                bx[c] += beta * texels[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (fabs(determinant) > 1e-6f)
+        {
+            float fitted0[3], fitted1[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                fitted0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+                fitted1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+            }
+            uint16_t refined0 = pack565(fitted0);
+            uint16_t refined1 = pack565(fitted1);
+            uint32_t refinedIndices;
+            if (bc1Indices(texels, refined0, refined1, refinedIndices) < error)
+            {
+                color0 = refined0;
+                color1 = refined1;
+                indices = refinedIndices;
+            }
+        }
+    }
+
+    block[0] = (uint8_t)(color0 & 0xFF);
+    block[1] = (uint8_t)(color0 >> 8);
+    block[2] = (uint8_t)(color1 & 0xFF);
+    block[3] = (uint8_t)(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+        block[4 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+// The block's range in the 8 value mode, each value rounded to the nearest step
+void BlockCompression::encodeBC4(const uint8_t values[16], uint8_t* block)
+{
+    int value0 = *max_element(values, values + 16);
+    int value1 = *min_element(values, values + 16);
+    block[0] = (uint8_t)value0;
+    block[1] = (uint8_t)value1;
+
+    uint64_t indices = 0;
+    if (value0 != value1)
+    {
+        int palette[8];
+        for (int p = 0; p < 8; ++p)
+            palette[p] = bc4Value(value0, value1, p);
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            for (int p = 1; p < 8; ++p)
+            {
+                if (abs(values[i] - palette[p]) < abs(values[i] - palette[best]))
+                    best = p;
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+void BlockCompression::encodeRows(BlockFormat format, const uint8_t* rgba, int width, int height, int firstRow, int endRow,
+    uint8_t* blocks)
+{
+    int blocksWide = (width + 3) / 4;
+    int bytes = blockBytes(format);
+    for (int blockY = firstRow; blockY < endRow; ++blockY)
+    {
+        for (int blockX = 0; blockX < blocksWide; ++blockX)
+        {
+            uint8_t texels[16][4];
+            for (int i = 0; i < 16; ++i)
+            {
+                int x = min(blockX * 4 + i % 4, width - 1);
+                int y = min(blockY * 4 + i / 4, height - 1);
+                memcpy(texels[i], rgba + ((size_t)y * width + x) * 4, 4);
+            }
+
+            uint8_t* block = blocks + ((size_t)blockY * blocksWide + blockX) * bytes;
+            if (format == BlockFormat::BC1)
+                encodeBC1(texels, block);
+            else if (format == BlockFormat::BC3)
+            {
+                uint8_t alpha[16];
+                for (int i = 0; i < 16; ++i)
+                    alpha[i] = texels[i][3];
+                encodeBC4(alpha, block);
+                encodeBC1(texels, block + 8);
+            }
+            else
+            {
+                // gray images: the mean of red, green and blue
+                uint8_t values[16];
+                for (int i = 0; i < 16; ++i)
+                    values[i] = (uint8_t)((texels[i][0] + texels[i][1] + texels[i][2] + 1) / 3);
+                encodeBC4(values, block);
+            }
+        }
+    }
+}
+
+void BlockCompression::decodeBC1(const uint8_t* block, uint8_t texels[16][4])
+{
+    uint16_t color0 = (uint16_t)(block[0] | (block[1] << 8));
+    uint16_t color1 = (uint16_t)(block[2] | (block[3] << 8));
+    int palette[4][3];
+    bc1Palette(color0, color1, palette);
+    if (color0 <= color1)
+    {
+        // three color mode, the fourth is black
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+    for (int i = 0; i < 16; ++i)
+    {
+        int index = (indices >> (2 * i)) & 3;
+        for (int c = 0; c < 3; ++c)
+            texels[i][c] = (uint8_t)palette[index][c];
+        texels[i][3] = 255;
+    }
+}
+
+void BlockCompression::decodeBC4(const uint8_t* block, uint8_t values[16])
+{
+    int value0 = block[0];
+    int value1 = block[1];
+    int palette[8];
+    if (value0 > value1)
+    {
+        for (int p = 0; p < 8; ++p)
+            palette[p] = bc4Value(value0, value1, p);
+    }
+    else
+    {
+        palette[0] = value0;
+        palette[1] = value1;
+        for (int p = 2; p < 6; ++p)
+            palette[p] = ((6 - p) * value0 + (p - 1) * value1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+        indices |= (uint64_t)block[2 + i] << (8 * i);
+    for (int i = 0; i < 16; ++i)
+        values[i] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+}
+
+void BlockCompression::decode(BlockFormat format, const uint8_t* blocks, int width, int height, uint8_t* rgba)
+{
+    int blocksWide = (width + 3) / 4;
+    int blocksHigh = (height + 3) / 4;
+    int bytes = blockBytes(format);
+    for (int blockY = 0; blockY < blocksHigh; ++blockY)
+    {
+        for (int blockX = 0; blockX < blocksWide; ++blockX)
+        {
+            const uint8_t* block = blocks + ((size_t)blockY * blocksWide + blockX) * bytes;
+            uint8_t texels[16][4];
+            if (format == BlockFormat::BC1)
+                decodeBC1(block, texels);
+            else if (format == BlockFormat::BC3)
+            {
+                uint8_t alpha[16];
+                decodeBC4(block, alpha);
+                decodeBC1(block + 8, texels);
+                for (int i = 0; i < 16; ++i)
+                    texels[i][3] = alpha[i];
+            }
+            else
+            {
+                uint8_t values[16];
+                decodeBC4(block, values);
+                for (int i = 0; i < 16; ++i)
+                {
+                    texels[i][0] = texels[i][1] = texels[i][2] = values[i];
+                    texels[i][3] = 255;
+                }
+            }
+
+            for (int i = 0; i < 16; ++i)
+            {
+                int x = blockX * 4 + i % 4;
+                int y = blockY * 4 + i / 4;
+                if (x < width && y < height)
+                    memcpy(rgba + ((size_t)y * width + x) * 4, texels[i], 4);
+            }
+        }
+    }
+}
+
+double BlockCompression::psnr(BlockFormat format, const uint8_t* original, const uint8_t* decoded, int width, int height)
+{
+    int channels = format == BlockFormat::BC3 ? 4 : 3;
+    double squaredError = 0.0;
+    size_t texels = (size_t)width * height;
+    for (size_t i = 0; i < texels; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            double difference = original[i * 4 + c] - decoded[i * 4 + c];
+            squaredError += difference * difference;
+        }
+    }
+    double meanSquaredError = squaredError / ((double)texels * channels);
+    if (meanSquaredError <= 0.0)
+        return 99.0;
+    return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+bool BlockCompression::write(const string& path, const CompressedImage& image)
+{
+    ofstream file(path, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open())
+    {
+        cout << "Could not write packed texture " << path << endl;
+        return false;
+    }
+    file.write(MAGIC, sizeof(MAGIC));
+    put(file, VERSION);
+    put(file, (uint32_t)image.format);
+    put(file, (uint32_t)(image.gray ? 1 : 0));
+    put(file, (uint32_t)image.levels.size());
+    for (const CompressedImage::Level& level : image.levels)
+    {
+        put(file, (uint32_t)level.width);
+        put(file, (uint32_t)level.height);
+        put(file, (uint32_t)level.blocks.size());
+        file.write(reinterpret_cast<const char*>(level.blocks.data()), level.blocks.size());
+    }
+    return static_cast<bool>(file);
+}
+
+bool BlockCompression::read(const string& path, CompressedImage& image)
+{
+    ifstream file(path, ios::in | ios::binary);
+    if (!file.is_open())
+    {
+        cout << "Could not open packed texture " << path << endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0, format = 0, gray = 0, levelCount = 0;
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || !get(file, version)
+        || version != VERSION || !get(file, format) || !get(file, gray) || !get(file, levelCount)
+        || (format != (uint32_t)BlockFormat::BC1 && format != (uint32_t)BlockFormat::BC3 && format != (uint32_t)BlockFormat::BC4)
+        || levelCount == 0 || levelCount > MAX_LEVELS)
+    {
+        cout << path << " is not a version " << VERSION << " packed texture" << endl;
+        return false;
+    }
+    image.format = (BlockFormat)format;
+    image.gray = gray != 0;
+    image.levels.resize(levelCount);
+    for (CompressedImage::Level& level : image.levels)
+    {
+        uint32_t width = 0, height = 0, bytes = 0;
+        if (!get(file, width) || !get(file, height) || !get(file, bytes) || width == 0 || height == 0
+            || bytes != imageBytes(image.format, width, height))
+        {
+            cout << path << " has a damaged level" << endl;
+            return false;
+        }
+        level.width = (int)width;
+        level.height = (int)height;
+        level.blocks.resize(bytes);
+        if (!file.read(reinterpret_cast<char*>(level.blocks.data()), bytes))
+        {
+            cout << path << " is cut short" << endl;
+            return false;
+        }
+    }
+    return true;
+}
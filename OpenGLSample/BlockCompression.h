@@ -0,0 +1,69 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: BlockCompression.h                                                                 //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: BC1, BC3 and BC4 block compression of RGBA images and their mip chains,     //
+// the matching decoders for measuring quality, and the .btex container the packed         //
+// textures are stored in and uploaded from.                                                //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Block formats, the numbers are stored in .btex files
+enum class BlockFormat : uint32_t
+{
+    BC1 = 1,  // RGB, 8 bytes per 4x4 block
+    BC3 = 3,  // RGBA, BC1 color with a BC4 alpha block, 16 bytes per block
+    BC4 = 4   // single channel, 8 bytes per block
+};
+
+// A block compressed image with its mip chain, level 0 first, rows bottom first as GL
+// expects them
+struct CompressedImage
+{
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<uint8_t> blocks;
+    };
+
+    BlockFormat format = BlockFormat::BC1;
+    // BC4 images hold a gray channel that is sampled into red, green and blue
+    bool gray = false;
+    std::vector<Level> levels;
+
+    uint64_t bytes() const;
+};
+
+// Blocks are encoded from RGBA texels; edge blocks repeat the last row and column
+class BlockCompression
+{
+public:
+    static int blockBytes(BlockFormat format) { return format == BlockFormat::BC3 ? 16 : 8; }
+    static size_t imageBytes(BlockFormat format, int width, int height);
+
+    // Encodes the block rows [firstRow, endRow) of a tightly packed RGBA image into blocks,
+    // which holds the whole image, so rows can be encoded on different threads
+    static void encodeRows(BlockFormat format, const uint8_t* rgba, int width, int height, int firstRow, int endRow,
+        uint8_t* blocks);
+    // Back to RGBA, for comparing against the source
+    static void decode(BlockFormat format, const uint8_t* blocks, int width, int height, uint8_t* rgba);
+
+    // Peak signal to noise ratio over the channels the format keeps (red, green and blue for
+    // BC4, which decodes to gray), in dB, 99 when equal
+    static double psnr(BlockFormat format, const uint8_t* original, const uint8_t* decoded, int width, int height);
+
+    // .btex files: a header, then every level's size and blocks. Both print what went wrong
+    static bool write(const std::string& path, const CompressedImage& image);
+    static bool read(const std::string& path, CompressedImage& image);
+
+private:
+    static void encodeBC1(const uint8_t texels[16][4], uint8_t* block);
+    static void encodeBC4(const uint8_t values[16], uint8_t* block);
+    static void decodeBC1(const uint8_t* block, uint8_t texels[16][4]);
+    static void decodeBC4(const uint8_t* block, uint8_t values[16]);
+};
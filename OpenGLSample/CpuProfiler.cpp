@@ -0,0 +1,198 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: CpuProfiler.cpp                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Scoped CPU timing zones. Each thread writes into its own fixed size        //
+// buffer without locking; the buffers are exported as Chrome trace / Perfetto JSON.       //
+// Zones compile to nothing unless ENABLE_PROFILING is defined.                            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Events each thread can hold, about 100 seconds of a busy render loop
+    const size_t EVENTS_PER_THREAD = 1 << 18;
+    const int MAX_ZONE_DEPTH = 64;
+    // Trace thread ids 1 and 2 are the GPU profiler's tracks
+    const int FIRST_THREAD_ID = 10;
+
+    struct ZoneEvent
+    {
+        const char* name;
+        int64_t startNs;
+        int64_t endNs;
+    };
+
+    // Written only by its own thread; count is published with release so the exporter
+    // can read a consistent prefix while the thread keeps recording
+    struct ThreadBuffer
+    {
+        int threadId = 0;
+        string threadName;
+        unique_ptr<ZoneEvent[]> events{ new ZoneEvent[EVENTS_PER_THREAD] };
+        atomic<size_t> count{ 0 };
+        size_t dropped = 0;
+
+        const char* openNames[MAX_ZONE_DEPTH];
+        int64_t openStarts[MAX_ZONE_DEPTH];
+        int openDepth = 0;
+    };
+
+    const chrono::steady_clock::time_point processStart = chrono::steady_clock::now();
+
+    // Only touched when a thread records its first zone or when exporting
+    mutex registryMutex;
+    vector<unique_ptr<ThreadBuffer>> registry;
+
+    thread_local ThreadBuffer* localBuffer = nullptr;
+
+    ThreadBuffer& threadBuffer()
+    {
+        if (localBuffer == nullptr)
+        {
+            lock_guard<mutex> lock(registryMutex);
+            registry.emplace_back(new ThreadBuffer());
+            localBuffer = registry.back().get();
+            localBuffer->threadId = FIRST_THREAD_ID + (int)registry.size() - 1;
+            localBuffer->threadName = (registry.size() == 1) ? "Main thread" : "Thread " + to_string(registry.size());
+        }
+        return *localBuffer;
+    }
+
+    // Trace names are literals from our own code, but keep the JSON valid regardless
+    void writeName(ofstream& file, const char* name)
+    {
+        file << '"';
+        for (const char* c = name; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                file << '\\';
+            file << *c;
+        }
+        file << '"';
+    }
+}
+
+atomic<bool> CpuProfiler::capturing{ false };
+
+int64_t CpuProfiler::nowNanoseconds()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - processStart).count();
+}
+
+void CpuProfiler::setThreadName(const char* name)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    lock_guard<mutex> lock(registryMutex);
+    buffer.threadName = name;
+}
+
+void CpuProfiler::beginZone(const char* name)
+{
+    if (!isCapturing())
+        return;
+    ThreadBuffer& buffer = threadBuffer();
+    if (buffer.openDepth < MAX_ZONE_DEPTH)
+    {
+        buffer.openNames[buffer.openDepth] = name;
+        buffer.openStarts[buffer.openDepth] = nowNanoseconds();
+    }
+    ++buffer.openDepth;
+}
+
+void CpuProfiler::endZone()
+{
+    if (localBuffer == nullptr || localBuffer->openDepth == 0)
+        return;
+    ThreadBuffer& buffer = *localBuffer;
+    --buffer.openDepth;
+    if (buffer.openDepth < MAX_ZONE_DEPTH && isCapturing())
+        recordZone(buffer.openNames[buffer.openDepth], buffer.openStarts[buffer.openDepth], nowNanoseconds());
+}
+
+void CpuProfiler::recordZone(const char* name, int64_t startNs, int64_t endNs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    size_t index = buffer.count.load(memory_order_relaxed);
+    if (index >= EVENTS_PER_THREAD)
+    {
+        ++buffer.dropped;
+        return;
+    }
+    buffer.events[index] = { name, startNs, endNs };
+    buffer.count.store(index + 1, memory_order_release);
+}
+
+bool CpuProfiler::writeTrace(const string& path, const GpuProfiler* gpu)
+{
+    ofstream file(path);
+    if (!file.is_open())
+    {
+        cout << "Could not write trace to " << path << endl;
+        return false;
+    }
+
+    size_t written = 0;
+    file.precision(3);
+    file << fixed;
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"OpenGLSample\"}}";
+
+    {
+        lock_guard<mutex> lock(registryMutex);
+        for (const auto& buffer : registry)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+            size_t count = buffer->count.load(memory_order_acquire);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const ZoneEvent& event = buffer->events[i];
+                file << ",\n{\"name\":";
+                writeName(file, event.name);
+                file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                    << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << (event.endNs - event.startNs) / 1000.0 << "}";
+            }
+            written += count;
+        }
+    }
+
+    if (gpu != nullptr && !gpu->traceEvents().empty())
+    {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GL submission\"}}";
+        for (const GpuProfiler::TraceEvent& event : gpu->traceEvents())
+        {
+            file << ",\n{\"name\":";
+            writeName(file, event.name);
+            file << ",\"cat\":\"" << (event.gpu ? "gpu" : "submit") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.gpu ? 1 : 2)
+                << ",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs << "}";
+        }
+        written += gpu->traceEvents().size();
+    }
+
+    file << "\n]}\n";
+    cout << "Wrote " << written << " trace events to " << path << endl;
+    return true;
+}
+
+void CpuProfiler::printStats()
+{
+    lock_guard<mutex> lock(registryMutex);
+    for (const auto& buffer : registry)
+    {
+        cout << "CPU zones on " << buffer->threadName << ": " << buffer->count.load(memory_order_acquire) << " recorded";
+        if (buffer->dropped > 0)
+            cout << ", " << buffer->dropped << " dropped (buffer full)";
+        cout << endl;
+    }
+}
@@ -0,0 +1,73 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: CpuProfiler.h                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Scoped CPU timing zones. Each thread writes into its own fixed size        //
+// buffer without locking; the buffers are exported as Chrome trace / Perfetto JSON.       //
+// Zones compile to nothing unless ENABLE_PROFILING is defined.                            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class GpuProfiler;
+
+// Records named CPU time ranges per thread
+class CpuProfiler
+{
+public:
+    // Starts or stops recording, zones cost a single relaxed load while stopped
+    static void setCapturing(bool capture) { capturing.store(capture, std::memory_order_relaxed); }
+    static bool isCapturing() { return capturing.load(std::memory_order_relaxed); }
+
+    // Time since the process started, the clock every trace event uses
+    static int64_t nowNanoseconds();
+    static double nowMicroseconds() { return nowNanoseconds() / 1000.0; }
+
+    // Names the calling thread in the trace
+    static void setThreadName(const char* name);
+
+    // Zone on the calling thread, names must be string literals (only the pointer is stored)
+    static void beginZone(const char* name);
+    static void endZone();
+    static void recordZone(const char* name, int64_t startNs, int64_t endNs);
+
+    // Writes every recorded zone, plus the GPU profiler's events when given one
+    static bool writeTrace(const std::string& path, const GpuProfiler* gpu);
+    static void printStats();
+
+    // RAII zone used by PROFILE_ZONE
+    struct Zone
+    {
+        explicit Zone(const char* name) : name(name), startNs(isCapturing() ? nowNanoseconds() : -1) {}
+        ~Zone()
+        {
+            if (startNs >= 0)
+                recordZone(name, startNs, nowNanoseconds());
+        }
+        const char* name;
+        int64_t startNs;
+    };
+
+private:
+    static std::atomic<bool> capturing;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+#ifdef ENABLE_PROFILING
+// Times the rest of the enclosing block
+#define PROFILE_ZONE(name) CpuProfiler::Zone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+// Times from here to the matching PROFILE_END on the same thread
+#define PROFILE_BEGIN(name) CpuProfiler::beginZone(name)
+#define PROFILE_END() CpuProfiler::endZone()
+#define PROFILE_THREAD_NAME(name) CpuProfiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
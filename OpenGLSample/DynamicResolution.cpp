@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: DynamicResolution.cpp                                                              //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Renders the scene into an offscreen target whose resolution follows the    //
+// measured GPU frame time, then scales it up to the window.                               //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+#include <cmath>
+
+namespace
+{
+    // Hysteresis: drop quickly when over budget, climb back only after a long stretch well under it
+    const float UPPER_THRESHOLD = 1.0f;
+    const float LOWER_THRESHOLD = 0.8f;
+    const int FRAMES_BEFORE_DROP = 8;
+    const int FRAMES_BEFORE_RAISE = 45;
+    const float RAISE_STEP = 0.05f;
+    const float SMOOTHING = 0.1f;
+}
+
+void DynamicResolution::init()
+{
+    glGenQueries(QUERY_COUNT, queries);
+}
+
+void DynamicResolution::release()
+{
+    glDeleteQueries(QUERY_COUNT, queries);
+    target.destroy();
+}
+
+void DynamicResolution::beginFrame(int width, int height)
+{
+    windowWidth = width;
+    windowHeight = height;
+
+    // the target stays at full window size, lower scales just use a corner of it
+    target.resize(width, height, 0);
+    scaledWidth = (int)(width * currentScale + 0.5f);
+    scaledHeight = (int)(height * currentScale + 0.5f);
+    if (scaledWidth < 1)
+        scaledWidth = 1;
+    if (scaledHeight < 1)
+        scaledHeight = 1;
+    target.bind(scaledWidth, scaledHeight);
+
+    // read the oldest query before reusing it, it was issued QUERY_COUNT frames ago
+    if (queryPending[queryIndex])
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(queries[queryIndex], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[queryIndex], GL_QUERY_RESULT, &elapsed);
+            updateScale((float)(elapsed / 1000000.0));
+        }
+    }
+    glBeginQuery(GL_TIME_ELAPSED, queries[queryIndex]);
+}
+
+void DynamicResolution::endFrame(GLuint outputFbo)
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[queryIndex] = true;
+    queryIndex = (queryIndex + 1) % QUERY_COUNT;
+
+    target.blitTo(outputFbo, scaledWidth, scaledHeight, windowWidth, windowHeight, GL_LINEAR);
+    glViewport(0, 0, windowWidth, windowHeight);
+}
+
+void DynamicResolution::updateScale(float gpuMs)
+{
+    smoothedGpuMs = (smoothedGpuMs == 0.0f) ? gpuMs : smoothedGpuMs + (gpuMs - smoothedGpuMs) * SMOOTHING;
+
+    // results still in flight were rendered at the old scale, don't react to them
+    if (settleFrames > 0)
+    {
+        --settleFrames;
+        return;
+    }
+
+    framesOverBudget = (smoothedGpuMs > budgetMs * UPPER_THRESHOLD) ? framesOverBudget + 1 : 0;
+    framesUnderBudget = (smoothedGpuMs < budgetMs * LOWER_THRESHOLD) ? framesUnderBudget + 1 : 0;
+
+    float newScale = currentScale;
+    if (framesOverBudget >= FRAMES_BEFORE_DROP)
+    {
+        // GPU time roughly follows pixel count, which goes with the square of the scale
+        float ratio = budgetMs * LOWER_THRESHOLD / smoothedGpuMs;
+        newScale = currentScale * sqrtf(ratio);
+    }
+    else if (framesUnderBudget >= FRAMES_BEFORE_RAISE)
+    {
+        newScale = currentScale + RAISE_STEP;
+    }
+
+    if (newScale < minScale)
+        newScale = minScale;
+    if (newScale > maxScale)
+        newScale = maxScale;
+
+    if (newScale != currentScale)
+    {
+        currentScale = newScale;
+        framesOverBudget = 0;
+        framesUnderBudget = 0;
+        settleFrames = QUERY_COUNT;
+        smoothedGpuMs = 0.0f;
+    }
+}
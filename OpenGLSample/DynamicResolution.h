@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: DynamicResolution.h                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Renders the scene into an offscreen target whose resolution follows the    //
+// measured GPU frame time, then scales it up to the window.                               //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include "RenderTarget.h"
+
+// Picks a render scale from GPU timer queries and upscales the result to the window
+class DynamicResolution
+{
+public:
+    bool enabled = false;
+    float budgetMs = 1000.0f / 60.0f;  // GPU time we want each frame to fit in
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+
+    void init();
+    void release();
+
+    // Binds the offscreen target at the current scale and starts timing the frame
+    void beginFrame(int windowWidth, int windowHeight);
+    // Stops timing, upscales to the output framebuffer (0 = window) and updates the scale
+    void endFrame(GLuint outputFbo = 0);
+
+    float scale() const { return currentScale; }
+    float gpuTimeMs() const { return smoothedGpuMs; }
+    int renderWidth() const { return scaledWidth; }
+    int renderHeight() const { return scaledHeight; }
+
+private:
+    // Results are read this many frames late so reading them never stalls
+    static const int QUERY_COUNT = 4;
+
+    void updateScale(float gpuMs);
+
+    RenderTarget target;
+    GLuint queries[QUERY_COUNT] = {};
+    bool queryPending[QUERY_COUNT] = {};
+    int queryIndex = 0;
+
+    int windowWidth = 0;
+    int windowHeight = 0;
+    int scaledWidth = 0;
+    int scaledHeight = 0;
+
+    float currentScale = 1.0f;
+    float smoothedGpuMs = 0.0f;
+    int framesOverBudget = 0;
+    int framesUnderBudget = 0;
+    int settleFrames = 0;
+};
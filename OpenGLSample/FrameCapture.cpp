@@ -0,0 +1,346 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: FrameCapture.cpp                                                                   //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Records rendered frames without stalling the render thread. Each frame is //
+// read into a ring of pixel buffer objects, mapped a few frames later once its fence has  //
+// passed, and encoded on worker threads into a Y4M video or a PNG sequence.                //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+#include "CpuProfiler.h"
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Match chain for the PNG sequence, low enough to keep up with a real time capture
+    const int PNG_EFFORT = 4;
+
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool endsWith(const string& text, const string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Creates the folder a path is in, one level only; true if it exists afterwards
+    bool createFolderOf(const string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        if (slash == string::npos || slash == 0)
+            return true;
+        string folder = path.substr(0, slash);
+#ifdef _WIN32
+        int result = _mkdir(folder.c_str());
+#else
+        int result = mkdir(folder.c_str(), 0755);
+#endif
+        return result == 0 || errno == EEXIST;
+    }
+
+    uint8_t clampByte(int value)
+    {
+        return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+    }
+}
+
+bool FrameCapture::start(const string& path, int fps)
+{
+    outputPath = path;
+    framesPerSecond = fps > 0 ? fps : 60;
+    y4m = endsWith(path, ".y4m");
+    if (!createFolderOf(path))
+    {
+        cout << "Could not create the capture folder for " << path << endl;
+        return false;
+    }
+    if (y4m)
+    {
+        video.open(path, ios::out | ios::binary | ios::trunc);
+        if (!video.is_open())
+        {
+            cout << "Could not create capture file " << path << endl;
+            return false;
+        }
+    }
+
+    running = true;
+    startTime = nowMs();
+    encoders.reset(new ThreadPool(y4m ? 1 : 0, "Capture encoder"));
+    return true;
+}
+
+void FrameCapture::resize(int width, int height)
+{
+    // the old buffers may still be in flight, let them finish first
+    collect(true);
+    for (Slot& slot : slots)
+    {
+        if (slot.buffer == 0)
+            glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    bufferWidth = width;
+    bufferHeight = height;
+}
+
+// Unmaps the buffers the encoders are done with so they can be read into again
+void FrameCapture::releaseEncoded()
+{
+    for (Slot& slot : slots)
+    {
+        if (slot.state.load(memory_order_acquire) != ENCODED)
+            continue;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        slot.pixels = nullptr;
+        slot.state.store(FREE, memory_order_release);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// Maps every finished readback and hands it to the encoders, oldest first.
+// Without wait, a readback whose fence hasn't passed is left for a later frame
+void FrameCapture::collect(bool wait)
+{
+    for (int i = 0; i < RING_SIZE; ++i)
+    {
+        Slot& slot = slots[(nextSlot + i) % RING_SIZE];
+        if (slot.state.load(memory_order_acquire) != READING)
+            continue;
+
+        GLenum result = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000ull : 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+            break;  // later slots are newer, they can't be ready either
+        glDeleteSync(slot.fence);
+        slot.fence = 0;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        slot.pixels = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)slot.width * slot.height * 4, GL_MAP_READ_BIT);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (slot.pixels == nullptr)
+        {
+            slot.state.store(FREE, memory_order_release);
+            continue;
+        }
+
+        slot.state.store(ENCODING, memory_order_release);
+        Slot* encoding = &slot;
+        encoders->submit([this, encoding] { encode(*encoding); });
+    }
+
+    // at shutdown also wait for the encoders so every buffer can be unmapped
+    if (wait)
+    {
+        for (Slot& slot : slots)
+            while (slot.state.load(memory_order_acquire) == ENCODING)
+                this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    releaseEncoded();
+}
+
+void FrameCapture::captureFrame(GLuint framebuffer, int width, int height, const string& name)
+{
+    if (!running || width <= 0 || height <= 0)
+        return;
+    PROFILE_ZONE("capture readback");
+    double start = nowMs();
+
+    if (width != bufferWidth || height != bufferHeight)
+        resize(width, height);
+
+    // hand over whatever finished in the frames since, then reuse the oldest slot
+    collect(false);
+    Slot& slot = slots[nextSlot];
+    if (slot.state.load(memory_order_acquire) != FREE && blocking)
+    {
+        // the oldest frame is either still being read or being encoded, wait for it alone
+        ++framesWaited;
+        while (slot.state.load(memory_order_acquire) != FREE)
+        {
+            if (slot.state.load(memory_order_acquire) == READING)
+                glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            else
+                this_thread::sleep_for(chrono::microseconds(200));
+            collect(false);
+        }
+    }
+    if (slot.state.load(memory_order_acquire) != FREE)
+    {
+        ++framesDropped;
+        renderThreadMs += nowMs() - start;
+        return;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    if (framebuffer == 0)
+        glReadBuffer(GL_BACK);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    // with a pack buffer bound this only queues the copy, the pointer is a buffer offset
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.frame = framesQueued++;
+    slot.name = name;
+    slot.state.store(READING, memory_order_release);
+    nextSlot = (nextSlot + 1) % RING_SIZE;
+
+    renderThreadMs += nowMs() - start;
+}
+
+// Runs on an encoder thread; the slot stays mapped until the render thread sees ENCODED
+void FrameCapture::encode(Slot& slot)
+{
+    PROFILE_ZONE("encode frame");
+    double start = nowMs();
+    if (y4m)
+        writeY4m(slot);
+    else
+        writePng(slot);
+    encodeUs += (int64_t)((nowMs() - start) * 1000.0);
+    slot.state.store(ENCODED, memory_order_release);
+}
+
+// Converts to full range BT.601 4:2:0 (Y4M "C420jpeg"), flipping to top row first
+void FrameCapture::writeY4m(const Slot& slot)
+{
+    int width = slot.width;
+    int height = slot.height;
+    if (videoWidth == 0)
+    {
+        videoWidth = width;
+        videoHeight = height;
+        video << "YUV4MPEG2 W" << width << " H" << height << " F" << framesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+    }
+    if (width != videoWidth || height != videoHeight)
+    {
+        ++framesSkipped;
+        return;
+    }
+
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    yuv.resize((size_t)width * height + 2 * (size_t)chromaWidth * chromaHeight);
+    uint8_t* planeY = yuv.data();
+    uint8_t* planeU = planeY + (size_t)width * height;
+    uint8_t* planeV = planeU + (size_t)chromaWidth * chromaHeight;
+
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* row = slot.pixels + (size_t)(height - 1 - y) * width * 4;
+        for (int x = 0; x < width; ++x)
+        {
+            int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+            planeY[(size_t)y * width + x] = clampByte((77 * r + 150 * g + 29 * b + 128) >> 8);
+        }
+    }
+    for (int cy = 0; cy < chromaHeight; ++cy)
+    {
+        for (int cx = 0; cx < chromaWidth; ++cx)
+        {
+            // average the 2x2 block, edges reuse the last row or column
+            int r = 0, g = 0, b = 0;
+            for (int dy = 0; dy < 2; ++dy)
+            {
+                int sy = min(cy * 2 + dy, height - 1);
+                const uint8_t* row = slot.pixels + (size_t)(height - 1 - sy) * width * 4;
+                for (int dx = 0; dx < 2; ++dx)
+                {
+                    int sx = min(cx * 2 + dx, width - 1);
+                    r += row[sx * 4];
+                    g += row[sx * 4 + 1];
+                    b += row[sx * 4 + 2];
+                }
+            }
+            r /= 4;
+            g /= 4;
+            b /= 4;
+            planeU[(size_t)cy * chromaWidth + cx] = clampByte(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+            planeV[(size_t)cy * chromaWidth + cx] = clampByte(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+        }
+    }
+
+    video << "FRAME\n";
+    video.write(reinterpret_cast<const char*>(yuv.data()), yuv.size());
+    ++framesWritten;
+}
+
+void FrameCapture::writePng(const Slot& slot)
+{
+    string fileName;
+    if (slot.name.empty())
+    {
+        size_t dot = outputPath.find_last_of('.');
+        char number[16];
+        snprintf(number, sizeof(number), "_%06llu", (unsigned long long)slot.frame);
+        fileName = ((dot == string::npos) ? outputPath : outputPath.substr(0, dot)) + number + ".png";
+    }
+    else
+    {
+        // named frames go in the folder of the output path
+        size_t slash = outputPath.find_last_of("/\\");
+        fileName = ((slash == string::npos) ? string() : outputPath.substr(0, slash + 1)) + slot.name + ".png";
+    }
+
+    vector<uint8_t> png = ImageWriter::encodePng(slot.pixels, slot.width, slot.height, 4, true, PNG_EFFORT);
+    if (ImageWriter::writeFile(fileName, png))
+        ++framesWritten;
+}
+
+void FrameCapture::finish()
+{
+    if (!running)
+        return;
+
+    collect(true);
+    encoders.reset();
+    running = false;
+
+    for (Slot& slot : slots)
+    {
+        if (slot.buffer != 0)
+            glDeleteBuffers(1, &slot.buffer);
+        slot.buffer = 0;
+    }
+    if (video.is_open())
+        video.close();
+
+    double wallSeconds = (nowMs() - startTime) / 1000.0;
+    uint64_t written = framesWritten.load();
+    cout << "Captured " << written << " frames to " << outputPath << " (" << (y4m ? "Y4M" : "PNG sequence") << ")";
+    if (framesDropped > 0)
+        cout << ", " << framesDropped << " dropped while the encoders were behind";
+    if (framesWaited > 0)
+        cout << ", waited for the encoders " << framesWaited << " times";
+    if (framesSkipped > 0)
+        cout << ", " << framesSkipped << " skipped after a size change";
+    cout << endl;
+    if (framesQueued > 0 && written > 0)
+    {
+        cout << "  capture " << written / wallSeconds << " frames/s over the run, "
+            << written / (encodeUs.load() / 1000000.0) << " frames/s per encoder thread, render thread cost "
+            << renderThreadMs / framesQueued << "ms per frame" << endl;
+    }
+}
@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: FrameCapture.h                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Records rendered frames without stalling the render thread. Each frame is //
+// read into a ring of pixel buffer objects, mapped a few frames later once its fence has  //
+// passed, and encoded on worker threads into a Y4M video or a PNG sequence.                //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+
+// Asynchronous glReadPixels capture with encoding on worker threads
+class FrameCapture
+{
+public:
+    ~FrameCapture() { finish(); }
+
+    // Output ending in .y4m is written as one raw YUV 4:2:0 stream by a single worker,
+    // anything else as PNG files next to the given name, compressed on a pool of workers.
+    // The folder of the path is created if missing. fps is only used for the Y4M header
+    bool start(const std::string& path, int fps);
+    bool active() const { return running; }
+    // Frames the encoders have written out so far
+    uint64_t written() const { return framesWritten.load(); }
+    // Wait for the oldest buffer instead of dropping a frame when the ring is full
+    void setBlocking(bool block) { blocking = block; }
+
+    // Queues a read of the given framebuffer (0 = window back buffer), call before swapping.
+    // PNG frames are numbered unless a name is given, which is then used as the file name
+    void captureFrame(GLuint framebuffer, int width, int height, const std::string& name = std::string());
+
+    // Waits for the frames still in flight, stops the worker and prints throughput
+    void finish();
+
+private:
+    // Slots go FREE -> READING (readback queued) -> ENCODING (mapped, owned by the worker)
+    // -> ENCODED (worker done, render thread unmaps) -> FREE
+    enum SlotState
+    {
+        FREE,
+        READING,
+        ENCODING,
+        ENCODED,
+    };
+
+    struct Slot
+    {
+        GLuint buffer = 0;
+        GLsync fence = 0;
+        std::atomic<int> state{ FREE };
+        const uint8_t* pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        uint64_t frame = 0;
+        std::string name;
+    };
+
+    static const int RING_SIZE = 6;
+
+    void resize(int width, int height);
+    void collect(bool wait);
+    void releaseEncoded();
+    void encode(Slot& slot);
+    void writeY4m(const Slot& slot);
+    void writePng(const Slot& slot);
+
+    bool running = false;
+    bool blocking = false;
+    bool y4m = false;
+    std::string outputPath;
+    int framesPerSecond = 60;
+
+    Slot slots[RING_SIZE];
+    int nextSlot = 0;
+    int bufferWidth = 0;
+    int bufferHeight = 0;
+    uint64_t framesQueued = 0;
+
+    // encoders, one for the ordered Y4M stream or one per core for PNG files
+    std::unique_ptr<ThreadPool> encoders;
+    std::ofstream video;
+    int videoWidth = 0;
+    int videoHeight = 0;
+    std::vector<uint8_t> yuv;
+
+    // statistics
+    double renderThreadMs = 0.0;     // time spent inside captureFrame
+    std::atomic<int64_t> encodeUs{ 0 };  // worker time spent encoding and writing, all workers
+    double startTime = 0.0;
+    std::atomic<uint64_t> framesWritten{ 0 };
+    uint64_t framesDropped = 0;       // the ring was full because the workers fell behind
+    uint64_t framesWaited = 0;        // blocking mode waited for the ring instead
+    uint64_t framesSkipped = 0;       // Y4M frames whose size didn't match the stream
+};
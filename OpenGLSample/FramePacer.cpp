@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: FramePacer.cpp                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Controls how fast frames are presented. Sets the swap interval, limits      //
+// the frame rate with a sleep-then-spin wait, adapting the limit to what frames take,      //
+// stops the CPU from queuing more than N frames ahead of the GPU, and reports frame time   //
+// percentiles.                                                                             //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Sleep is only trusted up to this close to the deadline, the rest is spun
+    const chrono::microseconds SPIN_MARGIN(1500);
+
+    const float BUCKET_MS = 0.1f;
+
+    double hertz(chrono::steady_clock::duration period)
+    {
+        return 1.0 / chrono::duration<double>(period).count();
+    }
+}
+
+void FramePacer::Histogram::add(float ms)
+{
+    ++counts[min((int)(ms / BUCKET_MS), BUCKETS)];
+    ++frames;
+    totalMs += ms;
+    maxMs = max(maxMs, ms);
+}
+
+void FramePacer::Histogram::clear()
+{
+    fill(counts.begin(), counts.end(), 0u);
+    frames = 0;
+    totalMs = 0.0;
+    maxMs = 0.0f;
+}
+
+float FramePacer::Histogram::percentile(double fraction) const
+{
+    uint64_t wanted = max((uint64_t)1, (uint64_t)(fraction * frames + 0.5));
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; ++bucket)
+    {
+        seen += counts[bucket];
+        if (seen >= wanted)
+            return min((bucket + 1) * BUCKET_MS, maxMs);
+    }
+    return maxMs;
+}
+
+void FramePacer::configure(double targetHz, int swapInterval, int framesAhead, double logInterval, bool adaptiveLimit)
+{
+    framePeriod = Clock::duration::zero();
+    if (targetHz > 0.0)
+        framePeriod = chrono::duration_cast<Clock::duration>(chrono::duration<double>(1.0 / targetHz));
+    targetPeriod = framePeriod;
+    divisor = 1;
+    adaptive = adaptiveLimit && targetHz > 0.0;
+    maxFramesAhead = framesAhead;
+    logSeconds = logInterval;
+
+    if (swapInterval >= 0)
+        glfwSwapInterval(swapInterval);
+
+#ifdef _WIN32
+    // default Windows timer resolution is ~15ms, far too coarse for frame limiting
+    if (framePeriod != Clock::duration::zero())
+        timeBeginPeriod(1);
+#endif
+
+    nextDeadline = Clock::now() + framePeriod;
+    lastLog = Clock::now();
+}
+
+void FramePacer::beginFrame()
+{
+    if (maxFramesAhead <= 0)
+        return;
+
+    // the oldest fence belongs to the frame maxFramesAhead frames back
+    while ((int)fences.size() >= maxFramesAhead)
+    {
+        Clock::time_point start = Clock::now();
+        GLsync oldest = fences.front();
+        glClientWaitSync(oldest, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        glDeleteSync(oldest);
+        fences.pop_front();
+        gpuWaitMs += chrono::duration<double, milli>(Clock::now() - start).count();
+    }
+}
+
+void FramePacer::endFrame()
+{
+    if (maxFramesAhead > 0)
+        fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    if (framePeriod != Clock::duration::zero())
+    {
+        Clock::time_point now = Clock::now();
+        if (adaptive && hasLastFrame)
+            adapt(now - lastFrameEnd);
+        // fell more than a frame behind, start a new cadence instead of rushing to catch up
+        if (now > nextDeadline + framePeriod)
+            nextDeadline = now;
+        waitUntil(nextDeadline);
+        nextDeadline += framePeriod;
+    }
+
+    Clock::time_point end = Clock::now();
+    if (hasLastFrame)
+    {
+        float ms = (float)chrono::duration<double, milli>(end - lastFrameEnd).count();
+        frameTimes.add(ms);
+        if (logSeconds > 0.0)
+            intervalTimes.add(ms);
+    }
+    lastFrameEnd = end;
+    hasLastFrame = true;
+
+    if (logSeconds > 0.0 && chrono::duration<double>(end - lastLog).count() >= logSeconds)
+    {
+        report(intervalTimes, "Frame times");
+        intervalTimes.clear();
+        lastLog = end;
+    }
+}
+
+void FramePacer::resetTimer()
+{
+    hasLastFrame = false;
+    nextDeadline = Clock::now() + framePeriod;
+}
+
+// Coarse sleep until just before the deadline, then spin for sub-millisecond accuracy
+void FramePacer::waitUntil(Clock::time_point deadline)
+{
+    Clock::time_point now = Clock::now();
+    if (deadline - now > SPIN_MARGIN)
+        this_thread::sleep_for(deadline - now - SPIN_MARGIN);
+    while (Clock::now() < deadline)
+        this_thread::yield();
+}
+
+// A window with more than one frame in ten over the limit steps down to the next fraction of
+// the target; one whose slowest frame would fit the faster limit with a fifth to spare steps up
+void FramePacer::adapt(Clock::duration work)
+{
+    ++windowFrames;
+    if (work > framePeriod)
+        ++windowMisses;
+    slowestWork = max(slowestWork, work);
+    if (windowFrames < ADAPT_WINDOW)
+        return;
+
+    int previous = divisor;
+    if (windowMisses * 10 > windowFrames && divisor < MAX_DIVISOR)
+        ++divisor;
+    else if (divisor > 1 && slowestWork < targetPeriod * (divisor - 1) * 4 / 5)
+        --divisor;
+    if (divisor != previous)
+    {
+        framePeriod = targetPeriod * divisor;
+        ++limitChanges;
+        cout << "Frame limit adapted to " << hertz(framePeriod) << " fps" << endl;
+    }
+    windowFrames = 0;
+    windowMisses = 0;
+    slowestWork = Clock::duration::zero();
+}
+
+void FramePacer::report(const Histogram& samples, const char* label) const
+{
+    if (samples.frames == 0)
+        return;
+    cout << label << " (" << samples.frames << " frames, avg " << samples.totalMs / samples.frames << "ms): p50 "
+        << samples.percentile(0.50) << "ms, p95 " << samples.percentile(0.95) << "ms, p99 "
+        << samples.percentile(0.99) << "ms, max " << samples.maxMs << "ms" << endl;
+}
+
+void FramePacer::printStats() const
+{
+    report(frameTimes, "Frame times overall");
+    if (adaptive)
+        cout << "Frame limit changed " << limitChanges << " times, ending at " << hertz(framePeriod) << " fps" << endl;
+    if (maxFramesAhead > 0)
+        cout << "CPU waited " << gpuWaitMs << "ms on GPU fences" << endl;
+}
+
+void FramePacer::release()
+{
+    for (GLsync fence : fences)
+        glDeleteSync(fence);
+    fences.clear();
+#ifdef _WIN32
+    if (framePeriod != Clock::duration::zero())
+        timeEndPeriod(1);
+#endif
+}
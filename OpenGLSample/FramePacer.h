@@ -0,0 +1,90 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: FramePacer.h                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Controls how fast frames are presented. Sets the swap interval, limits      //
+// the frame rate with a sleep-then-spin wait, adapting the limit to what frames take,      //
+// stops the CPU from queuing more than N frames ahead of the GPU, and reports frame time   //
+// percentiles.                                                                             //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Paces the render loop and collects frame times
+class FramePacer
+{
+public:
+    // targetHz 0 = uncapped, swapInterval -1 = leave the driver default,
+    // maxFramesAhead 0 = no GPU throttling, logSeconds 0 = only report on exit. With adaptive,
+    // a target that frames keep missing drops to 1/2, 1/3 or 1/4 of it, for an even cadence
+    // instead of alternating long and short frames, and climbs back once they fit again
+    void configure(double targetHz, int swapInterval, int maxFramesAhead, double logSeconds, bool adaptive);
+
+    // Blocks while the GPU is more than maxFramesAhead frames behind; call before sampling input
+    void beginFrame();
+    // Call right after swapping buffers: fences the frame, waits out the rest of the frame budget
+    void endFrame();
+    // Forget the last frame time, used after the loop slept on purpose
+    void resetTimer();
+
+    // Percentiles over every frame recorded so far
+    void printStats() const;
+    // Deletes outstanding fences
+    void release();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // Frame times in fixed 0.1ms buckets up to 250ms, so memory and the cost of a report stay
+    // the same however long the program runs; percentiles are exact to a bucket
+    struct Histogram
+    {
+        static const int BUCKETS = 2500;
+        std::vector<uint32_t> counts = std::vector<uint32_t>(BUCKETS + 1);  // the last one holds longer frames
+        uint64_t frames = 0;
+        double totalMs = 0.0;
+        float maxMs = 0.0f;
+
+        void add(float ms);
+        void clear();
+        // Upper edge of the bucket the given fraction of the frames fall within, the maximum at most
+        float percentile(double fraction) const;
+    };
+
+    // Frames adapt looks at before moving the limit
+    static const int ADAPT_WINDOW = 60;
+    static const int MAX_DIVISOR = 4;
+
+    void waitUntil(Clock::time_point deadline);
+    // Counts the time a frame took before its limiter wait against the limit, moving it every window
+    void adapt(Clock::duration work);
+    void report(const Histogram& samples, const char* label) const;
+
+    Clock::duration framePeriod = Clock::duration::zero();
+    Clock::duration targetPeriod = Clock::duration::zero();
+    int maxFramesAhead = 0;
+    double logSeconds = 0.0;
+
+    Clock::time_point nextDeadline;
+    Clock::time_point lastFrameEnd;
+    Clock::time_point lastLog;
+    bool hasLastFrame = false;
+
+    std::deque<GLsync> fences;
+    double gpuWaitMs = 0.0;
+
+    bool adaptive = false;
+    int divisor = 1;
+    int windowFrames = 0;
+    int windowMisses = 0;
+    Clock::duration slowestWork = Clock::duration::zero();
+    int limitChanges = 0;
+
+    Histogram frameTimes;     // every frame since start
+    Histogram intervalTimes;  // frames since the last periodic log
+};
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: FrameScheduler.cpp                                                                 //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Decides whether the render loop needs to draw a new frame. In on-demand    //
+// mode the loop sleeps in glfwWaitEventsTimeout until something marks the frame dirty.    //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameScheduler.h"
+#include <GLFW/glfw3.h>
+#include <iostream>
+using namespace std; // Standard namespace
+
+bool FrameScheduler::pollEvents()
+{
+    if (isDirty())
+    {
+        glfwPollEvents();
+        return false;
+    }
+
+    // Nothing to draw, so sleep until an event arrives or the idle refresh is due
+    double start = glfwGetTime();
+    if (maxIdleSeconds > 0.0)
+    {
+        double remaining = lastRenderTime + maxIdleSeconds - start;
+        if (remaining > 0.0)
+            glfwWaitEventsTimeout(remaining);
+        else
+            glfwPollEvents();
+
+        if (glfwGetTime() - lastRenderTime >= maxIdleSeconds && !dirty)
+        {
+            dirty = true;
+            ++idleRefreshes;
+        }
+    }
+    else
+    {
+        glfwWaitEvents();
+    }
+    idleSeconds += glfwGetTime() - start;
+    return true;
+}
+
+bool FrameScheduler::beginFrame()
+{
+    if (isDirty())
+        return true;
+
+    // Woken by an event that changed nothing visible
+    ++framesSkipped;
+    return false;
+}
+
+void FrameScheduler::endFrame()
+{
+    ++framesRendered;
+    lastRenderTime = glfwGetTime();
+    dirty = dirtyNextFrame;
+    dirtyNextFrame = false;
+}
+
+void FrameScheduler::printStats() const
+{
+    cout << "Frames rendered: " << framesRendered << ", skipped: " << framesSkipped;
+    if (onDemand)
+        cout << ", idle refreshes: " << idleRefreshes << ", time idle: " << idleSeconds << "s";
+    cout << endl;
+}
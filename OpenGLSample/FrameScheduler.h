@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: FrameScheduler.h                                                                   //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Decides whether the render loop needs to draw a new frame. In on-demand    //
+// mode the loop sleeps in glfwWaitEventsTimeout until something marks the frame dirty.    //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Tracks whether the scene changed since the last frame and blocks the loop while it has not
+class FrameScheduler
+{
+public:
+    // When false every loop iteration renders, same as before
+    bool onDemand = false;
+    // Redraw at least this often even if nothing changed, 0 waits forever
+    double maxIdleSeconds = 0.0;
+
+    // Marks the current frame as needing a redraw
+    void invalidate() { dirty = true; }
+    // Marks this frame and the next one, used while a movement key is held down
+    void invalidateContinuous() { dirty = true; dirtyNextFrame = true; }
+    bool isDirty() const { return dirty || !onDemand; }
+
+    // Waits for input events, or polls them when a redraw is already pending.
+    // Returns true if the loop slept, so the caller can restart its frame timer
+    bool pollEvents();
+    // True when the frame should be drawn, otherwise counts it as skipped
+    bool beginFrame();
+    // Called after the buffers are swapped
+    void endFrame();
+
+    void printStats() const;
+
+private:
+    bool dirty = true;
+    bool dirtyNextFrame = false;
+    double lastRenderTime = 0.0;
+    double idleSeconds = 0.0;
+
+    unsigned long long framesRendered = 0;
+    unsigned long long framesSkipped = 0;
+    unsigned long long idleRefreshes = 0;
+};
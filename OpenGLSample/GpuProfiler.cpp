@@ -0,0 +1,249 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: GpuProfiler.cpp                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Measures GPU time of render passes and scene objects with timestamp        //
+// queries. Results are read a few frames late from a ring so the CPU never waits on them. //
+// Timings are drawn as bars over the scene and can be saved as a Chrome trace.            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    const double SMOOTHING = 0.05;
+    // Stop capturing trace events past this many, about a minute of frames
+    const size_t MAX_TRACE_EVENTS = 500000;
+
+    // Overlay layout, in pixels
+    const int BAR_HEIGHT = 8;
+    const int BAR_SPACING = 12;
+    const int BAR_MARGIN = 10;
+    const int INDENT = 12;
+    const float PIXELS_PER_MS = 40.0f;
+
+    const float BAR_COLORS[][3] = {
+        { 0.90f, 0.30f, 0.25f },
+        { 0.95f, 0.65f, 0.20f },
+        { 0.35f, 0.75f, 0.30f },
+        { 0.25f, 0.55f, 0.90f },
+        { 0.70f, 0.40f, 0.85f },
+        { 0.30f, 0.80f, 0.80f },
+    };
+}
+
+GpuProfiler& GpuProfiler::shared()
+{
+    static GpuProfiler profiler;
+    return profiler;
+}
+
+void GpuProfiler::init()
+{
+    // GPU timestamps are on their own clock, remember where it was against the CPU trace clock
+    glGetInteger64v(GL_TIMESTAMP, &gpuStartNs);
+    cpuStartUs = CpuProfiler::nowMicroseconds();
+}
+
+void GpuProfiler::release()
+{
+    if (!allQueries.empty())
+        glDeleteQueries((GLsizei)allQueries.size(), allQueries.data());
+    allQueries.clear();
+    freeQueries.clear();
+    for (auto& frame : frames)
+        frame.clear();
+}
+
+GLuint GpuProfiler::acquireQuery()
+{
+    if (freeQueries.empty())
+    {
+        GLuint batch[16];
+        glGenQueries(16, batch);
+        for (GLuint query : batch)
+        {
+            freeQueries.push_back(query);
+            allQueries.push_back(query);
+        }
+    }
+    GLuint query = freeQueries.back();
+    freeQueries.pop_back();
+    return query;
+}
+
+void GpuProfiler::beginFrame()
+{
+    if (!enabled)
+        return;
+
+    frameIndex = (frameIndex + 1) % FRAME_LAG;
+    collect(frameIndex);
+    openScopes.clear();
+}
+
+void GpuProfiler::beginScope(const char* name)
+{
+    if (!enabled)
+        return;
+
+    PendingScope scope;
+    scope.name = name;
+    scope.depth = (int)openScopes.size();
+    scope.beginQuery = acquireQuery();
+    scope.endQuery = acquireQuery();
+    scope.cpuBeginUs = CpuProfiler::nowMicroseconds();
+    scope.cpuEndUs = scope.cpuBeginUs;
+    glQueryCounter(scope.beginQuery, GL_TIMESTAMP);
+    lastQueries[frameIndex] = scope.beginQuery;
+
+    openScopes.push_back((int)frames[frameIndex].size());
+    frames[frameIndex].push_back(scope);
+}
+
+void GpuProfiler::endScope()
+{
+    if (!enabled || openScopes.empty())
+        return;
+
+    PendingScope& scope = frames[frameIndex][openScopes.back()];
+    openScopes.pop_back();
+    glQueryCounter(scope.endQuery, GL_TIMESTAMP);
+    lastQueries[frameIndex] = scope.endQuery;
+    scope.cpuEndUs = CpuProfiler::nowMicroseconds();
+}
+
+GpuProfiler::ScopeStats& GpuProfiler::statsFor(const char* name, int depth)
+{
+    for (ScopeStats& entry : stats)
+    {
+        if (entry.depth == depth && strcmp(entry.name, name) == 0)
+            return entry;
+    }
+    stats.push_back({ name, depth, 0.0, 0.0, 0.0, 0 });
+    return stats.back();
+}
+
+// Reads the results of a frame issued FRAME_LAG frames ago and returns its queries to the pool
+void GpuProfiler::collect(int slot)
+{
+    vector<PendingScope>& frame = frames[slot];
+    if (frame.empty())
+        return;
+
+    // queries finish in the order they were issued, so if the last one is done they all are
+    GLint available = 0;
+    glGetQueryObjectiv(lastQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available)
+    {
+        for (const PendingScope& scope : frame)
+        {
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(scope.beginQuery, GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end);
+            double gpuMs = (end - begin) / 1000000.0;
+            double cpuMs = (scope.cpuEndUs - scope.cpuBeginUs) / 1000.0;
+
+            ScopeStats& entry = statsFor(scope.name, scope.depth);
+            if (entry.samples == 0)
+            {
+                entry.gpuMs = gpuMs;
+                entry.cpuMs = cpuMs;
+            }
+            else
+            {
+                entry.gpuMs += (gpuMs - entry.gpuMs) * SMOOTHING;
+                entry.cpuMs += (cpuMs - entry.cpuMs) * SMOOTHING;
+            }
+            entry.totalGpuMs += gpuMs;
+            ++entry.samples;
+
+            if (captureTrace && events.size() + 2 <= MAX_TRACE_EVENTS)
+            {
+                double gpuStartUs = cpuStartUs + ((GLint64)begin - gpuStartNs) / 1000.0;
+                events.push_back({ scope.name, true, gpuStartUs, (end - begin) / 1000.0 });
+                events.push_back({ scope.name, false, scope.cpuBeginUs, scope.cpuEndUs - scope.cpuBeginUs });
+            }
+        }
+    }
+    else
+    {
+        // the GPU is more than FRAME_LAG frames behind; skip these results rather than wait
+        ++droppedFrames;
+    }
+
+    for (const PendingScope& scope : frame)
+    {
+        freeQueries.push_back(scope.beginQuery);
+        freeQueries.push_back(scope.endQuery);
+    }
+    frame.clear();
+}
+
+void GpuProfiler::drawOverlay(int framebufferWidth, int framebufferHeight) const
+{
+    if (!enabled || stats.empty())
+        return;
+
+    // scissored clears draw solid rectangles without needing a shader or geometry
+    GLfloat oldClear[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, oldClear);
+    glEnable(GL_SCISSOR_TEST);
+
+    int y = framebufferHeight - BAR_MARGIN - BAR_HEIGHT;
+    for (size_t i = 0; i < stats.size() && y > 0; ++i)
+    {
+        const ScopeStats& entry = stats[i];
+        int x = BAR_MARGIN + entry.depth * INDENT;
+        int width = (int)(entry.gpuMs * PIXELS_PER_MS) + 1;
+        if (x + width > framebufferWidth)
+            width = framebufferWidth - x;
+
+        const float* color = BAR_COLORS[i % (sizeof(BAR_COLORS) / sizeof(BAR_COLORS[0]))];
+        glScissor(x, y, width, BAR_HEIGHT);
+        glClearColor(color[0], color[1], color[2], 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        y -= BAR_SPACING;
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(oldClear[0], oldClear[1], oldClear[2], oldClear[3]);
+}
+
+string GpuProfiler::summary() const
+{
+    ostringstream text;
+    text.precision(2);
+    text << fixed;
+    bool first = true;
+    for (const ScopeStats& entry : stats)
+    {
+        // only the top level passes fit in a title bar
+        if (entry.depth > 1)
+            continue;
+        if (!first)
+            text << ", ";
+        text << entry.name << " " << entry.gpuMs << "ms";
+        first = false;
+    }
+    return text.str();
+}
+
+void GpuProfiler::printStats() const
+{
+    if (stats.empty())
+        return;
+    cout << "GPU profile (smoothed gpu / cpu ms, average gpu ms):" << endl;
+    for (const ScopeStats& entry : stats)
+    {
+        cout << "  " << string(entry.depth * 2, ' ') << entry.name << ": " << entry.gpuMs << " / " << entry.cpuMs
+            << ", avg " << entry.totalGpuMs / entry.samples << endl;
+    }
+    if (droppedFrames > 0)
+        cout << "  " << droppedFrames << " frames dropped because results were not ready" << endl;
+}
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: GpuProfiler.h                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Measures GPU time of render passes and scene objects with timestamp        //
+// queries. Results are read a few frames late from a ring so the CPU never waits on them. //
+// Timings are drawn as bars over the scene and can be saved as a Chrome trace.            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// Times named scopes on the GPU (and the CPU time spent issuing them)
+class GpuProfiler
+{
+public:
+    // Profiler used by GPU_SCOPE, so SceneObjects doesn't need one passed in
+    static GpuProfiler& shared();
+
+    bool enabled = false;
+
+    void init();
+    void release();
+
+    // Call once per frame before the first scope, collects finished results
+    void beginFrame();
+    void beginScope(const char* name);
+    void endScope();
+
+    // Draws one bar per scope in the top left corner of the current framebuffer
+    void drawOverlay(int framebufferWidth, int framebufferHeight) const;
+    // Short text summary for the title bar
+    std::string summary() const;
+    void printStats() const;
+
+    // Keeps per-scope events for trace export (memory is capped), written by CpuProfiler::writeTrace
+    void setTraceCapture(bool capture) { captureTrace = capture; }
+
+    // RAII helper that wraps a block in begin/endScope
+    struct Scope
+    {
+        Scope(GpuProfiler& profiler, const char* name) : profiler(profiler) { profiler.beginScope(name); }
+        ~Scope() { profiler.endScope(); }
+        GpuProfiler& profiler;
+    };
+
+    // A timing for trace export
+    struct TraceEvent
+    {
+        const char* name;
+        bool gpu;
+        double startUs;
+        double durationUs;
+    };
+    const std::vector<TraceEvent>& traceEvents() const { return events; }
+
+private:
+    // Frames in flight before their query results are read
+    static const int FRAME_LAG = 4;
+
+    struct PendingScope
+    {
+        const char* name;
+        int depth;
+        GLuint beginQuery;
+        GLuint endQuery;
+        double cpuBeginUs;
+        double cpuEndUs;
+    };
+
+    struct ScopeStats
+    {
+        const char* name;
+        int depth;
+        double gpuMs;      // smoothed
+        double cpuMs;      // smoothed
+        double totalGpuMs;
+        unsigned long long samples;
+    };
+
+    GLuint acquireQuery();
+    void collect(int slot);
+    ScopeStats& statsFor(const char* name, int depth);
+
+    std::vector<PendingScope> frames[FRAME_LAG];
+    // Query each frame issued last; scopes end out of order (the outer frame scope last), so
+    // this, not the last scope's end, tells when all of a frame's results are in
+    GLuint lastQueries[FRAME_LAG] = {};
+    std::vector<GLuint> freeQueries;
+    std::vector<GLuint> allQueries;
+    std::vector<int> openScopes;  // indices into the current frame, innermost last
+    int frameIndex = 0;
+
+    std::vector<ScopeStats> stats;
+    unsigned long long droppedFrames = 0;
+
+    bool captureTrace = false;
+    std::vector<TraceEvent> events;
+
+    // GPU clock reading and CPU profiler time taken together in init()
+    GLint64 gpuStartNs = 0;
+    double cpuStartUs = 0.0;
+};
+
+// Times the rest of the enclosing block under the given name
+#define GPU_SCOPE_CONCAT2(a, b) a##b
+#define GPU_SCOPE_CONCAT(a, b) GPU_SCOPE_CONCAT2(a, b)
+#define GPU_SCOPE(name) GpuProfiler::Scope GPU_SCOPE_CONCAT(gpuScope_, __LINE__)(GpuProfiler::shared(), name)
@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ImageDiff.cpp                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Compares a rendered frame against a reference image, for checking one      //
+// renderer against another. Prints the error statistics and writes a difference image.   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ImageDiff.h"
+#include "ImageWriter.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Scale applied to the difference image so small errors are still visible
+    const int DIFF_GAIN = 4;
+}
+
+bool ImageDiff::compare(const string& referencePath, const uint8_t* pixels, int width, int height, bool bottomUp)
+{
+    int refWidth, refHeight, refChannels;
+    unsigned char* reference = stbi_load(referencePath.c_str(), &refWidth, &refHeight, &refChannels, 4);
+    if (!reference)
+    {
+        cout << "Could not load the reference image " << referencePath << endl;
+        return false;
+    }
+    if (refWidth != width || refHeight != height)
+    {
+        cout << "Reference " << referencePath << " is " << refWidth << "x" << refHeight
+            << ", the frame is " << width << "x" << height << endl;
+        stbi_image_free(reference);
+        return false;
+    }
+
+    // the reference is stored top row first
+    vector<uint8_t> diff((size_t)width * height * 3);
+    double squaredError = 0.0;
+    double absoluteError = 0.0;
+    int maxError = 0;
+    size_t differing = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t* frameRow = pixels + (size_t)(bottomUp ? height - 1 - y : y) * width * 4;
+        const uint8_t* refRow = reference + (size_t)y * width * 4;
+        uint8_t* diffRow = &diff[(size_t)y * width * 3];
+        for (int x = 0; x < width; ++x)
+        {
+            int pixelError = 0;
+            for (int c = 0; c < 3; ++c)
+            {
+                int error = abs((int)frameRow[x * 4 + c] - (int)refRow[x * 4 + c]);
+                squaredError += error * error;
+                absoluteError += error;
+                pixelError = max(pixelError, error);
+                diffRow[x * 3 + c] = (uint8_t)min(error * DIFF_GAIN, 255);
+            }
+            maxError = max(maxError, pixelError);
+            if (pixelError > THRESHOLD)
+                ++differing;
+        }
+    }
+    stbi_image_free(reference);
+
+    double samples = (double)width * height * 3;
+    double mse = squaredError / samples;
+    cout << "Compared with " << referencePath << ": mean error " << absoluteError / samples << ", max " << maxError << ", PSNR ";
+    if (mse > 0.0)
+        cout << 10.0 * log10(255.0 * 255.0 / mse) << "dB";
+    else
+        cout << "infinite (identical)";
+    cout << ", " << 100.0 * differing / ((double)width * height) << "% of pixels differ by more than " << THRESHOLD << endl;
+
+    size_t dot = referencePath.find_last_of('.');
+    size_t slash = referencePath.find_last_of("/\\");
+    string base = (dot == string::npos || (slash != string::npos && dot < slash)) ? referencePath : referencePath.substr(0, dot);
+    string diffPath = base + "_diff.png";
+    if (ImageWriter::writePng(diffPath, diff.data(), width, height, 3, false))
+        cout << "Wrote the difference image to " << diffPath << endl;
+    return true;
+}
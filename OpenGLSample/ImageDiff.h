@@ -0,0 +1,24 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ImageDiff.h                                                                        //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Compares a rendered frame against a reference image, for checking one      //
+// renderer against another. Prints the error statistics and writes a difference image.   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Per pixel comparison of RGB, alpha is ignored
+class ImageDiff
+{
+public:
+    // Channel difference above which a pixel counts as different
+    static const int THRESHOLD = 8;
+
+    // Loads the reference PNG and compares it with pixels (RGBA8, bottomUp for glReadPixels
+    // output). The difference, scaled up to be visible, goes next to the reference as
+    // <name>_diff.png. Returns false if the reference can't be loaded or the sizes differ
+    static bool compare(const std::string& referencePath, const uint8_t* pixels, int width, int height, bool bottomUp);
+};
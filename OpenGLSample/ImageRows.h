@@ -0,0 +1,35 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ImageRows.h                                                                        //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Gets decoded images ready for upload in a single pass: rows flipped to      //
+// bottom first with whole row copies, channels expanded to RGBA and color premultiplied   //
+// by alpha on the way. Includes a benchmark over the texture files.                       //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+
+// Images are 8 bits per channel with tightly packed rows
+class ImageRows
+{
+public:
+    // Reverses the row order in place, swapping whole rows through a small buffer
+    static void flipVertically(unsigned char* image, int width, int height, int channels);
+
+    // Writes source into destination, which must not overlap it, bottom row first when flip
+    // is set. destinationChannels is sourceChannels or 4, the added alpha is opaque; with
+    // premultiply the color of RGBA images is multiplied by their alpha. Rows that
+    // need no change are copied whole
+    static void convert(const unsigned char* source, unsigned char* destination, int width, int height,
+        int sourceChannels, int destinationChannels, bool flip, bool premultiply);
+
+    // Next mip level with a 2x2 box filter, the last row or column repeats on odd sizes.
+    // destination is max(width / 2, 1) by max(height / 2, 1)
+    static void downsample(const unsigned char* source, unsigned char* destination, int width, int height, int channels);
+
+    // Times the old byte by byte flip against flipVertically and convert on each file and
+    // prints a table, repeats times each
+    static void runBenchmark(const std::vector<std::string>& paths, int repeats);
+};
@@ -0,0 +1,379 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ImageWriter.cpp                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Saves rendered frames as PNG or raw RGBA files. The PNG encoder is self    //
+// contained (filtering, LZ77 and fixed Huffman deflate) and safe to call from any thread. //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ImageWriter.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // ---- checksums ----
+
+    // Built on first use; function statics are initialized once even with several threads
+    struct CrcTable
+    {
+        uint32_t values[256];
+        CrcTable()
+        {
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                values[n] = c;
+            }
+        }
+    };
+
+    uint32_t crc32(const uint8_t* data, size_t length)
+    {
+        static const CrcTable table;
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; ++i)
+            crc = table.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    uint32_t adler32(const uint8_t* data, size_t length)
+    {
+        uint32_t a = 1, b = 0;
+        while (length > 0)
+        {
+            // 5552 is the most bytes that can be summed before b overflows
+            size_t block = length < 5552 ? length : 5552;
+            length -= block;
+            while (block--)
+            {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    // ---- deflate ----
+
+    // Writes bits least significant first, as deflate expects
+    struct BitWriter
+    {
+        vector<uint8_t>& out;
+        uint32_t buffer = 0;
+        int count = 0;
+
+        explicit BitWriter(vector<uint8_t>& out) : out(out) {}
+
+        void bits(uint32_t value, int length)
+        {
+            buffer |= value << count;
+            count += length;
+            while (count >= 8)
+            {
+                out.push_back((uint8_t)buffer);
+                buffer >>= 8;
+                count -= 8;
+            }
+        }
+        // Huffman codes are defined most significant bit first
+        void code(uint32_t value, int length)
+        {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; ++i)
+                reversed |= ((value >> i) & 1) << (length - 1 - i);
+            bits(reversed, length);
+        }
+        void flush()
+        {
+            if (count > 0)
+                out.push_back((uint8_t)buffer);
+            buffer = 0;
+            count = 0;
+        }
+    };
+
+    const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const int DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    const int DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    const int WINDOW_SIZE = 32768;
+    const int MIN_MATCH = 3;
+    const int MAX_MATCH = 258;
+    const int HASH_BITS = 15;
+
+    // Literal/length symbol with the fixed Huffman code table
+    void writeSymbol(BitWriter& writer, int symbol)
+    {
+        if (symbol < 144)
+            writer.code(0x30 + symbol, 8);
+        else if (symbol < 256)
+            writer.code(0x190 + symbol - 144, 9);
+        else if (symbol < 280)
+            writer.code(symbol - 256, 7);
+        else
+            writer.code(0xC0 + symbol - 280, 8);
+    }
+
+    void writeMatch(BitWriter& writer, int length, int distance)
+    {
+        int l = 28;
+        while (LENGTH_BASE[l] > length)
+            --l;
+        writeSymbol(writer, 257 + l);
+        writer.bits(length - LENGTH_BASE[l], LENGTH_EXTRA[l]);
+
+        int d = 29;
+        while (DIST_BASE[d] > distance)
+            --d;
+        writer.code(d, 5);
+        writer.bits(distance - DIST_BASE[d], DIST_EXTRA[d]);
+    }
+
+    // Stored blocks, used when effort is 0
+    void deflateStored(const uint8_t* data, size_t length, vector<uint8_t>& out)
+    {
+        size_t offset = 0;
+        do
+        {
+            size_t block = length - offset < 65535 ? length - offset : 65535;
+            bool last = offset + block == length;
+            out.push_back(last ? 1 : 0);
+            out.push_back((uint8_t)block);
+            out.push_back((uint8_t)(block >> 8));
+            out.push_back((uint8_t)~block);
+            out.push_back((uint8_t)(~block >> 8));
+            out.insert(out.end(), data + offset, data + offset + block);
+            offset += block;
+        } while (offset < length);
+    }
+
+    // One fixed Huffman block with greedy LZ77 matching over hash chains
+    void deflateFixed(const uint8_t* data, size_t length, int maxChain, vector<uint8_t>& out)
+    {
+        vector<int32_t> head(1 << HASH_BITS, -1);
+        vector<int32_t> prev(WINDOW_SIZE, -1);
+        auto hashAt = [data](size_t i) {
+            return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1 << HASH_BITS) - 1);
+        };
+        auto insert = [&](size_t i) {
+            int h = hashAt(i);
+            prev[i & (WINDOW_SIZE - 1)] = head[h];
+            head[h] = (int32_t)i;
+        };
+
+        BitWriter writer(out);
+        writer.bits(1, 1);  // final block
+        writer.bits(1, 2);  // fixed Huffman codes
+
+        size_t i = 0;
+        while (i < length)
+        {
+            int bestLength = 0;
+            int bestDistance = 0;
+            if (i + MIN_MATCH <= length)
+            {
+                int limit = (int)((length - i) < (size_t)MAX_MATCH ? length - i : MAX_MATCH);
+                int32_t candidate = head[hashAt(i)];
+                for (int chain = 0; candidate >= 0 && chain < maxChain; ++chain)
+                {
+                    int distance = (int)(i - candidate);
+                    if (distance > WINDOW_SIZE - 1)
+                        break;
+                    if (data[candidate + bestLength] == data[i + bestLength])
+                    {
+                        int matched = 0;
+                        while (matched < limit && data[candidate + matched] == data[i + matched])
+                            ++matched;
+                        if (matched > bestLength)
+                        {
+                            bestLength = matched;
+                            bestDistance = distance;
+                            if (matched == limit)
+                                break;
+                        }
+                    }
+                    candidate = prev[candidate & (WINDOW_SIZE - 1)];
+                }
+                insert(i);
+            }
+
+            if (bestLength >= MIN_MATCH)
+            {
+                writeMatch(writer, bestLength, bestDistance);
+                for (size_t j = i + 1; j < i + bestLength; ++j)
+                    if (j + MIN_MATCH <= length)
+                        insert(j);
+                i += bestLength;
+            }
+            else
+            {
+                writeSymbol(writer, data[i]);
+                ++i;
+            }
+        }
+        writeSymbol(writer, 256);  // end of block
+        writer.flush();
+    }
+
+    // ---- PNG ----
+
+    void put32(vector<uint8_t>& out, uint32_t value)
+    {
+        out.push_back((uint8_t)(value >> 24));
+        out.push_back((uint8_t)(value >> 16));
+        out.push_back((uint8_t)(value >> 8));
+        out.push_back((uint8_t)value);
+    }
+
+    void writeChunk(vector<uint8_t>& out, const char* type, const vector<uint8_t>& data)
+    {
+        put32(out, (uint32_t)data.size());
+        size_t typeStart = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        put32(out, crc32(&out[typeStart], out.size() - typeStart));
+    }
+
+    uint8_t paeth(int a, int b, int c)
+    {
+        int p = a + b - c;
+        int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+        if (pa <= pb && pa <= pc)
+            return (uint8_t)a;
+        return (uint8_t)(pb <= pc ? b : c);
+    }
+
+    // Applies filter type to one row; prior is null for the first row
+    void filterRow(int type, const uint8_t* row, const uint8_t* prior, size_t length, int bpp, uint8_t* out)
+    {
+        for (size_t x = 0; x < length; ++x)
+        {
+            int a = x >= (size_t)bpp ? row[x - bpp] : 0;
+            int b = prior ? prior[x] : 0;
+            int c = (prior && x >= (size_t)bpp) ? prior[x - bpp] : 0;
+            int predicted = 0;
+            if (type == 1)
+                predicted = a;
+            else if (type == 2)
+                predicted = b;
+            else if (type == 3)
+                predicted = (a + b) / 2;
+            else if (type == 4)
+                predicted = paeth(a, b, c);
+            out[x] = (uint8_t)(row[x] - predicted);
+        }
+    }
+}
+
+vector<uint8_t> ImageWriter::encodePng(const uint8_t* pixels, int width, int height, int channels, bool bottomUp, int effort)
+{
+    // each row gets the filter with the smallest sum of absolute differences
+    size_t rowBytes = (size_t)width * channels;
+    vector<uint8_t> filtered((rowBytes + 1) * height);
+    vector<uint8_t> candidate(rowBytes);
+    for (int y = 0; y < height; ++y)
+    {
+        int sourceRow = bottomUp ? height - 1 - y : y;
+        int priorRow = bottomUp ? sourceRow + 1 : sourceRow - 1;
+        const uint8_t* row = pixels + (size_t)sourceRow * rowBytes;
+        const uint8_t* prior = (y > 0) ? pixels + (size_t)priorRow * rowBytes : nullptr;
+        uint8_t* out = &filtered[y * (rowBytes + 1)];
+
+        unsigned long bestScore = ~0ul;
+        // uncompressed output gains nothing from filtering
+        int lastType = (effort > 0) ? 4 : 0;
+        for (int type = 0; type <= lastType; ++type)
+        {
+            filterRow(type, row, prior, rowBytes, channels, candidate.data());
+            unsigned long score = 0;
+            for (size_t x = 0; x < rowBytes; ++x)
+                score += (unsigned long)abs((int)(int8_t)candidate[x]);
+            if (score < bestScore)
+            {
+                bestScore = score;
+                out[0] = (uint8_t)type;
+                memcpy(out + 1, candidate.data(), rowBytes);
+            }
+        }
+    }
+
+    vector<uint8_t> zlib;
+    zlib.reserve(filtered.size() / 2 + 64);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    if (effort > 0)
+        deflateFixed(filtered.data(), filtered.size(), effort, zlib);
+    else
+        deflateStored(filtered.data(), filtered.size(), zlib);
+    put32(zlib, adler32(filtered.data(), filtered.size()));
+
+    vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    vector<uint8_t> header;
+    put32(header, (uint32_t)width);
+    put32(header, (uint32_t)height);
+    header.push_back(8);                         // bit depth
+    header.push_back(channels == 4 ? 6 : 2);     // RGBA or RGB
+    header.push_back(0);                         // deflate
+    header.push_back(0);                         // adaptive filtering
+    header.push_back(0);                         // no interlace
+    writeChunk(png, "IHDR", header);
+    writeChunk(png, "IDAT", zlib);
+    writeChunk(png, "IEND", vector<uint8_t>());
+    return png;
+}
+
+bool ImageWriter::writeFile(const string& path, const vector<uint8_t>& data)
+{
+    ofstream file(path, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open())
+    {
+        cout << "Could not write image " << path << endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+bool ImageWriter::writePng(const string& path, const uint8_t* pixels, int width, int height, int channels, bool bottomUp, int effort)
+{
+    return writeFile(path, encodePng(pixels, width, height, channels, bottomUp, effort));
+}
+
+bool ImageWriter::writeRaw(const string& path, const uint8_t* pixels, int width, int height, int channels)
+{
+    ofstream file(path, ios::out | ios::binary | ios::trunc);
+    if (!file.is_open())
+    {
+        cout << "Could not write image " << path << endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(pixels), (size_t)width * height * channels);
+    cout << "Raw image " << path << ": " << width << "x" << height << ", " << channels << " channels, 8 bits" << endl;
+    return static_cast<bool>(file);
+}
+
+bool ImageWriter::write(const string& path, const uint8_t* pixels, int width, int height, int channels, bool bottomUp)
+{
+    size_t dot = path.find_last_of('.');
+    string extension = (dot == string::npos) ? string() : path.substr(dot);
+    if (extension == ".png" || extension == ".PNG")
+        return writePng(path, pixels, width, height, channels, bottomUp);
+    if (!bottomUp)
+        return writeRaw(path, pixels, width, height, channels);
+
+    // raw files are stored top row first, same as the PNGs
+    size_t rowBytes = (size_t)width * channels;
+    vector<uint8_t> flipped(rowBytes * height);
+    for (int y = 0; y < height; ++y)
+        memcpy(&flipped[y * rowBytes], pixels + (size_t)(height - 1 - y) * rowBytes, rowBytes);
+    return writeRaw(path, flipped.data(), width, height, channels);
+}
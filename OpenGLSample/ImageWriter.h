@@ -0,0 +1,31 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ImageWriter.h                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Saves rendered frames as PNG or raw RGBA files. The PNG encoder is self    //
+// contained (filtering, LZ77 and fixed Huffman deflate) and safe to call from any thread. //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Encodes and writes 8 bit per channel images
+class ImageWriter
+{
+public:
+    // Compresses tightly packed rows into a PNG file in memory. channels is 3 (RGB) or
+    // 4 (RGBA); set bottomUp for glReadPixels output so the file is stored top row first.
+    // effort is the longest match chain searched, 0 stores the data uncompressed
+    static std::vector<uint8_t> encodePng(const uint8_t* pixels, int width, int height, int channels,
+        bool bottomUp, int effort = 16);
+    static bool writePng(const std::string& path, const uint8_t* pixels, int width, int height, int channels,
+        bool bottomUp, int effort = 16);
+    // Rows as they are in memory, no header; the size goes in the console message
+    static bool writeRaw(const std::string& path, const uint8_t* pixels, int width, int height, int channels);
+    // Picks PNG or raw from the file extension
+    static bool write(const std::string& path, const uint8_t* pixels, int width, int height, int channels, bool bottomUp);
+
+    static bool writeFile(const std::string& path, const std::vector<uint8_t>& data);
+};
@@ -0,0 +1,243 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: InputLog.cpp                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Records every input event and polled key state into a compact binary log, //
+// tagged with the simulation step and time it arrived at, and plays a log back so a       //
+// session runs again step for step with a fixed time step.                                //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "InputLog.h"
+#include <cstring>
+#include <iostream>
+using namespace std; // Standard namespace
+
+/*
+  File layout, little endian as written by the recording machine:
+
+    header:  "OGIL" | uint32 version | float64 step seconds
+    event:   uint8 type | uint32 step | float32 time | payload
+
+  Payloads: mouse and scroll are two float64, key is two int16, key state is a uint32
+  mask, frame is a float32 alpha. A typical event is 9 to 25 bytes.
+*/
+namespace
+{
+    const char MAGIC[4] = { 'O', 'G', 'I', 'L' };
+    const uint32_t VERSION = 1;
+
+    template <typename T>
+    void put(ofstream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    bool get(ifstream& in, T& value)
+    {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+}
+
+bool InputLog::startRecording(const string& path, double stepSeconds, double now)
+{
+    output.open(path, ios::out | ios::binary | ios::trunc);
+    if (!output.is_open())
+    {
+        cout << "Could not create input log " << path << endl;
+        return false;
+    }
+    output.write(MAGIC, sizeof(MAGIC));
+    put(output, VERSION);
+    put(output, stepSeconds);
+
+    mode = RECORD;
+    logPath = path;
+    logStepSeconds = stepSeconds;
+    startTime = now;
+    lastKeys = 0;
+    return true;
+}
+
+void InputLog::write(const InputEvent& event)
+{
+    put(output, (uint8_t)event.type);
+    put(output, event.step);
+    put(output, (float)(event.time - startTime));
+    switch (event.type)
+    {
+    case InputEvent::MOUSE_MOVE:
+    case InputEvent::SCROLL:
+        put(output, event.x);
+        put(output, event.y);
+        break;
+    case InputEvent::KEY:
+        put(output, (int16_t)event.key);
+        put(output, (int16_t)event.action);
+        break;
+    case InputEvent::KEY_STATE:
+        put(output, event.keys);
+        break;
+    case InputEvent::FRAME:
+        put(output, (float)event.x);
+        break;
+    }
+    ++eventCount;
+}
+
+void InputLog::recordMouse(uint32_t step, double now, double x, double y)
+{
+    InputEvent event;
+    event.type = InputEvent::MOUSE_MOVE;
+    event.step = step;
+    event.time = now;
+    event.x = x;
+    event.y = y;
+    write(event);
+}
+
+void InputLog::recordScroll(uint32_t step, double now, double x, double y)
+{
+    InputEvent event;
+    event.type = InputEvent::SCROLL;
+    event.step = step;
+    event.time = now;
+    event.x = x;
+    event.y = y;
+    write(event);
+}
+
+void InputLog::recordKey(uint32_t step, double now, int key, int action)
+{
+    InputEvent event;
+    event.type = InputEvent::KEY;
+    event.step = step;
+    event.time = now;
+    event.key = key;
+    event.action = action;
+    write(event);
+}
+
+void InputLog::recordKeyState(uint32_t step, double now, uint32_t keys)
+{
+    if (keys == lastKeys)
+        return;
+    lastKeys = keys;
+
+    InputEvent event;
+    event.type = InputEvent::KEY_STATE;
+    event.step = step;
+    event.time = now;
+    event.keys = keys;
+    write(event);
+}
+
+void InputLog::recordFrame(uint32_t step, double now, float alpha)
+{
+    InputEvent event;
+    event.type = InputEvent::FRAME;
+    event.step = step;
+    event.time = now;
+    event.x = alpha;
+    write(event);
+}
+
+bool InputLog::startReplay(const string& path)
+{
+    input.open(path, ios::in | ios::binary);
+    if (!input.is_open())
+    {
+        cout << "Could not open input log " << path << endl;
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!input.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+        || !get(input, version) || version != VERSION || !get(input, logStepSeconds) || logStepSeconds <= 0.0)
+    {
+        cout << path << " is not a version " << VERSION << " input log" << endl;
+        input.close();
+        return false;
+    }
+
+    mode = REPLAY;
+    logPath = path;
+    hasPending = false;
+    return true;
+}
+
+bool InputLog::read(InputEvent& event)
+{
+    event = InputEvent();
+    uint8_t type = 0;
+    float time = 0.0f;
+    if (!get(input, type) || !get(input, event.step) || !get(input, time))
+        return false;
+    event.type = (InputEvent::Type)type;
+    event.time = time;
+
+    bool ok = true;
+    switch (event.type)
+    {
+    case InputEvent::MOUSE_MOVE:
+    case InputEvent::SCROLL:
+        ok = get(input, event.x) && get(input, event.y);
+        break;
+    case InputEvent::KEY:
+    {
+        int16_t key = 0, action = 0;
+        ok = get(input, key) && get(input, action);
+        event.key = key;
+        event.action = action;
+        break;
+    }
+    case InputEvent::KEY_STATE:
+        ok = get(input, event.keys);
+        break;
+    case InputEvent::FRAME:
+    {
+        float alpha = 0.0f;
+        ok = get(input, alpha);
+        event.x = alpha;
+        break;
+    }
+    default:
+        cout << logPath << ": unknown event type " << (int)type << ", stopping replay" << endl;
+        return false;
+    }
+    if (ok)
+        ++eventCount;
+    return ok;
+}
+
+const InputEvent* InputLog::peek()
+{
+    if (!hasPending)
+        hasPending = replaying() && read(pending);
+    return hasPending ? &pending : nullptr;
+}
+
+bool InputLog::next(InputEvent& event)
+{
+    if (peek() == nullptr)
+        return false;
+    event = pending;
+    hasPending = false;
+    return true;
+}
+
+void InputLog::close()
+{
+    if (mode == RECORD)
+    {
+        output.close();
+        cout << "Recorded " << eventCount << " input events to " << logPath << endl;
+    }
+    else if (mode == REPLAY)
+    {
+        input.close();
+        cout << "Replayed " << eventCount << " input events from " << logPath << endl;
+    }
+    mode = OFF;
+}
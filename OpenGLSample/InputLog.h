@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: InputLog.h                                                                         //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Records every input event and polled key state into a compact binary log, //
+// tagged with the simulation step and time it arrived at, and plays a log back so a       //
+// session runs again step for step with a fixed time step.                                //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// One entry of the log
+struct InputEvent
+{
+    enum Type : uint8_t
+    {
+        MOUSE_MOVE = 1,  // x, y = cursor position
+        SCROLL = 2,      // x, y = scroll offsets
+        KEY = 3,         // key, action from the key callback
+        KEY_STATE = 4,   // keys = bit mask of the keys processInput polls, sent when it changes
+        FRAME = 5,       // a rendered frame; step = steps taken so far, x = interpolation alpha
+    };
+
+    Type type = MOUSE_MOVE;
+    uint32_t step = 0;   // simulation step the event belongs to
+    double time = 0.0;   // seconds since recording started
+    double x = 0.0;
+    double y = 0.0;
+    int32_t key = 0;
+    int32_t action = 0;
+    uint32_t keys = 0;
+};
+
+// Writes or reads an input log, one direction at a time
+class InputLog
+{
+public:
+    bool recording() const { return mode == RECORD; }
+    bool replaying() const { return mode == REPLAY; }
+
+    // Starts a new log; the step length is saved so replay uses the same fixed delta time
+    bool startRecording(const std::string& path, double stepSeconds, double now);
+    void recordMouse(uint32_t step, double now, double x, double y);
+    void recordScroll(uint32_t step, double now, double x, double y);
+    void recordKey(uint32_t step, double now, int key, int action);
+    // Polled key mask for a simulation step, only written when it changed
+    void recordKeyState(uint32_t step, double now, uint32_t keys);
+    void recordFrame(uint32_t step, double now, float alpha);
+
+    // Opens a log for playback, returns false if it is missing or not an input log
+    bool startReplay(const std::string& path);
+    double stepSeconds() const { return logStepSeconds; }
+    // Next event in log order, false at the end of the log
+    bool next(InputEvent& event);
+    // Looks at the next event without consuming it
+    const InputEvent* peek();
+
+    // Flushes and closes the log and prints what was written or read
+    void close();
+
+private:
+    enum Mode
+    {
+        OFF,
+        RECORD,
+        REPLAY,
+    };
+
+    void write(const InputEvent& event);
+    bool read(InputEvent& event);
+
+    Mode mode = OFF;
+    std::string logPath;
+    std::ofstream output;
+    std::ifstream input;
+    double logStepSeconds = 0.0;
+    double startTime = 0.0;
+    uint32_t lastKeys = 0;
+
+    InputEvent pending;
+    bool hasPending = false;
+    unsigned long long eventCount = 0;
+};
@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: Materials.cpp                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Table of the surface materials of the scene: textures, shininess and UV    //
+// scale, registered once with identical materials sharing an ID, so draws can refer to    //
+// them by ID and switch only when it changes.                                              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Materials.h"
+#include <algorithm>
+#include <iostream>
+using namespace std; // Standard namespace
+
+// A scene has a few dozen materials, registered once, so a linear search is all it takes
+Materials::Id Materials::add(const Material& material)
+{
+    ++registrations;
+    auto found = find(table.begin(), table.end(), material);
+    if (found != table.end())
+        return (Id)(found - table.begin());
+    if (table.size() >= NONE)
+    {
+        cout << "Too many materials, using the first one" << endl;
+        return 0;
+    }
+    table.push_back(material);
+    return (Id)(table.size() - 1);
+}
+
+void Materials::clear()
+{
+    table.clear();
+    registrations = 0;
+}
+
+void Materials::printStats() const
+{
+    cout << "Materials: " << registrations << " registered, " << table.size() << " unique" << endl;
+}
@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: Materials.h                                                                        //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Table of the surface materials of the scene: textures, shininess and UV    //
+// scale, registered once with identical materials sharing an ID, so draws can refer to    //
+// them by ID and switch only when it changes.                                              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// What the lit shader needs from a surface; a texture of 0 leaves its unit unbound
+struct Material
+{
+    GLuint diffuse = 0;
+    GLuint specular = 0;
+    GLuint overlay = 0;
+    float shininess = 2.0f;
+    glm::vec2 uvScale = glm::vec2(1.0f, 1.0f);
+
+    bool operator==(const Material& other) const
+    {
+        return diffuse == other.diffuse && specular == other.specular && overlay == other.overlay
+            && shininess == other.shininess && uvScale == other.uvScale;
+    }
+};
+
+// IDs are indices into the table, in registration order of the first of each material
+class Materials
+{
+public:
+    typedef uint16_t Id;
+    static const Id NONE = 0xFFFF;
+
+    // The ID of an identical material when there is one, otherwise a new ID
+    Id add(const Material& material);
+    const Material& get(Id id) const { return table[id]; }
+    size_t size() const { return table.size(); }
+    void clear();
+
+    void printStats() const;
+
+private:
+    std::vector<Material> table;
+    int registrations = 0;
+};
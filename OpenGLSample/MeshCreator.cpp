@@ -7,6 +7,8 @@
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "MeshCreator.h"
+#include "CpuProfiler.h"
+#include "RenderStats.h"
 #include <glm/gtx/transform.hpp> // pi
 #include <glm/glm.hpp>
 #include <vector>
@@ -15,29 +17,51 @@
 // Creates mesh data for shapes
 void MeshCreator::createMeshes()
 {
-    makePlaneMesh(gPlaneMesh);
-    makePyramidMesh(gPyramidMesh);
-    makeFrustumPyramidMesh(gFrustumPyramidMesh);
-    makeCylinderMesh(gCylinderMesh);
-    makeCubeMesh(gCubeMesh);
-    makeSphereMesh(gSphereMesh);
-    makeTorusMesh(gTorusMesh);
-    makeConeMesh(gConeMesh);
-    makeSkyboxMesh(gSkyboxMesh);
+    PROFILE_ZONE("MeshCreator::createMeshes");
+    for (int kind = 0; kind < MESH_COUNT; ++kind)
+        createMesh((Kind)kind);
 }
 
 // Releases mesh data
 void MeshCreator::destroyMeshes() 
 {
-    destroyMesh(gPlaneMesh);
-    destroyMesh(gPyramidMesh);
-    destroyMesh(gFrustumPyramidMesh);
-    destroyMesh(gCylinderMesh);
-    destroyMesh(gCubeMesh);
-    destroyMesh(gSphereMesh);
-    destroyMesh(gTorusMesh);
-    destroyMesh(gConeMesh);
-    destroyMesh(gSkyboxMesh);
+    for (int kind = 0; kind < MESH_COUNT; ++kind)
+        destroyMesh((Kind)kind);
+}
+
+// Creates one mesh, noting how much it uploaded
+void MeshCreator::createMesh(Kind kind)
+{
+    uint64_t uploaded = RenderStats::current().bufferBytes;
+    GLMesh& created = mesh(kind);
+    switch (kind)
+    {
+    case PLANE: makePlaneMesh(created); break;
+    case PYRAMID: makePyramidMesh(created); break;
+    case FRUSTUM_PYRAMID: makeFrustumPyramidMesh(created); break;
+    case CYLINDER: makeCylinderMesh(created); break;
+    case CUBE: makeCubeMesh(created); break;
+    case SPHERE: makeSphereMesh(created); break;
+    case TORUS: makeTorusMesh(created); break;
+    case CONE: makeConeMesh(created); break;
+    default: makeSkyboxMesh(created); break;
+    }
+    created.bytes = (GLuint)(RenderStats::current().bufferBytes - uploaded);
+}
+
+void MeshCreator::destroyMesh(Kind kind)
+{
+    destroyMesh(mesh(kind));
+    mesh(kind) = GLMesh();
+}
+
+MeshCreator::GLMesh& MeshCreator::mesh(Kind kind)
+{
+    GLMesh* meshes[MESH_COUNT] = {
+        &gPlaneMesh, &gPyramidMesh, &gFrustumPyramidMesh, &gCylinderMesh, &gCubeMesh, &gSphereMesh,
+        &gTorusMesh, &gConeMesh, &gSkyboxMesh
+    };
+    return *meshes[kind];
 }
 
 // Creates a plane with vertexes along the x axis
@@ -61,7 +85,7 @@ void MeshCreator::makePlaneMesh(GLMesh& mesh) {
     // Create 2 buffers: first one for the vertex data; second one for the indices
     glGenBuffers(2, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     // Data for the indices
     GLushort indices[] = { 0, 1, 3,  // Triangle 1
@@ -69,7 +93,7 @@ void MeshCreator::makePlaneMesh(GLMesh& mesh) {
     };
     mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    RenderStats::bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Strides between vertex coordinates
     GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
@@ -131,7 +155,7 @@ void MeshCreator::makePyramidMesh(GLMesh& mesh)
 	// Create VBO
 	glGenBuffers(1, mesh.vbos);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
 	// Strides between vertex coordinates
 	GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
@@ -217,7 +241,7 @@ void MeshCreator::makeFrustumPyramidMesh(GLMesh& mesh)
     // Create VBO
     glGenBuffers(1, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     // Strides between vertex coordinates
     GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
@@ -424,11 +448,11 @@ void MeshCreator::makeCylinderMesh(GLMesh& mesh)
     // Create 2 buffers: first one for the vertex data; second one for the indices
     glGenBuffers(2, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    RenderStats::bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Strides between vertex coordinates
     GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
@@ -512,7 +536,7 @@ void MeshCreator::makeCubeMesh(GLMesh& mesh)
     // Create 2 buffers: first one for the vertex data; second one for the indices
     glGenBuffers(1, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     // Strides between vertex coordinates is 8. A tightly packed stride is 0.
     GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);// The number of floats before each
@@ -613,11 +637,11 @@ void MeshCreator::makeSphereMesh(GLMesh& mesh)
     // Create 2 buffers: first one for the vertex data; second one for the indices
     glGenBuffers(2, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    RenderStats::bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Strides between vertex coordinates
     GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
@@ -784,7 +808,7 @@ void MeshCreator::makeTorusMesh(GLMesh& mesh)
     // Create 2 buffers: first one for the vertex data;
     glGenBuffers(2, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, vertex_list.size() * sizeof(glm::vec3), &vertex_list[0], GL_STATIC_DRAW);
+    RenderStats::bufferData(GL_ARRAY_BUFFER, vertex_list.size() * sizeof(glm::vec3), &vertex_list[0], GL_STATIC_DRAW);
 
     // Strides between vertex coordinates is 3. A tightly packed stride is 0.
     GLint stride = sizeof(float) * (floatsPerVertex);// The number of floats before each
@@ -794,7 +818,7 @@ void MeshCreator::makeTorusMesh(GLMesh& mesh)
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[1]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, normals_list.size() * sizeof(glm::vec3), &normals_list[0], GL_STATIC_DRAW);
+    RenderStats::bufferData(GL_ARRAY_BUFFER, normals_list.size() * sizeof(glm::vec3), &normals_list[0], GL_STATIC_DRAW);
 
     glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, 0);
     glEnableVertexAttribArray(1);
@@ -908,11 +932,11 @@ void MeshCreator::makeConeMesh(GLMesh& mesh) {
     // Create 2 buffers: first one for the vertex data; second one for the indices
     glGenBuffers(2, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.vbos[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    RenderStats::bufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
     // Strides between vertex coordinates
     GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerUV);
@@ -984,7 +1008,7 @@ void MeshCreator::makeSkyboxMesh(GLMesh& mesh) {
     // Create VBO
     glGenBuffers(1, mesh.vbos);
     glBindBuffer(GL_ARRAY_BUFFER, mesh.vbos[0]); // Activates the buffer
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+    RenderStats::bufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
 
     // Strides between vertex coordinates
     GLint stride = sizeof(float) * (floatsPerVertex);
@@ -12,6 +12,7 @@
 // Creates mesh for various 3D shapes like primitives and a frustum pyramid
 class MeshCreator
 {
+public:
     // Stores the GL data relative to a given mesh
     struct GLMesh
     {
@@ -19,9 +20,16 @@ class MeshCreator
         GLuint vbos[2];     // Handles for the vertex buffer objects
         GLuint nVertices;	// Number of vertices for the mesh
         GLuint nIndices;    // Number of indices of the mesh
+        GLuint bytes;       // Vertex and index data uploaded for the mesh
+    };
+
+    // Every mesh it can create, in the order createMeshes creates them
+    enum Kind
+    {
+        PLANE, PYRAMID, FRUSTUM_PYRAMID, CYLINDER, CUBE, SPHERE, TORUS, CONE, SKYBOX,
+        MESH_COUNT
     };
 
-public:
     GLMesh gPlaneMesh;
     GLMesh gPyramidMesh;
     GLMesh gFrustumPyramidMesh;
@@ -36,6 +44,11 @@ public:
     void createMeshes();
     void destroyMeshes();
 
+    // Creates or destroys a single mesh, for creating them as they are needed
+    void createMesh(Kind kind);
+    void destroyMesh(Kind kind);
+    GLMesh& mesh(Kind kind);
+
 private:
     void makePlaneMesh(GLMesh& mesh);
     void makePyramidMesh(GLMesh& mesh);
@@ -0,0 +1,43 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: OffscreenTarget.cpp                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Framebuffer the scene renders into when there is no visible window, for   //
+// benchmarks and headless image output. Multisampled targets are resolved before reading. //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "OffscreenTarget.h"
+using namespace std; // Standard namespace
+
+bool OffscreenTarget::create(int width, int height, int samples)
+{
+    if (!target.create(width, height, samples))
+        return false;
+    if (samples > 1)
+        return resolved.create(width, height, 0);
+    return true;
+}
+
+void OffscreenTarget::destroy()
+{
+    target.destroy();
+    resolved.destroy();
+}
+
+GLuint OffscreenTarget::resolve()
+{
+    if (target.samples <= 1)
+        return target.fbo;
+    target.blitTo(resolved.fbo, target.width, target.height, resolved.width, resolved.height, GL_NEAREST);
+    return resolved.fbo;
+}
+
+void OffscreenTarget::readPixels(vector<uint8_t>& pixels)
+{
+    GLuint source = resolve();
+    pixels.resize((size_t)target.width * target.height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, target.width, target.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
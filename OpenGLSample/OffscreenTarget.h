@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: OffscreenTarget.h                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Framebuffer the scene renders into when there is no visible window, for   //
+// benchmarks and headless image output. Multisampled targets are resolved before reading. //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "RenderTarget.h"
+
+// Offscreen color and depth target with optional MSAA and a single sample copy for readback
+class OffscreenTarget
+{
+public:
+    bool create(int width, int height, int samples);
+    void destroy();
+
+    // Binds the target for drawing with a full size viewport
+    void bind() const { target.bind(target.width, target.height); }
+    // Framebuffer the frame is drawn into, and that dynamic resolution upscales into
+    GLuint drawFramebuffer() const { return target.fbo; }
+    // Resolves MSAA if there is any and returns the single sample framebuffer to read from
+    GLuint resolve();
+    // Reads the finished frame as tightly packed RGBA, bottom row first
+    void readPixels(std::vector<uint8_t>& pixels);
+
+    int width() const { return target.width; }
+    int height() const { return target.height; }
+    int samples() const { return target.samples; }
+
+private:
+    RenderTarget target;
+    RenderTarget resolved;  // only used when target is multisampled
+};
@@ -0,0 +1,609 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: PathTracer.cpp                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Offline path tracer for reference stills. It traces the scene one frame    //
+// of draws describes, with a SAH BVH, SSE box tests and progressive accumulation spread   //
+// over every core in screen tiles.                                                         //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "PathTracer.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Moves secondary ray origins off the surface they start on
+    const float RAY_OFFSET = 1e-3f;
+    const float PI = 3.14159265f;
+
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint32_t hashSeed(uint32_t value)
+    {
+        value = (value ^ 61u) ^ (value >> 16);
+        value *= 9u;
+        value ^= value >> 4;
+        value *= 0x27d4eb2du;
+        value ^= value >> 15;
+        return value != 0 ? value : 1u;
+    }
+
+    // xorshift32, uniform in [0, 1)
+    float random(uint32_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Cosine weighted direction around the normal, the pdf cancels the Lambert cosine
+    glm::vec3 cosineSample(const glm::vec3& normal, uint32_t& rng)
+    {
+        float angle = 2.0f * PI * random(rng);
+        float radiusSquared = random(rng);
+        float radius = sqrt(radiusSquared);
+        glm::vec3 tangent = glm::normalize(glm::cross(fabs(normal.x) > 0.1f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), normal));
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        return glm::normalize(tangent * (cos(angle) * radius) + bitangent * (sin(angle) * radius) + normal * sqrt(1.0f - radiusSquared));
+    }
+
+    // Slab test of one box against the ray, all three axes at once
+    bool hitBox(const float* boundsMin, const float* boundsMax, __m128 origin, __m128 inverseDirection, float maxDistance, float& entry)
+    {
+        __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(boundsMin), origin), inverseDirection);
+        __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(boundsMax), origin), inverseDirection);
+        __m128 nearT = _mm_min_ps(t0, t1);
+        __m128 farT = _mm_max_ps(t0, t1);
+        nearT = _mm_max_ps(nearT, _mm_shuffle_ps(nearT, nearT, _MM_SHUFFLE(2, 3, 0, 1)));
+        nearT = _mm_max_ps(nearT, _mm_shuffle_ps(nearT, nearT, _MM_SHUFFLE(1, 0, 3, 2)));
+        farT = _mm_min_ps(farT, _mm_shuffle_ps(farT, farT, _MM_SHUFFLE(2, 3, 0, 1)));
+        farT = _mm_min_ps(farT, _mm_shuffle_ps(farT, farT, _MM_SHUFFLE(1, 0, 3, 2)));
+        entry = _mm_cvtss_f32(nearT);
+        float exit = _mm_cvtss_f32(farT);
+        return entry <= exit && exit >= 0.0f && entry < maxDistance;
+    }
+
+    struct Bounds
+    {
+        glm::vec3 low = glm::vec3(FLT_MAX);
+        glm::vec3 high = glm::vec3(-FLT_MAX);
+
+        void grow(const glm::vec3& point)
+        {
+            low = glm::min(low, point);
+            high = glm::max(high, point);
+        }
+        void grow(const Bounds& other)
+        {
+            low = glm::min(low, other.low);
+            high = glm::max(high, other.high);
+        }
+        float area() const
+        {
+            if (low.x > high.x)
+                return 0.0f;
+            glm::vec3 size = high - low;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+    };
+
+    float specularTerm(const glm::vec3& lightDir, const glm::vec3& normal, const glm::vec3& viewDir, float shininess)
+    {
+        glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+        return pow(max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    }
+}
+
+PathTracer::PathTracer(unsigned threadCount)
+    : pool(threadCount > 1 ? threadCount - 1 : threadCount, "Path tracer")
+{
+}
+
+void PathTracer::beginScene()
+{
+    triangles.clear();
+    materials.clear();
+    nodes.clear();
+    sky.reset();
+    lit = false;
+}
+
+// Same vertex stage as the rasterizer: world positions, normal matrix and texture coordinates
+void PathTracer::addDraw(const SoftwareDraw& draw)
+{
+    if (draw.shader == SoftwareShader::Skybox)
+    {
+        sky = draw.cubeMap;
+        return;
+    }
+    if (!draw.position.data || draw.count < 3)
+        return;
+    if (draw.shader == SoftwareShader::Phong)
+    {
+        lighting = draw;
+        lit = true;
+    }
+
+    Material material;
+    material.diffuse = draw.diffuse;
+    material.specular = draw.specular;
+    material.overlay = draw.overlay;
+    material.uvScale = draw.uvScale;
+    material.shininess = draw.shininess;
+    int materialIndex = (int)materials.size();
+    materials.push_back(material);
+
+    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(draw.model)));
+    for (int i = 0; i + 2 < draw.count; i += 3)
+    {
+        Triangle triangle;
+        glm::vec3 corners[3];
+        bool valid = true;
+        for (int k = 0; k < 3 && valid; ++k)
+        {
+            size_t index = draw.vertexIndex(i + k);
+            if (index >= draw.vertexCount)
+            {
+                valid = false;
+                break;
+            }
+            const float* p = (const float*)(draw.position.data + index * draw.position.stride);
+            corners[k] = glm::vec3(draw.model * glm::vec4(p[0], p[1], p[2], 1.0f));
+            triangle.normals[k] = glm::vec3(0.0f);
+            if (draw.normal.data)
+            {
+                const float* n = (const float*)(draw.normal.data + index * draw.normal.stride);
+                triangle.normals[k] = normalMatrix * glm::vec3(n[0], n[1], n[2]);
+            }
+            triangle.uvs[k] = glm::vec2(0.0f);
+            if (draw.texCoords.data)
+            {
+                const float* t = (const float*)(draw.texCoords.data + index * draw.texCoords.stride);
+                triangle.uvs[k] = glm::vec2(t[0], t[1]);
+            }
+        }
+        if (!valid)
+            continue;
+        triangle.v0 = corners[0];
+        triangle.edge1 = corners[1] - corners[0];
+        triangle.edge2 = corners[2] - corners[0];
+        if (glm::length(glm::cross(triangle.edge1, triangle.edge2)) == 0.0f)
+            continue;
+        triangle.material = materialIndex;
+        triangle.emissive = draw.shader == SoftwareShader::Flat;
+        triangles.push_back(triangle);
+    }
+}
+
+// Binned SAH split; returns the index of the new node
+int PathTracer::buildNode(vector<int>& order, const vector<glm::vec3>& centroids, int first, int count)
+{
+    Bounds bounds, centroidBounds;
+    for (int i = first; i < first + count; ++i)
+    {
+        const Triangle& triangle = triangles[order[i]];
+        bounds.grow(triangle.v0);
+        bounds.grow(triangle.v0 + triangle.edge1);
+        bounds.grow(triangle.v0 + triangle.edge2);
+        centroidBounds.grow(centroids[order[i]]);
+    }
+
+    int index = (int)nodes.size();
+    nodes.push_back(Node());
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        nodes[index].boundsMin[axis] = bounds.low[axis];
+        nodes[index].boundsMax[axis] = bounds.high[axis];
+    }
+    // the padding lane never limits the interval
+    nodes[index].boundsMin[3] = -FLT_MAX;
+    nodes[index].boundsMax[3] = FLT_MAX;
+    nodes[index].first = first;
+    nodes[index].count = count;
+    if (count <= 2)
+        return index;
+
+    // cost in triangle tests, a traversal step counts as one
+    float bestCost = FLT_MAX;
+    int bestAxis = -1, bestSplit = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float low = centroidBounds.low[axis];
+        float extent = centroidBounds.high[axis] - low;
+        if (extent <= 0.0f)
+            continue;
+        Bounds binBounds[SAH_BINS];
+        int binCounts[SAH_BINS] = {};
+        for (int i = first; i < first + count; ++i)
+        {
+            const Triangle& triangle = triangles[order[i]];
+            int bin = min(SAH_BINS - 1, (int)((centroids[order[i]][axis] - low) / extent * SAH_BINS));
+            ++binCounts[bin];
+            binBounds[bin].grow(triangle.v0);
+            binBounds[bin].grow(triangle.v0 + triangle.edge1);
+            binBounds[bin].grow(triangle.v0 + triangle.edge2);
+        }
+        // sweep from the right, then evaluate each plane from the left
+        float rightArea[SAH_BINS];
+        int rightCount[SAH_BINS];
+        Bounds sweep;
+        int sweepCount = 0;
+        for (int bin = SAH_BINS - 1; bin > 0; --bin)
+        {
+            sweep.grow(binBounds[bin]);
+            sweepCount += binCounts[bin];
+            rightArea[bin] = sweep.area();
+            rightCount[bin] = sweepCount;
+        }
+        sweep = Bounds();
+        sweepCount = 0;
+        for (int split = 1; split < SAH_BINS; ++split)
+        {
+            sweep.grow(binBounds[split - 1]);
+            sweepCount += binCounts[split - 1];
+            float cost = sweep.area() * sweepCount + rightArea[split] * rightCount[split];
+            if (sweepCount > 0 && rightCount[split] > 0 && cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    float leafCost = (float)count;
+    float splitCost = 1.0f + bestCost / bounds.area();
+    if (bestAxis < 0 || (splitCost >= leafCost && count <= MAX_LEAF_SIZE))
+        return index;
+
+    float low = centroidBounds.low[bestAxis];
+    float extent = centroidBounds.high[bestAxis] - low;
+    int* middle = partition(&order[first], &order[first] + count, [&](int triangle) {
+        return min(SAH_BINS - 1, (int)((centroids[triangle][bestAxis] - low) / extent * SAH_BINS)) < bestSplit;
+    });
+    int leftCount = (int)(middle - &order[first]);
+
+    nodes[index].count = 0;
+    buildNode(order, centroids, first, leftCount);
+    int right = buildNode(order, centroids, first + leftCount, count - leftCount);
+    nodes[index].first = right;
+    return index;
+}
+
+// Closest hit, or with shadow set any hit that isn't a lamp
+bool PathTracer::intersect(const Ray& ray, float maxDistance, bool shadow, Hit& hit) const
+{
+    __m128 origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+    __m128 inverseDirection = _mm_setr_ps(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z, 1.0f);
+    hit.t = maxDistance;
+    bool found = false;
+
+    int stack[64];
+    int depth = 0;
+    int node = 0;
+    float entry;
+    if (!hitBox(nodes[0].boundsMin, nodes[0].boundsMax, origin, inverseDirection, maxDistance, entry))
+        return false;
+    while (true)
+    {
+        const Node& current = nodes[node];
+        if (current.count > 0)
+        {
+            for (int i = current.first; i < current.first + current.count; ++i)
+            {
+                const Triangle& triangle = triangles[i];
+                if (shadow && triangle.emissive)
+                    continue;
+                // Moller-Trumbore
+                glm::vec3 p = glm::cross(ray.direction, triangle.edge2);
+                float determinant = glm::dot(triangle.edge1, p);
+                if (fabs(determinant) < 1e-12f)
+                    continue;
+                float inverse = 1.0f / determinant;
+                glm::vec3 s = ray.origin - triangle.v0;
+                float u = glm::dot(s, p) * inverse;
+                if (u < 0.0f || u > 1.0f)
+                    continue;
+                glm::vec3 q = glm::cross(s, triangle.edge1);
+                float v = glm::dot(ray.direction, q) * inverse;
+                if (v < 0.0f || u + v > 1.0f)
+                    continue;
+                float t = glm::dot(triangle.edge2, q) * inverse;
+                if (t <= 0.0f || t >= hit.t)
+                    continue;
+                if (shadow)
+                    return true;
+                hit.t = t;
+                hit.u = u;
+                hit.v = v;
+                hit.triangle = i;
+                found = true;
+            }
+        }
+        else
+        {
+            // visit the nearer child first and keep the other for later
+            int left = node + 1, right = current.first;
+            float leftEntry, rightEntry;
+            bool hitLeft = hitBox(nodes[left].boundsMin, nodes[left].boundsMax, origin, inverseDirection, hit.t, leftEntry);
+            bool hitRight = hitBox(nodes[right].boundsMin, nodes[right].boundsMax, origin, inverseDirection, hit.t, rightEntry);
+            if (hitLeft && hitRight)
+            {
+                if (rightEntry < leftEntry)
+                    swap(left, right);
+                stack[depth++] = right;
+                node = left;
+                continue;
+            }
+            if (hitLeft || hitRight)
+            {
+                node = hitLeft ? left : right;
+                continue;
+            }
+        }
+        if (depth == 0)
+            break;
+        node = stack[--depth];
+    }
+    return found;
+}
+
+glm::vec3 PathTracer::environment(const glm::vec3& direction, bool cameraRay) const
+{
+    if (sky)
+        return glm::vec3(sky->sampleCube(direction));
+    // without a sky, bounced rays see the directional light's ambient term
+    return cameraRay ? background : lighting.dirLight.ambient;
+}
+
+// The Phong terms of 6.multiple_lights.fs, each light tested with a shadow ray
+glm::vec3 PathTracer::directLight(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& viewDir,
+    const glm::vec3& albedo, const glm::vec3& specularMap, float shininess, uint64_t& rays) const
+{
+    glm::vec3 result(0.0f);
+    Hit blocker;
+
+    const SoftwareDraw::DirLight& sun = lighting.dirLight;
+    glm::vec3 lightDir = glm::normalize(-sun.direction);
+    float diff = max(glm::dot(normal, lightDir), 0.0f);
+    if (diff > 0.0f)
+    {
+        ++rays;
+        if (!intersect(Ray{ position, lightDir }, FLT_MAX, true, blocker))
+            result += sun.diffuse * diff * albedo + sun.specular * specularTerm(lightDir, normal, viewDir, shininess) * specularMap;
+    }
+
+    for (const SoftwareDraw::PointLight& light : lighting.pointLights)
+    {
+        glm::vec3 toLight = light.position - position;
+        float distance = glm::length(toLight);
+        lightDir = toLight / distance;
+        diff = max(glm::dot(normal, lightDir), 0.0f);
+        if (diff <= 0.0f || light.intensity <= 0.0f)
+            continue;
+        ++rays;
+        if (intersect(Ray{ position, lightDir }, distance, true, blocker))
+            continue;
+        float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+        result += light.intensity * attenuation
+            * (light.diffuse * diff * albedo + light.specular * specularTerm(lightDir, normal, viewDir, shininess) * specularMap);
+    }
+
+    const SoftwareDraw::SpotLight& spot = lighting.spotLight;
+    glm::vec3 toSpot = spot.position - position;
+    float distance = glm::length(toSpot);
+    lightDir = toSpot / distance;
+    diff = max(glm::dot(normal, lightDir), 0.0f);
+    float theta = glm::dot(lightDir, glm::normalize(-spot.direction));
+    float intensity = glm::clamp((theta - spot.outerCutOff) / (spot.cutOff - spot.outerCutOff), 0.0f, 1.0f);
+    if (diff > 0.0f && intensity > 0.0f && spot.diffuse != glm::vec3(0.0f))
+    {
+        ++rays;
+        if (!intersect(Ray{ position, lightDir }, distance, true, blocker))
+        {
+            float attenuation = 1.0f / (spot.constant + spot.linear * distance + spot.quadratic * (distance * distance));
+            result += attenuation * intensity
+                * (spot.diffuse * diff * albedo + spot.specular * specularTerm(lightDir, normal, viewDir, shininess) * specularMap);
+        }
+    }
+    return result;
+}
+
+glm::vec3 PathTracer::trace(Ray ray, uint32_t& rng, uint64_t& rays) const
+{
+    glm::vec3 radiance(0.0f);
+    glm::vec3 throughput(1.0f);
+    for (int bounce = 0; ; ++bounce)
+    {
+        Hit hit;
+        ++rays;
+        if (!intersect(ray, FLT_MAX, false, hit))
+        {
+            radiance += throughput * environment(ray.direction, bounce == 0);
+            break;
+        }
+        const Triangle& triangle = triangles[hit.triangle];
+        if (triangle.emissive)
+        {
+            // the lamps are drawn plain white; once bounced, their light is already counted
+            if (bounce == 0)
+                radiance += throughput;
+            break;
+        }
+        const Material& material = materials[triangle.material];
+
+        glm::vec3 position = ray.origin + ray.direction * hit.t;
+        glm::vec3 facing = glm::normalize(glm::cross(triangle.edge1, triangle.edge2));
+        if (glm::dot(facing, ray.direction) > 0.0f)
+            facing = -facing;
+        float w = 1.0f - hit.u - hit.v;
+        glm::vec3 normal = triangle.normals[0] * w + triangle.normals[1] * hit.u + triangle.normals[2] * hit.v;
+        float normalLength = glm::length(normal);
+        normal = normalLength > 0.0f ? normal / normalLength : facing;
+        // two sided like the rasterizer, which doesn't cull
+        if (glm::dot(normal, facing) < 0.0f)
+            normal = -normal;
+        glm::vec2 uv = (triangle.uvs[0] * w + triangle.uvs[1] * hit.u + triangle.uvs[2] * hit.v) * material.uvScale;
+
+        // unbound textures are black, as in GL
+        glm::vec3 albedo = material.diffuse ? glm::vec3(material.diffuse->sample(uv)) : glm::vec3(0.0f);
+        glm::vec3 specularMap = material.specular ? glm::vec3(material.specular->sample(uv)) : glm::vec3(0.0f);
+        if (material.overlay)
+        {
+            glm::vec4 overlay = material.overlay->sample(uv);
+            albedo = glm::vec3(overlay) * overlay.w + albedo * (1.0f - overlay.w);
+        }
+
+        glm::vec3 surface = position + facing * RAY_OFFSET;
+        radiance += throughput * directLight(surface, normal, -ray.direction, albedo, specularMap, material.shininess, rays);
+        if (bounce >= maxBounces)
+            break;
+
+        // Russian roulette once the path has lost most of its weight
+        throughput *= albedo;
+        if (bounce >= 2)
+        {
+            float survive = glm::clamp(max(throughput.x, max(throughput.y, throughput.z)), 0.05f, 0.95f);
+            if (random(rng) >= survive)
+                break;
+            throughput /= survive;
+        }
+        ray.origin = surface;
+        ray.direction = cosineSample(normal, rng);
+    }
+    return radiance;
+}
+
+void PathTracer::render(int width, int height, int samplesPerPixel, vector<uint8_t>& pixels)
+{
+    pixels.assign((size_t)width * height * 4, 0);
+    imageWidth = width;
+    imageHeight = height;
+    samples = 0;
+    raysTraced = 0;
+    convergedSamples = 0;
+    if (!lit || triangles.empty() || width <= 0 || height <= 0)
+    {
+        cout << "Path tracer: no lit draws were captured" << endl;
+        return;
+    }
+    PROFILE_ZONE("path trace");
+
+    double start = nowMs();
+    vector<int> order(triangles.size());
+    vector<glm::vec3> centroids(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        order[i] = (int)i;
+        centroids[i] = triangles[i].v0 + (triangles[i].edge1 + triangles[i].edge2) * (1.0f / 3.0f);
+    }
+    nodes.clear();
+    nodes.reserve(triangles.size() * 2);
+    buildNode(order, centroids, 0, (int)triangles.size());
+    vector<Triangle> sorted;
+    sorted.reserve(triangles.size());
+    for (int index : order)
+        sorted.push_back(triangles[index]);
+    triangles.swap(sorted);
+    buildMs = nowMs() - start;
+
+    // camera rays through the same matrices the lit draws used
+    glm::mat4 inverseViewProjection = glm::inverse(lighting.projection * lighting.view);
+    int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    vector<glm::vec3> accumulated((size_t)width * height, glm::vec3(0.0f));
+    vector<double> tileChange((size_t)tilesX * tilesY);
+    atomic<uint64_t> rayCount{ 0 };
+
+    start = nowMs();
+    for (int pass = 0; pass < samplesPerPixel; ++pass)
+    {
+        // tiles are handed out one at a time, so threads that finish early take the rest
+        pool.parallelFor(tilesX * tilesY, [&](int tile) {
+            int x0 = (tile % tilesX) * TILE_SIZE, y0 = (tile / tilesX) * TILE_SIZE;
+            int x1 = min(x0 + TILE_SIZE, width), y1 = min(y0 + TILE_SIZE, height);
+            uint64_t rays = 0;
+            double change = 0.0;
+            for (int y = y0; y < y1; ++y)
+            {
+                for (int x = x0; x < x1; ++x)
+                {
+                    size_t pixel = (size_t)y * width + x;
+                    uint32_t rng = hashSeed((uint32_t)(pixel * 9781u + (uint32_t)pass * 6271u * (uint32_t)(width * height)));
+                    float ndcX = (x + random(rng)) / width * 2.0f - 1.0f;
+                    float ndcY = (y + random(rng)) / height * 2.0f - 1.0f;
+                    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+                    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+                    glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+                    glm::vec3 color = trace(Ray{ origin, direction }, rng, rays);
+                    // how far this sample moves the running mean, in 8 bit steps
+                    if (pass > 0)
+                    {
+                        glm::vec3 step = (color - accumulated[pixel] / (float)pass) * (255.0f / (pass + 1));
+                        change += glm::dot(step, step);
+                    }
+                    accumulated[pixel] += color;
+                }
+            }
+            tileChange[tile] = change;
+            rayCount += rays;
+        });
+        ++samples;
+
+        if (pass > 0 && convergedSamples == 0)
+        {
+            double change = 0.0;
+            for (double value : tileChange)
+                change += value;
+            if (sqrt(change / ((double)width * height * 3)) < convergedStep)
+            {
+                convergedSamples = samples;
+                convergedMs = nowMs() - start;
+            }
+        }
+        // progress at every power of two
+        if ((samples & (samples - 1)) == 0 && samples < samplesPerPixel)
+            cout << "Path tracing: " << samples << "/" << samplesPerPixel << " samples, " << (nowMs() - start) / 1000.0 << "s" << endl;
+    }
+    renderMs = nowMs() - start;
+    raysTraced = rayCount.load();
+
+    // the mean of every pass, clamped like the GL framebuffer
+    for (size_t pixel = 0; pixel < accumulated.size(); ++pixel)
+    {
+        glm::vec3 color = glm::clamp(accumulated[pixel] / (float)samples, 0.0f, 1.0f);
+        pixels[pixel * 4] = (uint8_t)(color.x * 255.0f + 0.5f);
+        pixels[pixel * 4 + 1] = (uint8_t)(color.y * 255.0f + 0.5f);
+        pixels[pixel * 4 + 2] = (uint8_t)(color.z * 255.0f + 0.5f);
+        pixels[pixel * 4 + 3] = 255;
+    }
+}
+
+void PathTracer::printStats() const
+{
+    if (samples == 0)
+        return;
+    double seconds = renderMs / 1000.0;
+    cout << "Path traced " << imageWidth << "x" << imageHeight << " at " << samples << " samples per pixel on "
+        << pool.size() + 1 << " threads: " << triangles.size() << " triangles, BVH of " << nodes.size()
+        << " nodes built in " << buildMs << "ms, " << seconds << "s, " << raysTraced / seconds / 1000000.0 << " Mrays/s" << endl;
+    if (convergedSamples > 0)
+        cout << "  converged (RMS change under " << convergedStep << " steps per pass) after " << convergedSamples
+            << " samples, " << convergedMs / 1000.0 << "s" << endl;
+    else
+        cout << "  not converged to " << convergedStep << " steps per pass within " << samples << " samples" << endl;
+}
@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: PathTracer.h                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Offline path tracer for reference stills. It traces the scene one frame    //
+// of draws describes, with a SAH BVH, SSE box tests and progressive accumulation spread   //
+// over every core in screen tiles.                                                         //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+
+// Renders what SoftwareGL's draw listener captured: triangles from the lit and lamp draws,
+// the skybox as environment, and the camera and lights from the lighting uniforms. Direct
+// light uses the Phong terms of 6.multiple_lights.fs with shadow rays; indirect light bounces
+// off the diffuse textures, and the lights' ambient terms are left out in its favor
+class PathTracer
+{
+public:
+    // threadCount includes the thread that calls render, so at least two; 0 uses every core
+    explicit PathTracer(unsigned threadCount = 0);
+
+    // Scene capture: beginScene at the start of a frame, then every draw of that frame
+    void beginScene();
+    void addDraw(const SoftwareDraw& draw);
+    // Seen by camera rays that miss everything when there is no skybox
+    void setBackground(const glm::vec3& color) { background = color; }
+
+    // Builds the BVH and accumulates one sample per pixel per pass, then writes RGBA8 with
+    // the bottom row first like glReadPixels
+    void render(int width, int height, int samplesPerPixel, std::vector<uint8_t>& pixels);
+    void printStats() const;
+
+    int maxBounces = 4;
+    // RMS change per pass, in 8 bit steps, below which the image counts as converged
+    float convergedStep = 0.5f;
+
+private:
+    static const int TILE_SIZE = 16;
+    static const int SAH_BINS = 12;
+    static const int MAX_LEAF_SIZE = 8;
+
+    struct Material
+    {
+        std::shared_ptr<const SoftwareTexture> diffuse;
+        std::shared_ptr<const SoftwareTexture> specular;
+        std::shared_ptr<const SoftwareTexture> overlay;
+        glm::vec2 uvScale;
+        float shininess;
+    };
+    struct Triangle
+    {
+        glm::vec3 v0, edge1, edge2;
+        glm::vec3 normals[3];
+        glm::vec2 uvs[3];
+        int material;
+        bool emissive;  // lamp cubes: seen by the camera, but they don't block their own light
+    };
+    // Inner nodes keep the left child right after them; the fourth bounds lane is padding
+    struct Node
+    {
+        float boundsMin[4];
+        float boundsMax[4];
+        int first;  // first triangle of a leaf, right child of an inner node
+        int count;  // 0 for inner nodes
+    };
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+    struct Hit
+    {
+        float t, u, v;
+        int triangle;
+    };
+
+    int buildNode(std::vector<int>& order, const std::vector<glm::vec3>& centroids, int first, int count);
+    bool intersect(const Ray& ray, float maxDistance, bool shadow, Hit& hit) const;
+    glm::vec3 trace(Ray ray, uint32_t& rng, uint64_t& rays) const;
+    glm::vec3 directLight(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& viewDir,
+        const glm::vec3& albedo, const glm::vec3& specularMap, float shininess, uint64_t& rays) const;
+    glm::vec3 environment(const glm::vec3& direction, bool cameraRay) const;
+
+    ThreadPool pool;
+    std::vector<Triangle> triangles;
+    std::vector<Material> materials;
+    std::vector<Node> nodes;
+    std::shared_ptr<const SoftwareTexture> sky;
+    glm::vec3 background = glm::vec3(0.0f);
+    // the last lit draw holds the camera and light uniforms
+    SoftwareDraw lighting;
+    bool lit = false;
+
+    // results of the last render
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int samples = 0;
+    double buildMs = 0.0;
+    double renderMs = 0.0;
+    uint64_t raysTraced = 0;
+    int convergedSamples = 0;
+    double convergedMs = 0.0;
+};
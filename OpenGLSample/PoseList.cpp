@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: PoseList.cpp                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: List of named camera poses for batch rendering. Each pose becomes one      //
+// image, so a scene can be shot from hundreds of angles with a single load.              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "PoseList.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std; // Standard namespace
+
+/*
+  Pose file format, one entry per line, '#' starts a comment:
+
+    resolution 1920 1080                        image size
+    pose <name> <x y z> <yaw> <pitch>           camera angles in degrees, as in the Camera class
+    lookat <name> <x y z> <tx ty tz>            camera at x y z aimed at the target point
+
+  Images are saved as <name>.png, so names should be unique.
+*/
+bool PoseList::load(const string& path)
+{
+    ifstream file(path);
+    if (!file.is_open())
+    {
+        cout << "Could not open pose list " << path << endl;
+        return false;
+    }
+
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line))
+    {
+        ++lineNumber;
+        size_t comment = line.find('#');
+        if (comment != string::npos)
+            line.erase(comment);
+
+        istringstream in(line);
+        string command;
+        if (!(in >> command))
+            continue;
+
+        bool ok = true;
+        if (command == "resolution")
+            ok = static_cast<bool>(in >> width >> height) && width > 0 && height > 0;
+        else if (command == "pose")
+        {
+            CameraPose pose;
+            ok = static_cast<bool>(in >> pose.name >> pose.position.x >> pose.position.y >> pose.position.z >> pose.yaw >> pose.pitch);
+            if (ok)
+                entries.push_back(pose);
+        }
+        else if (command == "lookat")
+        {
+            CameraPose pose;
+            glm::vec3 target;
+            ok = static_cast<bool>(in >> pose.name >> pose.position.x >> pose.position.y >> pose.position.z
+                >> target.x >> target.y >> target.z);
+            glm::vec3 offset = target - pose.position;
+            ok = ok && glm::length(offset) > 0.0f;
+            if (ok)
+            {
+                // the inverse of the Camera front vector: x = cos(yaw) cos(pitch), y = sin(pitch), z = sin(yaw) cos(pitch)
+                glm::vec3 direction = glm::normalize(offset);
+                pose.yaw = glm::degrees(atan2(direction.z, direction.x));
+                pose.pitch = glm::degrees(asin(direction.y));
+                entries.push_back(pose);
+            }
+        }
+        else
+            ok = false;
+
+        if (!ok)
+        {
+            cout << path << ":" << lineNumber << ": can't read '" << line << "'" << endl;
+            return false;
+        }
+    }
+
+    if (entries.empty())
+    {
+        cout << path << ": has no poses" << endl;
+        return false;
+    }
+    return true;
+}
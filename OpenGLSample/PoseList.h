@@ -0,0 +1,38 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: PoseList.h                                                                         //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: List of named camera poses for batch rendering. Each pose becomes one      //
+// image, so a scene can be shot from hundreds of angles with a single load.              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// A camera placement and the image name it is saved under
+struct CameraPose
+{
+    std::string name;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
+// Reads camera poses from a text file
+class PoseList
+{
+public:
+    // Image size, the file can override it
+    int width = 1280;
+    int height = 720;
+
+    // Parses the file, prints the problem and returns false if it is unusable
+    bool load(const std::string& path);
+
+    const std::vector<CameraPose>& poses() const { return entries; }
+
+private:
+    std::vector<CameraPose> entries;
+};
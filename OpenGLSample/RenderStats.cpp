@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: RenderStats.cpp                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Per-frame counters for draw calls, geometry, state changes and uploads.    //
+// GL call sites go through the counting wrappers below; each finished frame is kept in a  //
+// ring of recent frames and streamed to a CSV or JSON lines file.                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStats.h"
+#include <algorithm>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Lines are buffered by the stream and pushed to disk this often
+    const uint64_t FLUSH_INTERVAL = 120;
+
+    bool endsWith(const string& text, const string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+}
+
+FrameStats RenderStats::counters;
+
+uint64_t RenderStats::imageBytes(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    uint64_t components = 4;
+    if (format == GL_RED || format == GL_DEPTH_COMPONENT)
+        components = 1;
+    else if (format == GL_RG)
+        components = 2;
+    else if (format == GL_RGB || format == GL_BGR)
+        components = 3;
+
+    uint64_t componentBytes = 1;
+    if (type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT)
+        componentBytes = 2;
+    else if (type == GL_UNSIGNED_INT || type == GL_INT || type == GL_FLOAT)
+        componentBytes = 4;
+
+    return (uint64_t)width * (uint64_t)height * components * componentBytes;
+}
+
+bool RenderStats::openStream(const string& path)
+{
+    stream.open(path);
+    if (!stream.is_open())
+    {
+        cout << "Could not open render stats file " << path << endl;
+        return false;
+    }
+
+    json = endsWith(path, ".json") || endsWith(path, ".jsonl");
+    if (!json)
+        stream << "frame,time,draw_calls,triangles,vertices,program_binds,vao_binds,texture_binds,uniform_calls,buffer_bytes,texture_bytes\n";
+    return true;
+}
+
+void RenderStats::endFrame(double time)
+{
+    counters.frame = framesEnded++;
+    counters.time = time;
+
+    ring[historyNext] = counters;
+    historyNext = (historyNext + 1) % HISTORY_SIZE;
+    historyCount = min(historyCount + 1, HISTORY_SIZE);
+
+    if (stream.is_open())
+    {
+        writeLine(counters);
+        if (framesEnded % FLUSH_INTERVAL == 0)
+            stream.flush();
+    }
+
+    counters = FrameStats();
+}
+
+const FrameStats& RenderStats::history(size_t ago) const
+{
+    return ring[(historyNext + HISTORY_SIZE - 1 - ago) % HISTORY_SIZE];
+}
+
+void RenderStats::writeLine(const FrameStats& s)
+{
+    if (json)
+    {
+        stream << "{\"frame\":" << s.frame << ",\"time\":" << s.time << ",\"draw_calls\":" << s.drawCalls
+            << ",\"triangles\":" << s.triangles << ",\"vertices\":" << s.vertices
+            << ",\"program_binds\":" << s.programBinds << ",\"vao_binds\":" << s.vaoBinds
+            << ",\"texture_binds\":" << s.textureBinds << ",\"uniform_calls\":" << s.uniformCalls
+            << ",\"buffer_bytes\":" << s.bufferBytes << ",\"texture_bytes\":" << s.textureBytes << "}\n";
+    }
+    else
+    {
+        stream << s.frame << ',' << s.time << ',' << s.drawCalls << ',' << s.triangles << ',' << s.vertices << ','
+            << s.programBinds << ',' << s.vaoBinds << ',' << s.textureBinds << ',' << s.uniformCalls << ','
+            << s.bufferBytes << ',' << s.textureBytes << '\n';
+    }
+}
+
+void RenderStats::printStats()
+{
+    if (stream.is_open())
+        stream.close();
+    if (historyCount == 0)
+        return;
+
+    FrameStats total, peak;
+    for (size_t i = 0; i < historyCount; ++i)
+    {
+        const FrameStats& s = history(i);
+        total.drawCalls += s.drawCalls;
+        total.triangles += s.triangles;
+        total.programBinds += s.programBinds;
+        total.vaoBinds += s.vaoBinds;
+        total.textureBinds += s.textureBinds;
+        total.uniformCalls += s.uniformCalls;
+        total.bufferBytes += s.bufferBytes;
+        total.textureBytes += s.textureBytes;
+        peak.drawCalls = max(peak.drawCalls, s.drawCalls);
+        peak.triangles = max(peak.triangles, s.triangles);
+        peak.textureBytes = max(peak.textureBytes, s.textureBytes);
+    }
+
+    double n = (double)historyCount;
+    cout << "Render stats over the last " << historyCount << " frames (average per frame):" << endl;
+    cout << "  draw calls: " << total.drawCalls / n << " (max " << peak.drawCalls << "), triangles: "
+        << total.triangles / n << " (max " << peak.triangles << ")" << endl;
+    cout << "  binds: program " << total.programBinds / n << ", VAO " << total.vaoBinds / n
+        << ", texture " << total.textureBinds / n << ", uniform calls: " << total.uniformCalls / n << endl;
+    cout << "  uploads: buffers " << total.bufferBytes / n / 1024.0 << " KB, textures "
+        << total.textureBytes / n / 1024.0 << " KB (max " << peak.textureBytes / 1024.0 << " KB)" << endl;
+}
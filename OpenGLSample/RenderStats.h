@@ -0,0 +1,123 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: RenderStats.h                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Per-frame counters for draw calls, geometry, state changes and uploads.    //
+// GL call sites go through the counting wrappers below; each finished frame is kept in a  //
+// ring of recent frames and streamed to a CSV or JSON lines file.                          //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Counters for one frame
+struct FrameStats
+{
+    uint64_t frame = 0;
+    double time = 0.0;           // seconds since glfwInit when the frame ended
+    uint32_t drawCalls = 0;
+    uint64_t triangles = 0;
+    uint64_t vertices = 0;       // vertices (or indices) submitted
+    uint32_t programBinds = 0;
+    uint32_t vaoBinds = 0;
+    uint32_t textureBinds = 0;
+    uint32_t uniformCalls = 0;
+    uint64_t bufferBytes = 0;    // uploaded with glBufferData / glBufferSubData
+    uint64_t textureBytes = 0;   // uploaded with glTexImage2D / glTexSubImage2D
+};
+
+// Counts GL work for the current frame and keeps the history of recent frames
+class RenderStats
+{
+public:
+    // Counting wrappers, each issues the GL call it is named after
+    static void drawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        glDrawArrays(mode, first, count);
+        countDraw(mode, count);
+    }
+    static void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        glDrawElements(mode, count, type, indices);
+        countDraw(mode, count);
+    }
+    static void useProgram(GLuint program)
+    {
+        glUseProgram(program);
+        ++counters.programBinds;
+    }
+    static void bindVertexArray(GLuint vao)
+    {
+        glBindVertexArray(vao);
+        ++counters.vaoBinds;
+    }
+    static void bindTexture(GLenum target, GLuint texture)
+    {
+        glBindTexture(target, texture);
+        ++counters.textureBinds;
+    }
+    static void bufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+    {
+        glBufferData(target, size, data, usage);
+        if (data != nullptr)
+            counters.bufferBytes += (uint64_t)size;
+    }
+    static void texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, const void* pixels)
+    {
+        glTexImage2D(target, level, internalFormat, width, height, 0, format, type, pixels);
+        if (pixels != nullptr)
+            counters.textureBytes += imageBytes(width, height, format, type);
+    }
+    // For uploads made directly, such as through a pixel unpack buffer
+    static void countBufferUpload(uint64_t bytes) { counters.bufferBytes += bytes; }
+    static void countTextureUpload(uint64_t bytes) { counters.textureBytes += bytes; }
+    // Called by each glUniform* wrapper in Shader
+    static void countUniform() { ++counters.uniformCalls; }
+
+    // Bytes in a tightly packed image
+    static uint64_t imageBytes(GLsizei width, GLsizei height, GLenum format, GLenum type);
+
+    // Counters of the frame being recorded
+    static const FrameStats& current() { return counters; }
+
+    // Streams every finished frame to the file, .json writes JSON lines, anything else CSV
+    bool openStream(const std::string& path);
+    // Closes the frame, stores it in the history and starts counting the next one
+    void endFrame(double time);
+    // Frame that ended 'ago' frames back, 0 being the most recent; needs ago < historySize()
+    const FrameStats& history(size_t ago) const;
+    size_t historySize() const { return historyCount; }
+    uint64_t framesRendered() const { return framesEnded; }
+    // Averages and peaks over the history, then flushes and closes the stream
+    void printStats();
+
+private:
+    static void countDraw(GLenum mode, GLsizei count)
+    {
+        ++counters.drawCalls;
+        counters.vertices += (uint64_t)count;
+        if (mode == GL_TRIANGLES)
+            counters.triangles += (uint64_t)(count / 3);
+        else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+            counters.triangles += (uint64_t)(count - 2);
+    }
+
+    void writeLine(const FrameStats& stats);
+
+    static FrameStats counters;
+
+    // Recent frames, oldest overwritten first
+    static const size_t HISTORY_SIZE = 1024;
+    std::vector<FrameStats> ring = std::vector<FrameStats>(HISTORY_SIZE);
+    size_t historyNext = 0;
+    size_t historyCount = 0;
+    uint64_t framesEnded = 0;
+
+    std::ofstream stream;
+    bool json = false;
+};
@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: RenderTarget.cpp                                                                   //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Offscreen framebuffer with a color and depth attachment that the scene     //
+// can be drawn into and then copied to the window or read back.                           //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTarget.h"
+#include <iostream>
+using namespace std; // Standard namespace
+
+bool RenderTarget::create(int w, int h, int sampleCount)
+{
+    width = w;
+    height = h;
+    samples = sampleCount;
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    if (samples > 1)
+    {
+        glGenRenderbuffers(1, &colorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    }
+    else
+    {
+        glGenTextures(1, &colorTexture);
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    }
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    if (samples > 1)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+    else
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+        cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete (" << width << "x" << height << ", " << samples << " samples)" << endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
+
+void RenderTarget::destroy()
+{
+    if (colorTexture != 0)
+        glDeleteTextures(1, &colorTexture);
+    if (colorBuffer != 0)
+        glDeleteRenderbuffers(1, &colorBuffer);
+    if (depthBuffer != 0)
+        glDeleteRenderbuffers(1, &depthBuffer);
+    if (fbo != 0)
+        glDeleteFramebuffers(1, &fbo);
+    fbo = colorTexture = colorBuffer = depthBuffer = 0;
+    width = height = 0;
+}
+
+bool RenderTarget::resize(int newWidth, int newHeight, int newSamples)
+{
+    if (fbo != 0 && newWidth == width && newHeight == height && newSamples == samples)
+        return true;
+    destroy();
+    return create(newWidth, newHeight, newSamples);
+}
+
+void RenderTarget::bind(int viewportWidth, int viewportHeight) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, viewportWidth, viewportHeight);
+}
+
+void RenderTarget::blitTo(GLuint targetFbo, int srcWidth, int srcHeight, int dstWidth, int dstHeight, GLenum filter) const
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFbo);
+    glBlitFramebuffer(0, 0, srcWidth, srcHeight, 0, 0, dstWidth, dstHeight, GL_COLOR_BUFFER_BIT, filter);
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFbo);
+}
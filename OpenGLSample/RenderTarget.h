@@ -0,0 +1,34 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: RenderTarget.h                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Offscreen framebuffer with a color and depth attachment that the scene     //
+// can be drawn into and then copied to the window or read back.                           //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+
+// Framebuffer object with RGBA8 color and 24 bit depth, optionally multisampled
+class RenderTarget
+{
+public:
+    GLuint fbo = 0;
+    GLuint colorTexture = 0;  // single sample targets use a texture so they can be sampled
+    GLuint colorBuffer = 0;   // multisampled targets use a renderbuffer
+    GLuint depthBuffer = 0;
+    int width = 0;
+    int height = 0;
+    int samples = 0;
+
+    // Allocates the attachments, returns false if the framebuffer is incomplete
+    bool create(int width, int height, int samples = 0);
+    void destroy();
+    // Reallocates only when the size or sample count actually changes
+    bool resize(int newWidth, int newHeight, int newSamples);
+
+    // Binds for drawing and sets the viewport to the given area of the target
+    void bind(int viewportWidth, int viewportHeight) const;
+    // Copies an area of this target onto the whole of another framebuffer (0 = window)
+    void blitTo(GLuint targetFbo, int srcWidth, int srcHeight, int dstWidth, int dstHeight, GLenum filter) const;
+};
@@ -0,0 +1,172 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ResourceManager.cpp                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Creates meshes and textures the first time they are asked for and destroys //
+// them when the last reference goes, handing out typed, generational handles to them.     //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ResourceManager.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    const char* MESH_NAMES[MeshCreator::MESH_COUNT] = {
+        "plane", "pyramid", "frustum pyramid", "cylinder", "cube", "sphere", "torus", "cone", "skybox"
+    };
+
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    string fileName(const char* path)
+    {
+        string name = path;
+        return name.substr(name.find_last_of("/\\") + 1);
+    }
+}
+
+ResourceManager::ResourceManager(MeshCreator& meshes, Textures& textures)
+    : meshes(meshes), textures(textures), meshSlots(MeshCreator::MESH_COUNT), textureSlots(Textures::NAME_COUNT)
+{
+}
+
+template <typename Tag>
+ResourceManager::Slot* ResourceManager::live(vector<Slot>& slots, ResourceHandle<Tag> handle)
+{
+    if (!handle.valid() || handle.index >= slots.size() || slots[handle.index].generation != handle.generation
+        || slots[handle.index].references == 0)
+    {
+        ++staleHandles;
+        return nullptr;
+    }
+    return &slots[handle.index];
+}
+
+MeshHandle ResourceManager::acquire(MeshCreator::Kind kind)
+{
+    Slot& slot = meshSlots[kind];
+    if (slot.references++ == 0)
+    {
+        PROFILE_ZONE("ResourceManager::createMesh");
+        double start = nowMs();
+        meshes.createMesh(kind);
+        createMs += nowMs() - start;
+        slot.bytes = meshes.mesh(kind).bytes;
+        residentBytes += slot.bytes;
+        peakBytes = max(peakBytes, residentBytes);
+        ++created;
+    }
+    MeshHandle handle;
+    handle.index = (uint16_t)kind;
+    handle.generation = slot.generation;
+    return handle;
+}
+
+TextureHandle ResourceManager::acquire(Textures::Name name)
+{
+    Slot& slot = textureSlots[name];
+    if (slot.references++ == 0)
+    {
+        PROFILE_ZONE("ResourceManager::createTexture");
+        double start = nowMs();
+        textures.load(name, slot.bytes);
+        createMs += nowMs() - start;
+        residentBytes += slot.bytes;
+        peakBytes = max(peakBytes, residentBytes);
+        ++created;
+    }
+    TextureHandle handle;
+    handle.index = (uint16_t)name;
+    handle.generation = slot.generation;
+    return handle;
+}
+
+void ResourceManager::destroy(vector<Slot>& slots, int index, bool mesh)
+{
+    Slot& slot = slots[index];
+    if (mesh)
+        meshes.destroyMesh((MeshCreator::Kind)index);
+    else
+        textures.unload((Textures::Name)index);
+    residentBytes -= slot.bytes;
+    slot.bytes = 0;
+    slot.references = 0;
+    ++slot.generation;
+    ++destroyed;
+}
+
+void ResourceManager::release(MeshHandle& handle)
+{
+    Slot* slot = live(meshSlots, handle);
+    if (slot && --slot->references == 0)
+        destroy(meshSlots, handle.index, true);
+    handle = MeshHandle();
+}
+
+void ResourceManager::release(TextureHandle& handle)
+{
+    Slot* slot = live(textureSlots, handle);
+    if (slot && --slot->references == 0)
+        destroy(textureSlots, handle.index, false);
+    handle = TextureHandle();
+}
+
+const MeshCreator::GLMesh* ResourceManager::mesh(MeshHandle handle)
+{
+    return live(meshSlots, handle) ? &meshes.mesh((MeshCreator::Kind)handle.index) : nullptr;
+}
+
+GLuint ResourceManager::texture(TextureHandle handle)
+{
+    return live(textureSlots, handle) ? textures.texture((Textures::Name)handle.index) : 0;
+}
+
+void ResourceManager::releaseAll()
+{
+    for (int i = 0; i < (int)meshSlots.size(); ++i)
+    {
+        if (meshSlots[i].references > 0)
+            destroy(meshSlots, i, true);
+    }
+    for (int i = 0; i < (int)textureSlots.size(); ++i)
+    {
+        if (textureSlots[i].references > 0)
+            destroy(textureSlots, i, false);
+    }
+}
+
+void ResourceManager::printStats() const
+{
+    if (created == 0)
+        return;
+    int residentMeshes = 0;
+    int residentTextures = 0;
+    for (const Slot& slot : meshSlots)
+        residentMeshes += slot.references > 0 ? 1 : 0;
+    for (const Slot& slot : textureSlots)
+        residentTextures += slot.references > 0 ? 1 : 0;
+    cout << fixed << setprecision(2) << "Resources: " << residentMeshes << " meshes and " << residentTextures
+        << " textures resident in " << residentBytes / (1024.0 * 1024.0) << " MB (peak " << peakBytes / (1024.0 * 1024.0)
+        << " MB); " << created << " created in " << setprecision(1) << createMs << "ms, " << destroyed << " destroyed, "
+        << staleHandles << " stale handles" << endl;
+    for (int i = 0; i < (int)meshSlots.size(); ++i)
+    {
+        if (meshSlots[i].references > 0)
+            cout << "  mesh " << left << setw(20) << MESH_NAMES[i] << right << setw(3) << meshSlots[i].references
+                << " refs " << setprecision(1) << setw(8) << meshSlots[i].bytes / 1024.0 << " KB" << endl;
+    }
+    for (int i = 0; i < (int)textureSlots.size(); ++i)
+    {
+        if (textureSlots[i].references > 0)
+            cout << "  texture " << left << setw(17) << fileName(Textures::path((Textures::Name)i)) << right << setw(3)
+                << textureSlots[i].references << " refs " << setprecision(1) << setw(8) << textureSlots[i].bytes / 1024.0 << " KB" << endl;
+    }
+    cout << defaultfloat << setprecision(6);
+}
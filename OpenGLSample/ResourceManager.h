@@ -0,0 +1,83 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ResourceManager.h                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Creates meshes and textures the first time they are asked for and destroys //
+// them when the last reference goes, handing out typed, generational handles to them.     //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "MeshCreator.h"
+#include "Textures.h"
+
+// Slot of a resource and the generation of the slot it was handed out for. Releasing the
+// resource moves the slot to the next generation, so older handles stop resolving even once
+// it is created again. Tag keeps mesh and texture handles apart
+template <typename Tag>
+struct ResourceHandle
+{
+    static const uint16_t NONE = 0xFFFF;
+    uint16_t index = NONE;
+    uint16_t generation = 0;
+
+    bool valid() const { return index != NONE; }
+};
+
+struct MeshTag {};
+struct TextureTag {};
+typedef ResourceHandle<MeshTag> MeshHandle;
+typedef ResourceHandle<TextureTag> TextureHandle;
+
+// A slot per MeshCreator::Kind and Textures::Name, filled into the members of meshes and
+// textures as they are created, so draws keep reading those
+class ResourceManager
+{
+public:
+    ResourceManager(MeshCreator& meshes, Textures& textures);
+
+    // Each acquire takes a reference, creating the resource when it has none
+    MeshHandle acquire(MeshCreator::Kind kind);
+    TextureHandle acquire(Textures::Name name);
+    // Drops the handle's reference and clears it; the last one destroys the resource. Stale
+    // handles are counted and ignored
+    void release(MeshHandle& handle);
+    void release(TextureHandle& handle);
+
+    // The resource behind a handle, nullptr or 0 once it is stale
+    const MeshCreator::GLMesh* mesh(MeshHandle handle);
+    GLuint texture(TextureHandle handle);
+
+    // Destroys everything still resident, whatever its references, at exit
+    void releaseAll();
+
+    // Resident resources with their references and memory, and what was created and destroyed
+    void printStats() const;
+
+private:
+    struct Slot
+    {
+        uint16_t generation = 0;
+        int references = 0;
+        uint64_t bytes = 0;
+    };
+
+    // The slot a handle refers to, nullptr when it is stale
+    template <typename Tag>
+    Slot* live(std::vector<Slot>& slots, ResourceHandle<Tag> handle);
+    void destroy(std::vector<Slot>& slots, int index, bool mesh);
+
+    MeshCreator& meshes;
+    Textures& textures;
+    std::vector<Slot> meshSlots;
+    std::vector<Slot> textureSlots;
+
+    int created = 0;
+    int destroyed = 0;
+    int staleHandles = 0;
+    double createMs = 0.0;
+    uint64_t peakBytes = 0;
+    uint64_t residentBytes = 0;
+};
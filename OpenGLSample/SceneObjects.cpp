@@ -8,21 +8,221 @@
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "SceneObjects.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Binds a material texture to unit 0-2, through the texture arrays when they are in use
+void SceneObjects::bindTexture(const Shader& lightingShader, int unit, GLuint texture) {
+    boundTextures[unit] = texture;
+    if (textureSamplers)
+        textureSamplers->bind(unit, texture);
+    if (textureArrays) {
+        textureArrays->bind(lightingShader, unit, texture);
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    RenderStats::bindTexture(GL_TEXTURE_2D, texture);
+}
+
+// Sets the model matrix of the next draw and tells the streamer how large its textures appear
+void SceneObjects::setModel(const Shader& lightingShader, const glm::mat4& model) {
+    lightingShader.setMat4("model", model);
+    if (textureStreamer) {
+        for (GLuint texture : boundTextures)
+            textureStreamer->noteUse(texture, model);
+    }
+}
+
+// Switches to a material, leaving alone what it shares with the current one
+void SceneObjects::useMaterial(const Shader& lightingShader, Materials::Id id) {
+    if (id == currentMaterial)
+        return;
+    if (bindlessMaterials) {
+        bindlessMaterials->use(lightingShader, id);
+        currentMaterial = id;
+        return;
+    }
+    const Material& material = materials.get(id);
+    const Material* current = currentMaterial == Materials::NONE ? nullptr : &materials.get(currentMaterial);
+    if (!current || material.diffuse != current->diffuse)
+        bindTexture(lightingShader, 0, material.diffuse);
+    if (!current || material.specular != current->specular)
+        bindTexture(lightingShader, 1, material.specular);
+    if (!current || material.overlay != current->overlay)
+        bindTexture(lightingShader, 2, material.overlay);
+    if (!current || material.shininess != current->shininess)
+        lightingShader.setFloat("material.shininess", material.shininess);
+    if (!current || material.uvScale != current->uvScale)
+        lightingShader.setVec2("uvScale", material.uvScale);
+    currentMaterial = id;
+}
+
+// Every mesh but the skybox, and every 2D texture
+void SceneObjects::acquireResources(ResourceManager& resources) {
+    for (int kind = 0; kind < MeshCreator::SKYBOX; ++kind)
+        meshHandles.push_back(resources.acquire((MeshCreator::Kind)kind));
+    for (int name = 0; name < Textures::SKYBOX; ++name)
+        textureHandles.push_back(resources.acquire((Textures::Name)name));
+}
+
+void SceneObjects::releaseResources(ResourceManager& resources) {
+    for (MeshHandle& handle : meshHandles)
+        resources.release(handle);
+    for (TextureHandle& handle : textureHandles)
+        resources.release(handle);
+    meshHandles.clear();
+    textureHandles.clear();
+}
+
+// Diffuse, specular and overlay textures, shininess and UV scale of each part
+void SceneObjects::createMaterials(const Textures& gTexture) {
+    materials.clear();
+    // hammer
+    parts.hammerMetal = materials.add({ gTexture.gTextureHammerHead, gTexture.gSpecularHammerHead, 0, 4.0f });
+    parts.hammerWood = materials.add({ gTexture.gTextureWood, 0, 0, 2.0f });
+    // fire flower cup
+    parts.cupBase = materials.add({ gTexture.gTextureQuestion, gTexture.gSpecularPlastic, 0, 8.0f });
+    parts.straw = materials.add({ gTexture.gTextureClear, 0, 0, 8.0f });
+    parts.flowerStem = materials.add({ gTexture.gTextureGreen, gTexture.gSpecularPlastic, 0, 64.0f });
+    parts.strawCap = materials.add({ gTexture.gTextureOrange, gTexture.gSpecularPlastic, 0, 26.0f });
+    parts.outerFlowerRing = materials.add({ gTexture.gTextureOrange, gTexture.gSpecularPlastic, 0, 26.0f });
+    parts.innerFlowerRing = materials.add({ gTexture.gTextureYellow, gTexture.gSpecularPlastic, 0, 26.0f });
+    parts.flowerFace = materials.add({ gTexture.gTextureEyes, 0, 0, 26.0f });
+    // popcorn bucket
+    parts.bucketInside = materials.add({ gTexture.gTexture4Panel, 0, gTexture.gTextureSnowflakes, 26.0f });
+    parts.bucketBand = materials.add({ gTexture.gTextureLeaf2, gTexture.gSpecularMetal, 0, 64.0f, glm::vec2(4.0f, 1.0f) });
+    parts.mickeyEars = materials.add({ gTexture.gTextureBrass, gTexture.gSpecularMetal, 0, 32.0f });
+    parts.mickeyHead = materials.add({ gTexture.gTextureBrass, gTexture.gSpecularMetal, 0, 32.0f });
+    parts.bucketDividers = materials.add({ gTexture.gTextureLeaf, gTexture.gSpecularMetal, 0, 64.0f, glm::vec2(1.0f, 1.5f) });
+    parts.bucketLid = materials.add({ gTexture.gTextureLeaf, gTexture.gSpecularMetal, 0, 64.0f });
+    // drink box
+    parts.drinkBox = materials.add({ gTexture.gTextureDrinkFront, 0, 0, 64.0f });
+    parts.drinkLid = materials.add({ gTexture.gTextureDrinkTop, 0, 0, 64.0f });
+    // room
+    parts.floor = materials.add({ gTexture.gTextureGrass, 0, 0, 64.0f });
+    parts.walls = materials.add({ gTexture.gTextureFence, 0, 0, 64.0f, glm::vec2(2.0f, 1.0f) });
+    parts.deskTop = materials.add({ gTexture.gTextureDesk, gTexture.gSpecularPlastic, 0, 32.0f });
+    parts.deskBody = materials.add({ gTexture.gTextureBrick, gTexture.gSpecularPlastic, 0, 32.0f, glm::vec2(0.5f, 0.5f) });
+    materials.printStats();
+    if (bindlessMaterials)
+        bindlessMaterials->upload(materials, textureSamplers);
+}
+
+void SceneObjects::runMaterialBenchmark(const MeshCreator& gMesh, const Textures& gTexture, const Shader& bindShader, const Shader& bindlessShader, int draws) {
+    const int FRAMES = 9;
+    if (gTexture.sources.empty() || draws <= 0)
+        return;
+    draws = std::min(draws, (int)Materials::NONE);
+    Materials sceneMaterials = materials;
+    BindlessMaterials* bindless = bindlessMaterials;
+
+    // every draw gets the textures in turn and a shininess no other draw has, on a cube of a
+    // grid that fills clip space
+    materials.clear();
+    std::vector<Materials::Id> ids(draws);
+    std::vector<glm::mat4> models(draws);
+    size_t textureCount = gTexture.sources.size();
+    int columns = (int)std::ceil(std::sqrt((double)draws));
+    for (int i = 0; i < draws; ++i) {
+        Material material;
+        material.diffuse = gTexture.sources[i % textureCount].texture;
+        material.specular = gTexture.sources[(i / textureCount) % textureCount].texture;
+        material.shininess = 1.0f + i;
+        ids[i] = materials.add(material);
+        float x = ((i % columns) + 0.5f) / columns * 2.0f - 1.0f;
+        float y = ((i / columns) + 0.5f) / columns * 2.0f - 1.0f;
+        models[i] = glm::translate(glm::vec3(x, y, 0.0f)) * glm::scale(glm::vec3(1.0f / columns));
+    }
+
+    // median CPU time to submit every draw, and to finish them, with the GL calls it took
+    struct Result {
+        double submitMs;
+        double finishMs;
+        uint32_t textureBinds;
+        uint32_t uniformCalls;
+    };
+    auto run = [&](const Shader& shader) {
+        std::vector<double> submits;
+        std::vector<double> finishes;
+        Result result = {};
+        // the first frame only warms up
+        for (int frame = 0; frame <= FRAMES; ++frame) {
+            FrameStats before = RenderStats::current();
+            auto start = std::chrono::steady_clock::now();
+            shader.use();
+            shader.setMat4("view", glm::mat4(1.0f));
+            shader.setMat4("projection", glm::mat4(1.0f));
+            currentMaterial = Materials::NONE;
+            if (bindlessMaterials)
+                bindlessMaterials->bind(shader);
+            RenderStats::bindVertexArray(gMesh.gCubeMesh.vao);
+            for (int i = 0; i < draws; ++i) {
+                useMaterial(shader, ids[i]);
+                setModel(shader, models[i]);
+                RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+            }
+            RenderStats::bindVertexArray(0);
+            double submitted = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            glFinish();
+            double finished = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (frame == 0)
+                continue;
+            submits.push_back(submitted);
+            finishes.push_back(finished);
+            result.textureBinds = RenderStats::current().textureBinds - before.textureBinds;
+            result.uniformCalls = RenderStats::current().uniformCalls - before.uniformCalls;
+        }
+        std::sort(submits.begin(), submits.end());
+        std::sort(finishes.begin(), finishes.end());
+        result.submitMs = submits[FRAMES / 2];
+        result.finishMs = finishes[FRAMES / 2];
+        return result;
+    };
+    auto print = [draws](const char* name, const Result& result) {
+        std::cout << "  " << std::left << std::setw(15) << name << std::right << std::fixed << std::setprecision(2)
+            << result.submitMs << "ms submit (" << result.submitMs * 1000.0 / draws << "us per draw), "
+            << result.finishMs << "ms with glFinish, " << result.textureBinds << " texture binds and "
+            << result.uniformCalls << " uniform calls" << std::defaultfloat << std::setprecision(6) << std::endl;
+    };
+
+    std::cout << "Material benchmark: " << draws << " draws with unique materials over " << textureCount
+        << " textures, median of " << FRAMES << " frames" << std::endl;
+    bindlessMaterials = nullptr;
+    Result bound = run(bindShader);
+    print("bind per draw", bound);
+    if (bindless) {
+        bindlessMaterials = bindless;
+        bindlessMaterials->upload(materials, textureSamplers);
+        Result resident = run(bindlessShader);
+        print("bindless", resident);
+        std::cout << std::fixed << std::setprecision(1) << "  bindless submits " << bound.submitMs / std::max(resident.submitMs, 0.001)
+            << "x as fast" << std::defaultfloat << std::setprecision(6) << std::endl;
+    }
+    else
+        std::cout << "  bindless       not measured, GL_ARB_bindless_texture is not available" << std::endl;
+    if (textureSamplers)
+        textureSamplers->unbind();
+
+    // the scene's own materials again
+    materials = sceneMaterials;
+    currentMaterial = Materials::NONE;
+    if (bindlessMaterials)
+        bindlessMaterials->upload(materials, textureSamplers);
+}
 
 // Creates the ball-peen hammer
-void SceneObjects::renderHammer(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData) {
+void SceneObjects::renderHammer(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData) {
     
-    lightingShader.setFloat("material.shininess", 4.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureHammerHead);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularHammerHead);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.hammerMetal);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gCylinderMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gCylinderMesh.vao);
 
     // First cylinder, connects hammer handle to headd
     // Scales the object
@@ -34,188 +234,161 @@ void SceneObjects::renderHammer(MeshCreator gMesh, Textures gTexture, Shader lig
     // Model matrix: transformations are applied right-to-left order
     glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;
 
-	lightingShader.setMat4("model", model);
+	setModel(lightingShader, model);
 
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    lightingShader.setFloat("material.shininess", 2.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureWood);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.hammerWood);
 
     // Second cylinder, hammer handle
     scale = glm::scale(glm::vec3(0.7f, 1.7f, 0.4f));
     rotation = glm::rotate(glm::radians(281.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(-0.55f, 0.497f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    lightingShader.setFloat("material.shininess", 4.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureHammerHead);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularHammerHead);
+    // bind the part's material
+    useMaterial(lightingShader, parts.hammerMetal);
 
     // Third cylinder, hammer head
     scale = glm::scale(glm::vec3(0.98f, 0.25f, 0.98f));
     rotation = glm::rotate(glm::radians(8.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.87f, 0.282f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
-    lightingShader.setFloat("material.shininess", 2.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureWood);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.hammerWood);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gPyramidMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gPyramidMesh.vao);
 
     // First pyramid, connects hammer handle to neck
     scale = glm::scale(glm::vec3(0.8f, 0.6f, 0.4f));
     rotation = glm::rotate(glm::radians(100.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.0f, 0.81f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gPyramidMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gPyramidMesh.nVertices);
 
     // Second pyramid, connects hammer neck to handle
     scale = glm::scale(glm::vec3(0.8f, 0.6f, 0.4f));
     rotation = glm::rotate(glm::radians(280.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.59f, 0.915f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gPyramidMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gPyramidMesh.nVertices);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
-    lightingShader.setFloat("material.shininess", 4.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureHammerHead);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularHammerHead);
+    // bind the part's material
+    useMaterial(lightingShader, parts.hammerMetal);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gCubeMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gCubeMesh.vao);
 
     // First cube, connects hammer's head with center
     scale = glm::scale(glm::vec3(0.39f, 0.9f, 0.27f));
     rotation = glm::rotate(glm::radians(8.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.82f, 0.6f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
 
     // Second cube, connects hammer's peen with center
     scale = glm::scale(glm::vec3(0.28f, 0.4f, 0.28f));
     rotation = glm::rotate(glm::radians(8.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.74f, 1.2f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gSphereMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gSphereMesh.vao);
 
     // First sphere, hammer peen
     scale = glm::scale(glm::vec3(0.25f, 0.25f, 0.25f));
     rotation = glm::rotate(glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.7f, 1.53f, 1.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gSphereMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gSphereMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 }
 
 
 // Creates the fire flower souvenir cup
-void SceneObjects::renderFireFlower(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData) {
+void SceneObjects::renderFireFlower(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData) {
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gCubeMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gCubeMesh.vao);
 
-    lightingShader.setFloat("material.shininess", 8.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureQuestion);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularPlastic);
+    // bind the part's material
+    useMaterial(lightingShader, parts.cupBase);
 
     // First cube, base
     glm::mat4 scale = glm::scale(glm::vec3(1.1f, 1.1f, 1.1f));
     glm::mat4 rotation = glm::rotate(glm::radians(40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     glm::mat4 translation = glm::translate(glm::vec3(-0.1f, 0.56f, -1.2f));
     // Model matrix: transformations are applied right-to-left order
-    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gCylinderMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gCylinderMesh.vao);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureClear);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.straw);
 
     // First cylinder, straw
     scale = glm::scale(glm::vec3(0.19f, 0.7f, 0.19f));
     rotation = glm::rotate(glm::radians(-2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(0.22f, 1.6f, -1.42f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    lightingShader.setFloat("material.shininess", 64.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureGreen);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularPlastic);
+    // bind the part's material
+    useMaterial(lightingShader, parts.flowerStem);
 
     // Second cylinder, flower stem bottom
     scale = glm::scale(glm::vec3(0.18f, 0.3f, 0.18f));
     rotation = glm::rotate(glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(-0.15f, 1.2f, -1.13f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Third cylinder, flower stem top
     scale = glm::scale(glm::vec3(0.175f, 0.15f, 0.175f));
@@ -223,10 +396,10 @@ void SceneObjects::renderFireFlower(MeshCreator gMesh, Textures gTexture, Shader
         * glm::rotate(glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(-0.225f, 1.59f, -1.075f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Fourth cylinder, connect stem to flower
     scale = glm::scale(glm::vec3(0.175f, 0.24f, 0.175f));
@@ -234,167 +407,139 @@ void SceneObjects::renderFireFlower(MeshCreator gMesh, Textures gTexture, Shader
         * glm::rotate(glm::radians(80.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(-0.475f, 1.72f, -0.9f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    lightingShader.setFloat("material.shininess", 26.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureOrange);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularPlastic);
+    // bind the part's material
+    useMaterial(lightingShader, parts.strawCap);
 
     // Fifth cylinder, straw cap
     scale = glm::scale(glm::vec3(0.24f, 0.07f, 0.24f));
     rotation = glm::rotate(glm::radians(-2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(0.245f, 2.3f, -1.42f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-    lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+    setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Sixth cylinder, straw cap connector
     scale = glm::scale(glm::vec3(0.24f, 0.01f, 0.24f));
     rotation = glm::rotate(glm::radians(-2.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(0.24f, 2.15f, -1.42f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-    lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+    setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gTorusMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gTorusMesh.vao);
 
 
-    lightingShader.setFloat("material.shininess", 26.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureOrange);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularPlastic);
+    // bind the part's material
+    useMaterial(lightingShader, parts.outerFlowerRing);
 
     // First torus, outer flower ring
     scale = glm::scale(glm::vec3(0.35f, 0.275f, 0.35f));
     rotation = glm::rotate(glm::radians(-50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(-0.7f, 1.75f, -0.75f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gTorusMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gTorusMesh.nVertices);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureYellow);
+    // bind the part's material
+    useMaterial(lightingShader, parts.innerFlowerRing);
 
     // Second torus, inner flower ring
     scale = glm::scale(glm::vec3(0.275f, 0.18f, 0.4f));
     rotation = glm::rotate(glm::radians(-50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(-0.7f, 1.75f, -0.75f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gTorusMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gTorusMesh.nVertices);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureEyes);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.flowerFace);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gSphereMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gSphereMesh.vao);
 
     // First sphere, flower face
     scale = glm::scale(glm::vec3(0.15f, 0.15f, 0.25f));
     rotation = glm::rotate(glm::radians(40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(-0.7f, 1.75f, -0.75f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gSphereMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gSphereMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
     
 }
 
 
 // Creates the popcorn music bucket
-void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData) {
+void SceneObjects::renderBucket(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData) {
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTexture4Panel);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureSnowflakes);
+    // bind the part's material
+    useMaterial(lightingShader, parts.bucketInside);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gCylinderMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gCylinderMesh.vao);
 
     // First cylinder, inside cylinder
     glm::mat4 scale = glm::scale(glm::vec3(3.0f, 0.8f, 3.0f));
     glm::mat4 rotation = glm::rotate(glm::radians(60.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     glm::mat4 translation = glm::translate(glm::vec3(1.82f, 1.3f, -1.3f));
     // Model matrix: transformations are applied right-to-left order
-    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    lightingShader.setFloat("material.shininess", 64.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureLeaf2);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularMetal);
-    lightingShader.setVec2("uvScale", glm::vec2(4.0f, 1.0f));
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.bucketBand);
 
     // Second cylinder, bottom of bucket
     scale = glm::scale(glm::vec3(3.45f, 0.25f, 3.45f));
     rotation = glm::rotate(glm::radians(105.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(1.8f, 0.26f, -1.3f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Third cylinder, top of bucket
     scale = glm::scale(glm::vec3(3.45f, 0.25f, 3.45f));
     rotation = glm::rotate(glm::radians(105.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(1.8f, 2.2f, -1.3f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
-
-    lightingShader.setVec2("uvScale", glm::vec2(1.0f, 1.0f));
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    lightingShader.setFloat("material.shininess", 32.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureBrass);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularMetal);
+    // bind the part's material
+    useMaterial(lightingShader, parts.mickeyEars);
 
     // Fourth cylinder, left mickey ear
     scale = glm::scale(glm::vec3(0.4f, 0.02f, 0.4f));
@@ -403,10 +548,10 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         glm::rotate(glm::radians(-135.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(1.68f, 2.85f, -1.38f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Fifth cylinder, right mickey ear
     scale = glm::scale(glm::vec3(0.4f, 0.02f, 0.4f));
@@ -415,22 +560,19 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         glm::rotate(glm::radians(135.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(1.91f, 2.85f, -1.18f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gCylinderMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureBrass);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularMetal);
+    // bind the part's material
+    useMaterial(lightingShader, parts.mickeyHead);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gSphereMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gSphereMesh.vao);
 
     // First sphere, mickey head
     scale = glm::scale(glm::vec3(0.15f, 0.15f, 0.15f));
@@ -438,25 +580,20 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         glm::rotate(glm::radians(45.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     translation = glm::translate(glm::vec3(1.8f, 2.69f, -1.3f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gSphereMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gSphereMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gPlaneMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gPlaneMesh.vao);
 
-    lightingShader.setFloat("material.shininess", 64.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureLeaf);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularMetal);
-    lightingShader.setVec2("uvScale", glm::vec2(1.0f, 1.5f));
+    // bind the part's material
+    useMaterial(lightingShader, parts.bucketDividers);
 
 
     // First plane, front scene divider
@@ -465,10 +602,10 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         * glm::rotate(glm::radians(30.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.42f, 1.21f, -0.575f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Second plane, left scene divider
     scale = glm::scale(glm::vec3(0.475f, 1.1f, 1.5f));
@@ -476,10 +613,10 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         * glm::rotate(glm::radians(120.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(1.095f, 1.21f, -1.72f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Third plane, back scene divider
     scale = glm::scale(glm::vec3(0.475f, 1.1f, 1.5f));
@@ -487,10 +624,10 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         * glm::rotate(glm::radians(210.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(2.22f, 1.21f, -2.01f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Fourth plane, right scene divider
     scale = glm::scale(glm::vec3(0.475f, 1.1f, 1.5f));
@@ -498,54 +635,44 @@ void SceneObjects::renderBucket(MeshCreator gMesh, Textures gTexture, Shader lig
         * glm::rotate(glm::radians(300.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(2.53f, 1.21f, -0.9f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-
-    //// reset gUVScale
-    lightingShader.setVec2("uvScale", glm::vec2(1.0f, 1.0f));
+    RenderStats::bindVertexArray(0);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gConeMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gConeMesh.vao);
 
-    lightingShader.setFloat("material.shininess", 64.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureLeaf);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularMetal);
+    // bind the part's material
+    useMaterial(lightingShader, parts.bucketLid);
 
     // first cone, lid
     scale = glm::scale(glm::vec3(0.86f, 0.22f, 0.86f));
     rotation = glm::rotate(glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(1.8f, 2.505f, -1.3f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gConeMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gConeMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 }
 
 
 // Creates the Japanese drink box
-void SceneObjects::renderDrinkBox(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData) {
+void SceneObjects::renderDrinkBox(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData) {
     
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureDrinkFront);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // bind the part's material
+    useMaterial(lightingShader, parts.drinkBox);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gFrustumPyramidMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gFrustumPyramidMesh.vao);
 
     // First frustum pyramid, drink box
     glm::mat4 scale = glm::scale(glm::vec3(1.35f, 1.35f, 1.35f));
@@ -553,20 +680,19 @@ void SceneObjects::renderDrinkBox(MeshCreator gMesh, Textures gTexture, Shader l
     glm::mat4 translation = glm::translate(glm::vec3(-1.875f, 0.676f, -1.0f));
     // Model matrix: transformations are applied right-to-left order
     glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;
-	lightingShader.setMat4("model", model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gFrustumPyramidMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gFrustumPyramidMesh.nVertices);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gPlaneMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gPlaneMesh.vao);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureDrinkTop);
+    // bind the part's material
+    useMaterial(lightingShader, parts.drinkLid);
 
     // First plane, drink box lid
     scale = glm::scale(glm::vec3(0.535f, 1.0f, 0.535f));
@@ -575,22 +701,21 @@ void SceneObjects::renderDrinkBox(MeshCreator gMesh, Textures gTexture, Shader l
     translation = glm::translate(glm::vec3(-1.88f, 1.7f, -1.0f));
     // Model matrix: transformations are applied right-to-left order
     model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;
-	lightingShader.setMat4("model", model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 }
 
-void SceneObjects::renderRoom(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData) {
+void SceneObjects::renderRoom(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData) {
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gPlaneMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gPlaneMesh.vao);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureGrass);
+    // bind the part's material
+    useMaterial(lightingShader, parts.floor);
 
     // Render floor for 3D scene
     // 1. Scales the object
@@ -601,16 +726,17 @@ void SceneObjects::renderRoom(MeshCreator gMesh, Textures gTexture, Shader light
 
     glm::mat4 translation = glm::translate(glm::vec3(0.0f, -3.0f, -6.0f));
     // Transformations are applied right-to-left order
-    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    glm::mat4 model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
 
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureFence);
-    lightingShader.setVec2("uvScale", glm::vec2(2.0f, 1.0f));
+    // the walls are timed on their own: the fence texture is large and mostly seen from far away,
+    // so their GPU time shows how well its texture fetches are cached under each --texture-filter
+    GpuProfiler::shared().beginScope("fence");
+    // bind the part's material
+    useMaterial(lightingShader, parts.walls);
 
     // Render Left Wall
     scale = glm::scale(glm::vec3(34.55f, 1.0f, 6.0f));
@@ -618,10 +744,10 @@ void SceneObjects::renderRoom(MeshCreator gMesh, Textures gTexture, Shader light
         glm::rotate(glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(-12.0f, 0.0f, -6.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
     
     // Render Right Wall
     scale = glm::scale(glm::vec3(34.55f, 1.0f, 6.0f));
@@ -629,20 +755,20 @@ void SceneObjects::renderRoom(MeshCreator gMesh, Textures gTexture, Shader light
         glm::rotate(glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(12.0f, 0.0f, -6.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Render Back Wall
     scale = glm::scale(glm::vec3(24.0f, 1.0f, 6.0f));
     rotation = glm::rotate(glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
     translation = glm::translate(glm::vec3(0.0f, 0.0f, -23.25f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
     
     // Render Front Wall (Behind default camera)
     scale = glm::scale(glm::vec3(24.0f, 1.0f, 6.0f));
@@ -650,64 +776,54 @@ void SceneObjects::renderRoom(MeshCreator gMesh, Textures gTexture, Shader light
         glm::rotate(glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(0.0f, 0.0f, 11.25f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-	lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+	setModel(lightingShader, model);
     // Draws the triangles
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    GpuProfiler::shared().endScope();
 
-    lightingShader.setFloat("material.shininess", 32.0f);
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureDesk);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gSpecularPlastic);
-    lightingShader.setVec2("uvScale", glm::vec2(1.0f, 1.0f));
+    // bind the part's material
+    useMaterial(lightingShader, parts.deskTop);
 
     // Plane on top of desk
     scale = glm::scale(glm::vec3(5.5f, 1.0f, 4.5f));
     rotation = glm::rotate(glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     translation = glm::translate(glm::vec3(0.0f, 0.0f, 0.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-    lightingShader.setMat4("model", model);
-    glDrawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+    setModel(lightingShader, model);
+    RenderStats::drawElements(GL_TRIANGLES, gMesh.gPlaneMesh.nIndices, GL_UNSIGNED_SHORT, NULL);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
+    RenderStats::bindVertexArray(0);
 
     // Activate the VBOs contained within the mesh's VAO
-    glBindVertexArray(gMesh.gCubeMesh.vao);
+    RenderStats::bindVertexArray(gMesh.gCubeMesh.vao);
 
     // First cube, Top of Desk
     scale = glm::scale(glm::vec3(5.5f, 0.3f, 4.5f));
     rotation = glm::rotate(glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(0.0f, -0.15f, 0.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-    lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+    setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
-
-    // bind textures on corresponding texture units
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gTexture.gTextureBrick);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
 
-    lightingShader.setVec2("uvScale", glm::vec2(0.5f, 0.5f));
+    // bind the part's material
+    useMaterial(lightingShader, parts.deskBody);
 
     // Second cube, Desk body
     scale = glm::scale(glm::vec3(5.0f, 2.7f, 4.0f));
     rotation = glm::rotate(glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
     translation = glm::translate(glm::vec3(0.0f, -1.65f, 0.0f));
     // Model matrix: transformations are applied right-to-left order
-    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	lightingShader.setMat4("model", model);
-    lightingShader.setMat4("model", model);
+    model = transformData.translation * transformData.rotation * transformData.scale * translation * rotation * scale;	setModel(lightingShader, model);
+    setModel(lightingShader, model);
     // Draws the triangles
-    glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+    RenderStats::drawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
 
     // Deactivate the Vertex Array Object
-    glBindVertexArray(0);
-
-    // reset UV scale
-    lightingShader.setVec2("uvScale", glm::vec2(1.0f, 1.0f));
+    RenderStats::bindVertexArray(0);
 
 }
\ No newline at end of file
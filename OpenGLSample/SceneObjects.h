@@ -11,6 +11,13 @@
 #include "MeshCreator.h"
 #include "Textures.h"
 #include "shader.h"
+#include "GpuProfiler.h"
+#include "TextureArrays.h"
+#include "TextureSamplers.h"
+#include "TextureStreamer.h"
+#include "Materials.h"
+#include "BindlessMaterials.h"
+#include "ResourceManager.h"
 
 // GLM Math Header inclusions
 #include <glm/gtx/transform.hpp>
@@ -28,22 +35,73 @@ class SceneObjects
 {
 
 public:
-	void createScene(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData) {
-		renderHammer(gMesh, gTexture, lightingShader, transformData);
-		renderFireFlower(gMesh, gTexture, lightingShader, transformData);
-		renderBucket(gMesh, gTexture, lightingShader, transformData);
-		renderDrinkBox(gMesh, gTexture, lightingShader, transformData);
-		renderRoom(gMesh, gTexture, lightingShader, transformData);
+	void createScene(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData) {
+		// the frame set its own defaults since the last material
+		currentMaterial = Materials::NONE;
+		if (bindlessMaterials)
+			bindlessMaterials->bind(lightingShader);
+		// each object is timed separately by the GPU profiler
+		{ GPU_SCOPE("hammer"); renderHammer(gMesh, lightingShader, transformData); }
+		{ GPU_SCOPE("fire flower"); renderFireFlower(gMesh, lightingShader, transformData); }
+		{ GPU_SCOPE("bucket"); renderBucket(gMesh, lightingShader, transformData); }
+		{ GPU_SCOPE("drink box"); renderDrinkBox(gMesh, lightingShader, transformData); }
+		{ GPU_SCOPE("room"); renderRoom(gMesh, lightingShader, transformData); }
+		if (textureSamplers)
+			textureSamplers->unbind();
 	}
 	// Creates the ball-peen hammer
-	void renderHammer(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData);
+	void renderHammer(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData);
 	// Creates the fire flower souvenir cup
-	void renderFireFlower(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData);
+	void renderFireFlower(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData);
 	// Creates the popcorn music bucket
-	void renderBucket(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData);
+	void renderBucket(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData);
 	// Creates the Japanese drink box
-	void renderDrinkBox(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData);
+	void renderDrinkBox(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData);
 	// Creates walled fence, ground, and table
-	void renderRoom(MeshCreator gMesh, Textures gTexture, Shader lightingShader, Transform transformData);
+	void renderRoom(const MeshCreator& gMesh, const Shader& lightingShader, Transform transformData);
+
+	// Takes a reference on every mesh and texture the scene draws with, creating the ones that
+	// aren't resident yet; they stay until releaseResources
+	void acquireResources(ResourceManager& resources);
+	void releaseResources(ResourceManager& resources);
+	// Registers the material of every part, once the textures are loaded
+	void createMaterials(const Textures& gTexture);
+	// Draws the cube draws times, each with a material of its own, through the bind path and,
+	// when bindlessMaterials is set, through bindlessShader, and prints the CPU submit time of both
+	void runMaterialBenchmark(const MeshCreator& gMesh, const Textures& gTexture, const Shader& bindShader, const Shader& bindlessShader, int draws);
+
+	// When set, material textures are layers of these arrays and the lit shader is 6.multiple_lights_array.fs
+	TextureArrays* textureArrays = nullptr;
+	// When set, each material texture unit also gets the sampler for the texture's wrap mode
+	TextureSamplers* textureSamplers = nullptr;
+	// When set, every draw reports the screen size of its textures to the streamer
+	TextureStreamer* textureStreamer = nullptr;
+	// When set, materials are indices into its table and the lit shader is 6.multiple_lights_bindless.fs
+	BindlessMaterials* bindlessMaterials = nullptr;
+
+private:
+	void bindTexture(const Shader& lightingShader, int unit, GLuint texture);
+	void setModel(const Shader& lightingShader, const glm::mat4& model);
+	// Makes a material current, setting only the textures and uniforms that differ from the current one
+	void useMaterial(const Shader& lightingShader, Materials::Id id);
+
+	Materials materials;
+	Materials::Id currentMaterial = Materials::NONE;
+	// material of each part of the scene, parts that look alike share one
+	struct PartMaterials
+	{
+		Materials::Id hammerMetal, hammerWood;
+		Materials::Id cupBase, straw, flowerStem, strawCap, outerFlowerRing, innerFlowerRing, flowerFace;
+		Materials::Id bucketInside, bucketBand, mickeyEars, mickeyHead, bucketDividers, bucketLid;
+		Materials::Id drinkBox, drinkLid;
+		Materials::Id floor, walls, deskTop, deskBody;
+	};
+	PartMaterials parts = {};
+
+	std::vector<MeshHandle> meshHandles;
+	std::vector<TextureHandle> textureHandles;
+
+	// material textures on units 0-2, as last bound
+	GLuint boundTextures[3] = { 0, 0, 0 };
 };
 
@@ -0,0 +1,216 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ShaderCache.cpp                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Single loader for every shader program in the project. Reads shader files  //
+// once, resolves #include directives, and compiles each unique stage only once so         //
+// programs built from the same source share the compiled shader object.                    //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderCache.h"
+#include <fstream>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Stops a file that includes itself from looping forever
+    const int MAX_INCLUDE_DEPTH = 16;
+
+    // Folder part of a path, including the trailing slash
+    string directoryOf(const string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        return (slash == string::npos) ? string() : path.substr(0, slash + 1);
+    }
+
+    const char* stageName(GLenum type)
+    {
+        if (type == GL_VERTEX_SHADER)
+            return "VERTEX";
+        if (type == GL_FRAGMENT_SHADER)
+            return "FRAGMENT";
+        return "GEOMETRY";
+    }
+}
+
+ShaderCache& ShaderCache::shared()
+{
+    static ShaderCache cache;
+    return cache;
+}
+
+// Reads a whole file straight into a string, once per path
+const string& ShaderCache::readFile(const string& path)
+{
+    auto found = fileCache.find(path);
+    if (found != fileCache.end())
+    {
+        ++sourceHits;
+        return found->second;
+    }
+
+    string contents;
+    ifstream file(path, ios::in | ios::binary);
+    if (file.is_open())
+    {
+        file.seekg(0, ios::end);
+        contents.resize((size_t)file.tellg());
+        file.seekg(0, ios::beg);
+        file.read(&contents[0], contents.size());
+        ++filesRead;
+    }
+    else
+    {
+        cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << endl;
+    }
+    return fileCache.emplace(path, move(contents)).first->second;
+}
+
+// Replaces each #include "file" line with the contents of that file
+string ShaderCache::expandIncludes(const string& path, int depth)
+{
+    const string& source = readFile(path);
+    if (depth > MAX_INCLUDE_DEPTH)
+    {
+        cout << "ERROR::SHADER::INCLUDE_TOO_DEEP: " << path << endl;
+        return string();
+    }
+
+    string result;
+    result.reserve(source.size());
+    size_t lineStart = 0;
+    while (lineStart < source.size())
+    {
+        size_t lineEnd = source.find('\n', lineStart);
+        if (lineEnd == string::npos)
+            lineEnd = source.size();
+
+        size_t first = source.find_first_not_of(" \t", lineStart);
+        bool isInclude = first != string::npos && first < lineEnd && source.compare(first, 8, "#include") == 0;
+        if (isInclude)
+        {
+            size_t open = source.find('"', first);
+            size_t close = (open == string::npos) ? string::npos : source.find('"', open + 1);
+            if (close != string::npos && close < lineEnd)
+            {
+                string includePath = directoryOf(path) + source.substr(open + 1, close - open - 1);
+                result += expandIncludes(includePath, depth + 1);
+                result += '\n';
+            }
+            else
+            {
+                cout << "ERROR::SHADER::BAD_INCLUDE in " << path << endl;
+            }
+        }
+        else
+        {
+            result.append(source, lineStart, lineEnd - lineStart);
+            result += '\n';
+        }
+        lineStart = lineEnd + 1;
+    }
+    return result;
+}
+
+const string& ShaderCache::resolveSource(const string& path)
+{
+    auto found = resolvedCache.find(path);
+    if (found != resolvedCache.end())
+        return found->second;
+    return resolvedCache.emplace(path, expandIncludes(path, 0)).first->second;
+}
+
+GLuint ShaderCache::compileStage(GLenum type, const string& path)
+{
+    const string& source = resolveSource(path);
+
+    // Identical sources produce identical stages, so key on the text rather than the file name
+    string key = to_string(type) + ':' + source;
+    auto found = stageCache.find(key);
+    if (found != stageCache.end())
+    {
+        ++stageHits;
+        return found->second;
+    }
+
+    const char* code = source.c_str();
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &code, NULL);
+    glCompileShader(shader);
+    checkCompileErrors(shader, stageName(type));
+    ++stagesCompiled;
+
+    stageCache.emplace(move(key), shader);
+    return shader;
+}
+
+GLuint ShaderCache::linkProgram(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
+{
+    GLuint vertex = compileStage(GL_VERTEX_SHADER, vertexPath);
+    GLuint fragment = compileStage(GL_FRAGMENT_SHADER, fragmentPath);
+    GLuint geometry = 0;
+    if (geometryPath != nullptr)
+        geometry = compileStage(GL_GEOMETRY_SHADER, geometryPath);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    if (geometry != 0)
+        glAttachShader(program, geometry);
+    glLinkProgram(program);
+    checkCompileErrors(program, "PROGRAM");
+
+    // detach so the cached stages can be deleted independently of the program
+    glDetachShader(program, vertex);
+    glDetachShader(program, fragment);
+    if (geometry != 0)
+        glDetachShader(program, geometry);
+
+    return program;
+}
+
+void ShaderCache::releaseStages()
+{
+    for (auto& stage : stageCache)
+        glDeleteShader(stage.second);
+    stageCache.clear();
+}
+
+void ShaderCache::clearSources()
+{
+    fileCache.clear();
+    resolvedCache.clear();
+}
+
+void ShaderCache::printStats() const
+{
+    cout << "Shader cache: " << filesRead << " files read, " << sourceHits << " source cache hits, "
+        << stagesCompiled << " stages compiled, " << stageHits << " stages reused" << endl;
+}
+
+// utility function for checking shader compilation/linking errors.
+bool ShaderCache::checkCompileErrors(GLuint shader, const string& type)
+{
+    GLint success;
+    GLchar infoLog[1024];
+    if (type != "PROGRAM")
+    {
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+            cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << endl;
+        }
+    }
+    else
+    {
+        glGetProgramiv(shader, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+            cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << endl;
+        }
+    }
+    return success != 0;
+}
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ShaderCache.h                                                                      //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Single loader for every shader program in the project. Reads shader files  //
+// once, resolves #include directives, and compiles each unique stage only once so         //
+// programs built from the same source share the compiled shader object.                    //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <unordered_map>
+
+// Caches shader sources and compiled shader stages, then links them into programs
+class ShaderCache
+{
+public:
+    // Cache shared by the Shader class and LoadShaders
+    static ShaderCache& shared();
+
+    // Compiles (or reuses) the stages and links them into a new program
+    GLuint linkProgram(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+    // Returns the file with all #include "file" directives expanded, relative to the including file
+    const std::string& resolveSource(const std::string& path);
+    // Compiles a stage, or returns the existing shader object for an identical source
+    GLuint compileStage(GLenum type, const std::string& path);
+
+    // Deletes the cached shader objects; programs that were already linked keep working
+    void releaseStages();
+    // Drops cached file contents so edited files are read again
+    void clearSources();
+    void printStats() const;
+
+    static bool checkCompileErrors(GLuint shader, const std::string& type);
+
+private:
+    const std::string& readFile(const std::string& path);
+    std::string expandIncludes(const std::string& path, int depth);
+
+    std::unordered_map<std::string, std::string> fileCache;      // path -> raw file contents
+    std::unordered_map<std::string, std::string> resolvedCache;  // path -> source with includes expanded
+    std::unordered_map<std::string, GLuint> stageCache;          // stage type + source -> shader object
+
+    unsigned int filesRead = 0;
+    unsigned int sourceHits = 0;
+    unsigned int stagesCompiled = 0;
+    unsigned int stageHits = 0;
+};
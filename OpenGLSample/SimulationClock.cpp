@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: SimulationClock.cpp                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Fixed timestep clock that keeps movement independent of the frame rate.   //
+// Elapsed time is kept in a double precision accumulator and consumed in equal steps;     //
+// the leftover fraction is used to interpolate what gets rendered.                        //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SimulationClock.h"
+
+namespace
+{
+    // A long hitch (window drag, breakpoint) is dropped instead of simulated in a burst
+    const double MAX_FRAME_SECONDS = 0.25;
+}
+
+SimulationClock::SimulationClock(double stepSeconds) : stepLength(stepSeconds)
+{
+}
+
+void SimulationClock::reset(double now)
+{
+    lastTime = now;
+    accumulator = 0.0;
+}
+
+void SimulationClock::advance(double now)
+{
+    double elapsed = now - lastTime;
+    lastTime = now;
+    if (elapsed > MAX_FRAME_SECONDS)
+        elapsed = MAX_FRAME_SECONDS;
+    if (elapsed > 0.0)
+        accumulator += elapsed;
+}
+
+bool SimulationClock::step()
+{
+    if (accumulator < stepLength)
+        return false;
+
+    accumulator -= stepLength;
+    simTime += stepLength;
+    ++stepCount;
+    return true;
+}
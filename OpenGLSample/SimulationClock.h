@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: SimulationClock.h                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Fixed timestep clock that keeps movement independent of the frame rate.   //
+// Elapsed time is kept in a double precision accumulator and consumed in equal steps;     //
+// the leftover fraction is used to interpolate what gets rendered.                        //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Splits real elapsed time into fixed simulation steps
+class SimulationClock
+{
+public:
+    explicit SimulationClock(double stepSeconds = 1.0 / 120.0);
+
+    // Restarts timing from now without simulating the time in between (startup, after sleeping)
+    void reset(double now);
+    // Adds the real time elapsed since the last call to the accumulator
+    void advance(double now);
+    // Consumes one step from the accumulator, returns false when less than a step is left
+    bool step();
+    // Takes one step without touching the accumulator, used when replaying recorded input
+    void forceStep() { simTime += stepLength; ++stepCount; }
+
+    void setStepSeconds(double seconds) { stepLength = seconds; }
+    float stepSeconds() const { return (float)stepLength; }
+    // How far between the previous and current simulation state the rendered frame is, 0..1
+    float alpha() const { return (float)(accumulator / stepLength); }
+    double simulatedTime() const { return simTime; }
+    unsigned long long steps() const { return stepCount; }
+
+private:
+    double stepLength;
+    double accumulator = 0.0;
+    double lastTime = 0.0;
+    double simTime = 0.0;
+    unsigned long long stepCount = 0;
+};
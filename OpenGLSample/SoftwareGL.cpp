@@ -0,0 +1,752 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: SoftwareGL.cpp                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Software implementation of the OpenGL calls this program makes. It is      //
+// installed in place of the driver's entry points, so the meshes, textures, shaders and  //
+// scene objects run unchanged and their draws go to the SoftwareRasterizer.               //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareGL.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std; // Standard namespace
+
+namespace
+{
+    const int MAX_ATTRIBUTES = 16;
+    const int MAX_TEXTURE_UNITS = 16;
+
+    struct Attribute
+    {
+        bool enabled = false;
+        GLint size = 4;
+        GLenum type = GL_FLOAT;
+        GLsizei stride = 0;
+        size_t offset = 0;
+        GLuint buffer = 0;
+    };
+
+    struct VertexArray
+    {
+        GLuint elementBuffer = 0;
+        Attribute attributes[MAX_ATTRIBUTES];
+    };
+
+    // Uniform values live in the program like in GL; locations are handed out by name
+    struct Program
+    {
+        SoftwareShader shader = SoftwareShader::Flat;
+        vector<GLuint> stages;
+        unordered_map<string, GLint> locations;
+        vector<array<float, 16>> values;
+    };
+
+    struct Shader
+    {
+        GLenum type;
+        string source;
+    };
+
+    struct State
+    {
+        unique_ptr<SoftwareRasterizer> rasterizer;
+        function<void(const SoftwareDraw&)> drawListener;
+        string rendererName;
+        GLuint nextName = 1;
+
+        unordered_map<GLuint, vector<uint8_t>> buffers;
+        unordered_map<GLuint, VertexArray> vertexArrays;
+        unordered_map<GLuint, shared_ptr<SoftwareTexture>> textures;
+        unordered_map<GLuint, Shader> shaders;
+        unordered_map<GLuint, Program> programs;
+
+        GLuint arrayBuffer = 0;
+        GLuint pixelPackBuffer = 0;
+        GLuint pixelUnpackBuffer = 0;
+        GLuint vertexArray = 0;
+        GLuint program = 0;
+        GLuint textureUnits[MAX_TEXTURE_UNITS][2] = {};  // 2D and cube map binding per unit
+        int activeUnit = 0;
+        GLint packAlignment = 4;
+        GLint unpackAlignment = 4;
+
+        glm::vec4 clearColor = glm::vec4(0.0f);
+        bool depthTest = false;
+        GLenum depthFunc = GL_LESS;
+    };
+
+    State& state()
+    {
+        static State instance;
+        return instance;
+    }
+
+    GLuint& boundBuffer(GLenum target)
+    {
+        State& gl = state();
+        if (target == GL_ELEMENT_ARRAY_BUFFER)
+            return gl.vertexArrays[gl.vertexArray].elementBuffer;
+        if (target == GL_PIXEL_PACK_BUFFER)
+            return gl.pixelPackBuffer;
+        if (target == GL_PIXEL_UNPACK_BUFFER)
+            return gl.pixelUnpackBuffer;
+        return gl.arrayBuffer;
+    }
+
+    bool isCubeTarget(GLenum target)
+    {
+        return target == GL_TEXTURE_CUBE_MAP || (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z);
+    }
+
+    // The texture object bound to the active unit, copied first if a pending draw still uses it
+    shared_ptr<SoftwareTexture> boundTexture(GLenum target, bool forWriting)
+    {
+        State& gl = state();
+        GLuint name = gl.textureUnits[gl.activeUnit][isCubeTarget(target) ? 1 : 0];
+        auto found = gl.textures.find(name);
+        if (found == gl.textures.end())
+            return nullptr;
+        if (forWriting && found->second.use_count() > 1)
+            found->second = make_shared<SoftwareTexture>(*found->second);
+        return found->second;
+    }
+
+    void genNames(GLsizei count, GLuint* names)
+    {
+        for (GLsizei i = 0; i < count; ++i)
+            names[i] = state().nextName++;
+    }
+
+    const float* uniform(const Program& program, const char* name)
+    {
+        static const float zero[16] = {};
+        auto found = program.locations.find(name);
+        if (found == program.locations.end() || found->second >= (GLint)program.values.size())
+            return zero;
+        return program.values[found->second].data();
+    }
+
+    glm::vec3 uniformVec3(const Program& program, const string& name)
+    {
+        const float* value = uniform(program, name.c_str());
+        return glm::vec3(value[0], value[1], value[2]);
+    }
+
+    glm::mat4 uniformMat4(const Program& program, const char* name)
+    {
+        const float* value = uniform(program, name);
+        glm::mat4 matrix;
+        for (int column = 0; column < 4; ++column)
+            for (int row = 0; row < 4; ++row)
+                matrix[column][row] = value[column * 4 + row];
+        return matrix;
+    }
+
+    // Texture bound to the unit a sampler uniform points at
+    shared_ptr<const SoftwareTexture> samplerTexture(const Program& program, const char* sampler, bool cube)
+    {
+        State& gl = state();
+        int unit = (int)uniform(program, sampler)[0];
+        if (unit < 0 || unit >= MAX_TEXTURE_UNITS)
+            return nullptr;
+        auto found = gl.textures.find(gl.textureUnits[unit][cube ? 1 : 0]);
+        if (found == gl.textures.end() || found->second->images[0].texels.empty())
+            return nullptr;
+        return found->second;
+    }
+
+    SoftwareDraw::Attribute attributeStream(const VertexArray& vao, int location, size_t& vertexCount)
+    {
+        SoftwareDraw::Attribute stream;
+        const Attribute& attribute = vao.attributes[location];
+        auto buffer = state().buffers.find(attribute.buffer);
+        // the shaders read float vectors; anything else is left disabled
+        if (!attribute.enabled || attribute.type != GL_FLOAT || buffer == state().buffers.end())
+            return stream;
+        int stride = attribute.stride != 0 ? attribute.stride : attribute.size * (int)sizeof(float);
+        size_t bytes = buffer->second.size();
+        if (attribute.offset + attribute.size * sizeof(float) > bytes)
+            return stream;
+        stream.data = buffer->second.data() + attribute.offset;
+        stream.stride = stride;
+        vertexCount = min(vertexCount, (bytes - attribute.offset - attribute.size * sizeof(float)) / stride + 1);
+        return stream;
+    }
+
+    // Gathers the draw from the bound program, vertex array and textures
+    void submitDraw(GLenum mode, GLint first, GLsizei count, GLenum indexType, const void* indices, bool indexed)
+    {
+        State& gl = state();
+        auto program = gl.programs.find(gl.program);
+        if (mode != GL_TRIANGLES || program == gl.programs.end())
+            return;
+        const Program& p = program->second;
+        const VertexArray& vao = gl.vertexArrays[gl.vertexArray];
+
+        SoftwareDraw draw;
+        draw.shader = p.shader;
+        draw.depthTest = gl.depthTest;
+        draw.depthFunc = gl.depthFunc;
+        draw.first = first;
+        draw.count = count;
+        draw.vertexCount = SIZE_MAX;
+        draw.position = attributeStream(vao, 0, draw.vertexCount);
+        if (!draw.position.data)
+            return;
+        if (p.shader == SoftwareShader::Phong)
+        {
+            draw.normal = attributeStream(vao, 1, draw.vertexCount);
+            draw.texCoords = attributeStream(vao, 2, draw.vertexCount);
+        }
+        if (indexed)
+        {
+            // the pointer is an offset into the element buffer
+            auto elements = gl.buffers.find(vao.elementBuffer);
+            if (elements == gl.buffers.end())
+                return;
+            size_t indexSize = indexType == GL_UNSIGNED_INT ? 4 : (indexType == GL_UNSIGNED_SHORT ? 2 : 1);
+            size_t offset = (size_t)indices;
+            if (offset + (size_t)count * indexSize > elements->second.size())
+                return;
+            draw.indices = elements->second.data() + offset;
+            draw.indexType = indexType;
+            draw.first = 0;
+        }
+
+        draw.model = uniformMat4(p, "model");
+        draw.view = uniformMat4(p, "view");
+        draw.projection = uniformMat4(p, "projection");
+        if (p.shader == SoftwareShader::Skybox)
+        {
+            draw.cubeMap = samplerTexture(p, "skybox", true);
+        }
+        else if (p.shader == SoftwareShader::Phong)
+        {
+            draw.viewPos = uniformVec3(p, "viewPos");
+            draw.shininess = uniform(p, "material.shininess")[0];
+            draw.uvScale = glm::vec2(uniform(p, "uvScale")[0], uniform(p, "uvScale")[1]);
+            draw.diffuse = samplerTexture(p, "material.diffuse", false);
+            draw.specular = samplerTexture(p, "material.specular", false);
+            draw.overlay = samplerTexture(p, "textureOverlay", false);
+
+            draw.dirLight.direction = uniformVec3(p, "dirLight.direction");
+            draw.dirLight.ambient = uniformVec3(p, "dirLight.ambient");
+            draw.dirLight.diffuse = uniformVec3(p, "dirLight.diffuse");
+            draw.dirLight.specular = uniformVec3(p, "dirLight.specular");
+            for (int i = 0; i < 2; ++i)
+            {
+                string name = "pointLights[" + to_string(i) + "].";
+                SoftwareDraw::PointLight& light = draw.pointLights[i];
+                light.position = uniformVec3(p, name + "position");
+                light.constant = uniform(p, (name + "constant").c_str())[0];
+                light.linear = uniform(p, (name + "linear").c_str())[0];
+                light.quadratic = uniform(p, (name + "quadratic").c_str())[0];
+                light.intensity = uniform(p, (name + "intensity").c_str())[0];
+                light.ambient = uniformVec3(p, name + "ambient");
+                light.diffuse = uniformVec3(p, name + "diffuse");
+                light.specular = uniformVec3(p, name + "specular");
+            }
+            SoftwareDraw::SpotLight& spot = draw.spotLight;
+            spot.position = uniformVec3(p, "spotLight.position");
+            spot.direction = uniformVec3(p, "spotLight.direction");
+            spot.cutOff = uniform(p, "spotLight.cutOff")[0];
+            spot.outerCutOff = uniform(p, "spotLight.outerCutOff")[0];
+            spot.constant = uniform(p, "spotLight.constant")[0];
+            spot.linear = uniform(p, "spotLight.linear")[0];
+            spot.quadratic = uniform(p, "spotLight.quadratic")[0];
+            spot.ambient = uniformVec3(p, "spotLight.ambient");
+            spot.diffuse = uniformVec3(p, "spotLight.diffuse");
+            spot.specular = uniformVec3(p, "spotLight.specular");
+        }
+        if (gl.drawListener)
+            gl.drawListener(draw);
+        gl.rasterizer->draw(draw);
+    }
+
+    void setUniform(GLint location, const float* values, int count)
+    {
+        State& gl = state();
+        auto program = gl.programs.find(gl.program);
+        if (location < 0 || program == gl.programs.end() || location >= (GLint)program->second.values.size())
+            return;
+        array<float, 16>& slot = program->second.values[location];
+        copy(values, values + count, slot.begin());
+    }
+
+    // --- buffers and vertex arrays ---
+
+    void APIENTRY swGenBuffers(GLsizei n, GLuint* buffers) { genNames(n, buffers); }
+    void APIENTRY swGenVertexArrays(GLsizei n, GLuint* arrays) { genNames(n, arrays); }
+
+    void APIENTRY swDeleteBuffers(GLsizei n, const GLuint* buffers)
+    {
+        for (GLsizei i = 0; i < n; ++i)
+            state().buffers.erase(buffers[i]);
+    }
+
+    void APIENTRY swDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+    {
+        for (GLsizei i = 0; i < n; ++i)
+            state().vertexArrays.erase(arrays[i]);
+    }
+
+    void APIENTRY swBindBuffer(GLenum target, GLuint buffer) { boundBuffer(target) = buffer; }
+    void APIENTRY swBindVertexArray(GLuint array) { state().vertexArray = array; }
+
+    void APIENTRY swBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+    {
+        vector<uint8_t>& buffer = state().buffers[boundBuffer(target)];
+        buffer.assign((size_t)size, 0);
+        if (data)
+            memcpy(buffer.data(), data, (size_t)size);
+    }
+
+    void* APIENTRY swMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield)
+    {
+        auto found = state().buffers.find(boundBuffer(target));
+        if (found == state().buffers.end() || (size_t)(offset + length) > found->second.size())
+            return nullptr;
+        return found->second.data() + offset;
+    }
+
+    GLboolean APIENTRY swUnmapBuffer(GLenum) { return GL_TRUE; }
+
+    void APIENTRY swVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean, GLsizei stride, const void* pointer)
+    {
+        if (index >= MAX_ATTRIBUTES)
+            return;
+        State& gl = state();
+        Attribute& attribute = gl.vertexArrays[gl.vertexArray].attributes[index];
+        attribute.size = size;
+        attribute.type = type;
+        attribute.stride = stride;
+        attribute.offset = (size_t)pointer;
+        attribute.buffer = gl.arrayBuffer;
+    }
+
+    void APIENTRY swEnableVertexAttribArray(GLuint index)
+    {
+        if (index < MAX_ATTRIBUTES)
+            state().vertexArrays[state().vertexArray].attributes[index].enabled = true;
+    }
+
+    // --- textures ---
+
+    void APIENTRY swGenTextures(GLsizei n, GLuint* textures) { genNames(n, textures); }
+
+    void APIENTRY swDeleteTextures(GLsizei n, const GLuint* textures)
+    {
+        // draws that still need the texture hold their own reference
+        for (GLsizei i = 0; i < n; ++i)
+            state().textures.erase(textures[i]);
+    }
+
+    void APIENTRY swActiveTexture(GLenum texture)
+    {
+        int unit = (int)(texture - GL_TEXTURE0);
+        if (unit >= 0 && unit < MAX_TEXTURE_UNITS)
+            state().activeUnit = unit;
+    }
+
+    void APIENTRY swBindTexture(GLenum target, GLuint texture)
+    {
+        State& gl = state();
+        gl.textureUnits[gl.activeUnit][target == GL_TEXTURE_CUBE_MAP ? 1 : 0] = texture;
+        if (texture != 0 && gl.textures.find(texture) == gl.textures.end())
+        {
+            gl.textures[texture] = make_shared<SoftwareTexture>();
+            gl.textures[texture]->target = target;
+        }
+    }
+
+    // Converts to RGBA8, honoring the unpack row alignment like the driver would
+    void APIENTRY swTexImage2D(GLenum target, GLint level, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels)
+    {
+        shared_ptr<SoftwareTexture> texture = boundTexture(target, true);
+        if (!texture || level != 0)
+            return;
+        int face = isCubeTarget(target) && target != GL_TEXTURE_CUBE_MAP ? (int)(target - GL_TEXTURE_CUBE_MAP_POSITIVE_X) : 0;
+        SoftwareTexture::Image& image = texture->images[face];
+        image.width = width;
+        image.height = height;
+        image.texels.assign((size_t)width * height * 4, 0);
+        int channels = format == GL_RED ? 1 : (format == GL_RG ? 2 : (format == GL_RGB ? 3 : 4));
+        if (!pixels || type != GL_UNSIGNED_BYTE)
+            return;
+
+        const uint8_t* source = (const uint8_t*)pixels;
+        int alignment = state().unpackAlignment;
+        size_t rowBytes = ((size_t)width * channels + alignment - 1) / alignment * alignment;
+        for (int y = 0; y < height; ++y)
+        {
+            const uint8_t* row = source + y * rowBytes;
+            uint8_t* out = &image.texels[(size_t)y * width * 4];
+            for (int x = 0; x < width; ++x, out += 4)
+            {
+                const uint8_t* texel = row + x * channels;
+                out[0] = texel[0];
+                out[1] = channels > 1 ? texel[1] : 0;
+                out[2] = channels > 2 ? texel[2] : 0;
+                out[3] = channels > 3 ? texel[3] : 255;
+            }
+        }
+    }
+
+    void APIENTRY swTexParameteri(GLenum target, GLenum pname, GLint param)
+    {
+        shared_ptr<SoftwareTexture> texture = boundTexture(target, true);
+        if (!texture)
+            return;
+        if (pname == GL_TEXTURE_WRAP_S)
+            texture->wrapS = param;
+        else if (pname == GL_TEXTURE_WRAP_T)
+            texture->wrapT = param;
+    }
+
+    // only the base level is sampled, GL_LINEAR minification never reads the others
+    void APIENTRY swGenerateMipmap(GLenum) {}
+
+    void APIENTRY swPixelStorei(GLenum pname, GLint param)
+    {
+        if (pname == GL_PACK_ALIGNMENT)
+            state().packAlignment = param;
+        else if (pname == GL_UNPACK_ALIGNMENT)
+            state().unpackAlignment = param;
+    }
+
+    // --- shaders and uniforms ---
+
+    GLuint APIENTRY swCreateShader(GLenum type)
+    {
+        GLuint name = state().nextName++;
+        state().shaders[name] = Shader{ type, string() };
+        return name;
+    }
+
+    void APIENTRY swShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths)
+    {
+        string source;
+        for (GLsizei i = 0; i < count; ++i)
+            source.append(strings[i], lengths && lengths[i] >= 0 ? (size_t)lengths[i] : strlen(strings[i]));
+        state().shaders[shader].source = source;
+    }
+
+    void APIENTRY swCompileShader(GLuint) {}
+    void APIENTRY swDeleteShader(GLuint shader) { state().shaders.erase(shader); }
+
+    GLuint APIENTRY swCreateProgram()
+    {
+        GLuint name = state().nextName++;
+        state().programs[name] = Program();
+        return name;
+    }
+
+    void APIENTRY swDeleteProgram(GLuint program) { state().programs.erase(program); }
+    void APIENTRY swAttachShader(GLuint program, GLuint shader) { state().programs[program].stages.push_back(shader); }
+    void APIENTRY swDetachShader(GLuint, GLuint) {}
+
+    // Picks the C++ shader matching the GLSL fragment stage
+    void APIENTRY swLinkProgram(GLuint program)
+    {
+        Program& p = state().programs[program];
+        for (GLuint stage : p.stages)
+        {
+            auto shader = state().shaders.find(stage);
+            if (shader == state().shaders.end() || shader->second.type != GL_FRAGMENT_SHADER)
+                continue;
+            const string& source = shader->second.source;
+            if (source.find("samplerCube") != string::npos)
+                p.shader = SoftwareShader::Skybox;
+            else if (source.find("CalcPointLight") != string::npos)
+                p.shader = SoftwareShader::Phong;
+            else
+                p.shader = SoftwareShader::Flat;
+        }
+    }
+
+    void APIENTRY swGetShaderiv(GLuint, GLenum, GLint* params) { *params = GL_TRUE; }
+    void APIENTRY swGetProgramiv(GLuint, GLenum, GLint* params) { *params = GL_TRUE; }
+
+    void APIENTRY swGetInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+    {
+        if (length)
+            *length = 0;
+        if (bufSize > 0)
+            infoLog[0] = '\0';
+    }
+
+    void APIENTRY swUseProgram(GLuint program) { state().program = program; }
+
+    GLint APIENTRY swGetUniformLocation(GLuint program, const GLchar* name)
+    {
+        Program& p = state().programs[program];
+        auto found = p.locations.find(name);
+        if (found != p.locations.end())
+            return found->second;
+        GLint location = (GLint)p.values.size();
+        p.locations[name] = location;
+        p.values.push_back(array<float, 16>());
+        return location;
+    }
+
+    void APIENTRY swUniform1i(GLint location, GLint v0) { float value = (float)v0; setUniform(location, &value, 1); }
+    void APIENTRY swUniform1f(GLint location, GLfloat v0) { setUniform(location, &v0, 1); }
+    void APIENTRY swUniform2f(GLint location, GLfloat v0, GLfloat v1) { float values[] = { v0, v1 }; setUniform(location, values, 2); }
+    void APIENTRY swUniform2fv(GLint location, GLsizei, const GLfloat* value) { setUniform(location, value, 2); }
+    void APIENTRY swUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2) { float values[] = { v0, v1, v2 }; setUniform(location, values, 3); }
+    void APIENTRY swUniform3fv(GLint location, GLsizei, const GLfloat* value) { setUniform(location, value, 3); }
+    void APIENTRY swUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) { float values[] = { v0, v1, v2, v3 }; setUniform(location, values, 4); }
+    void APIENTRY swUniform4fv(GLint location, GLsizei, const GLfloat* value) { setUniform(location, value, 4); }
+    void APIENTRY swUniformMatrix2fv(GLint location, GLsizei, GLboolean, const GLfloat* value) { setUniform(location, value, 4); }
+    void APIENTRY swUniformMatrix3fv(GLint location, GLsizei, GLboolean, const GLfloat* value) { setUniform(location, value, 9); }
+    void APIENTRY swUniformMatrix4fv(GLint location, GLsizei, GLboolean, const GLfloat* value) { setUniform(location, value, 16); }
+
+    // --- drawing ---
+
+    void APIENTRY swDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        submitDraw(mode, first, count, 0, nullptr, false);
+    }
+
+    void APIENTRY swDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        submitDraw(mode, 0, count, type, indices, true);
+    }
+
+    void APIENTRY swClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+    {
+        state().clearColor = glm::vec4(red, green, blue, alpha);
+    }
+
+    void APIENTRY swClear(GLbitfield mask)
+    {
+        state().rasterizer->clear((mask & GL_COLOR_BUFFER_BIT) != 0, (mask & GL_DEPTH_BUFFER_BIT) != 0, state().clearColor);
+    }
+
+    void APIENTRY swEnable(GLenum cap)
+    {
+        if (cap == GL_DEPTH_TEST)
+            state().depthTest = true;
+    }
+
+    void APIENTRY swDisable(GLenum cap)
+    {
+        if (cap == GL_DEPTH_TEST)
+            state().depthTest = false;
+    }
+
+    void APIENTRY swDepthFunc(GLenum func) { state().depthFunc = func; }
+
+    void APIENTRY swViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        if (width > 0 && height > 0)
+            state().rasterizer->resize(x + width, y + height);
+    }
+
+    void APIENTRY swScissor(GLint, GLint, GLsizei, GLsizei) {}
+
+    void APIENTRY swGetFloatv(GLenum pname, GLfloat* data)
+    {
+        if (pname == GL_COLOR_CLEAR_VALUE)
+            memcpy(data, &state().clearColor[0], sizeof(float) * 4);
+    }
+
+    void APIENTRY swFlush() { state().rasterizer->flush(); }
+
+    // Copies from the software surface, into the pack buffer when one is bound
+    void APIENTRY swReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+    {
+        State& gl = state();
+        SoftwareRasterizer& rasterizer = *gl.rasterizer;
+        rasterizer.flush();
+        if (format != GL_RGBA || type != GL_UNSIGNED_BYTE)
+            return;
+
+        uint8_t* target = (uint8_t*)pixels;
+        if (gl.pixelPackBuffer != 0)
+        {
+            vector<uint8_t>& buffer = gl.buffers[gl.pixelPackBuffer];
+            size_t offset = (size_t)pixels;
+            if (offset + (size_t)width * height * 4 > buffer.size())
+                return;
+            target = buffer.data() + offset;
+        }
+        size_t rowBytes = ((size_t)width * 4 + gl.packAlignment - 1) / gl.packAlignment * gl.packAlignment;
+        for (int row = 0; row < height; ++row)
+        {
+            uint8_t* out = target + row * rowBytes;
+            int sourceY = y + row;
+            if (sourceY < 0 || sourceY >= rasterizer.height())
+                continue;
+            int copyWidth = min(width, rasterizer.width() - x);
+            if (x >= 0 && copyWidth > 0)
+                memcpy(out, rasterizer.colorBuffer() + ((size_t)sourceY * rasterizer.width() + x) * 4, (size_t)copyWidth * 4);
+        }
+    }
+
+    const GLubyte* APIENTRY swGetString(GLenum name)
+    {
+        if (name == GL_RENDERER)
+            return (const GLubyte*)state().rendererName.c_str();
+        if (name == GL_VERSION)
+            return (const GLubyte*)"3.3 (software)";
+        if (name == GL_SHADING_LANGUAGE_VERSION)
+            return (const GLubyte*)"3.30";
+        return (const GLubyte*)"OpenGLSample";
+    }
+
+    // --- framebuffers: every framebuffer is the one software surface ---
+
+    void APIENTRY swGenFramebuffers(GLsizei n, GLuint* framebuffers) { genNames(n, framebuffers); }
+    void APIENTRY swGenRenderbuffers(GLsizei n, GLuint* renderbuffers) { genNames(n, renderbuffers); }
+    void APIENTRY swDeleteNames(GLsizei, const GLuint*) {}
+    void APIENTRY swBindName(GLenum, GLuint) {}
+    void APIENTRY swRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei) {}
+    void APIENTRY swRenderbufferStorageMultisample(GLenum, GLsizei, GLenum, GLsizei, GLsizei) {}
+    void APIENTRY swFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint) {}
+    void APIENTRY swFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint) {}
+    GLenum APIENTRY swCheckFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+    void APIENTRY swBlitFramebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum) {}
+    void APIENTRY swReadBuffer(GLenum) {}
+
+    // --- synchronization and queries: the work is done when the call returns ---
+
+    GLsync APIENTRY swFenceSync(GLenum, GLbitfield)
+    {
+        state().rasterizer->flush();
+        static int fence;
+        return (GLsync)&fence;
+    }
+
+    GLenum APIENTRY swClientWaitSync(GLsync, GLbitfield, GLuint64) { return GL_ALREADY_SIGNALED; }
+    void APIENTRY swDeleteSync(GLsync) {}
+    void APIENTRY swGenQueries(GLsizei n, GLuint* ids) { genNames(n, ids); }
+    void APIENTRY swBeginQuery(GLenum, GLuint) {}
+    void APIENTRY swEndQuery(GLenum) {}
+    void APIENTRY swQueryCounter(GLuint, GLenum) {}
+
+    void APIENTRY swGetQueryObjectiv(GLuint, GLenum, GLint* params) { *params = GL_TRUE; }
+    void APIENTRY swGetQueryObjectui64v(GLuint, GLenum, GLuint64* params) { *params = 0; }
+    void APIENTRY swGetInteger64v(GLenum, GLint64* data) { *data = 0; }
+}
+
+void SoftwareGL::install(unsigned threadCount)
+{
+    State& gl = state();
+    gl.rasterizer.reset(new SoftwareRasterizer(threadCount));
+    gl.rendererName = "software rasterizer (" + to_string(gl.rasterizer->threadCount()) + " threads, SSE2)";
+
+    glad_glGenBuffers = swGenBuffers;
+    glad_glGenVertexArrays = swGenVertexArrays;
+    glad_glDeleteBuffers = swDeleteBuffers;
+    glad_glDeleteVertexArrays = swDeleteVertexArrays;
+    glad_glBindBuffer = swBindBuffer;
+    glad_glBindVertexArray = swBindVertexArray;
+    glad_glBufferData = swBufferData;
+    glad_glMapBufferRange = swMapBufferRange;
+    glad_glUnmapBuffer = swUnmapBuffer;
+    glad_glVertexAttribPointer = swVertexAttribPointer;
+    glad_glEnableVertexAttribArray = swEnableVertexAttribArray;
+
+    glad_glGenTextures = swGenTextures;
+    glad_glDeleteTextures = swDeleteTextures;
+    glad_glActiveTexture = swActiveTexture;
+    glad_glBindTexture = swBindTexture;
+    glad_glTexImage2D = swTexImage2D;
+    glad_glTexParameteri = swTexParameteri;
+    glad_glGenerateMipmap = swGenerateMipmap;
+    glad_glPixelStorei = swPixelStorei;
+
+    glad_glCreateShader = swCreateShader;
+    glad_glShaderSource = swShaderSource;
+    glad_glCompileShader = swCompileShader;
+    glad_glDeleteShader = swDeleteShader;
+    glad_glCreateProgram = swCreateProgram;
+    glad_glDeleteProgram = swDeleteProgram;
+    glad_glAttachShader = swAttachShader;
+    glad_glDetachShader = swDetachShader;
+    glad_glLinkProgram = swLinkProgram;
+    glad_glGetShaderiv = swGetShaderiv;
+    glad_glGetProgramiv = swGetProgramiv;
+    glad_glGetShaderInfoLog = swGetInfoLog;
+    glad_glGetProgramInfoLog = swGetInfoLog;
+    glad_glUseProgram = swUseProgram;
+    glad_glGetUniformLocation = swGetUniformLocation;
+    glad_glUniform1i = swUniform1i;
+    glad_glUniform1f = swUniform1f;
+    glad_glUniform2f = swUniform2f;
+    glad_glUniform2fv = swUniform2fv;
+    glad_glUniform3f = swUniform3f;
+    glad_glUniform3fv = swUniform3fv;
+    glad_glUniform4f = swUniform4f;
+    glad_glUniform4fv = swUniform4fv;
+    glad_glUniformMatrix2fv = swUniformMatrix2fv;
+    glad_glUniformMatrix3fv = swUniformMatrix3fv;
+    glad_glUniformMatrix4fv = swUniformMatrix4fv;
+
+    glad_glDrawArrays = swDrawArrays;
+    glad_glDrawElements = swDrawElements;
+    glad_glClearColor = swClearColor;
+    glad_glClear = swClear;
+    glad_glEnable = swEnable;
+    glad_glDisable = swDisable;
+    glad_glDepthFunc = swDepthFunc;
+    glad_glViewport = swViewport;
+    glad_glScissor = swScissor;
+    glad_glGetFloatv = swGetFloatv;
+    glad_glFlush = swFlush;
+    glad_glFinish = swFlush;
+    glad_glReadPixels = swReadPixels;
+    glad_glGetString = swGetString;
+
+    glad_glGenFramebuffers = swGenFramebuffers;
+    glad_glGenRenderbuffers = swGenRenderbuffers;
+    glad_glDeleteFramebuffers = swDeleteNames;
+    glad_glDeleteRenderbuffers = swDeleteNames;
+    glad_glBindFramebuffer = swBindName;
+    glad_glBindRenderbuffer = swBindName;
+    glad_glRenderbufferStorage = swRenderbufferStorage;
+    glad_glRenderbufferStorageMultisample = swRenderbufferStorageMultisample;
+    glad_glFramebufferRenderbuffer = swFramebufferRenderbuffer;
+    glad_glFramebufferTexture2D = swFramebufferTexture2D;
+    glad_glCheckFramebufferStatus = swCheckFramebufferStatus;
+    glad_glBlitFramebuffer = swBlitFramebuffer;
+    glad_glReadBuffer = swReadBuffer;
+
+    glad_glFenceSync = swFenceSync;
+    glad_glClientWaitSync = swClientWaitSync;
+    glad_glDeleteSync = swDeleteSync;
+    glad_glGenQueries = swGenQueries;
+    glad_glDeleteQueries = swDeleteNames;
+    glad_glBeginQuery = swBeginQuery;
+    glad_glEndQuery = swEndQuery;
+    glad_glQueryCounter = swQueryCounter;
+    glad_glGetQueryObjectiv = swGetQueryObjectiv;
+    glad_glGetQueryObjectui64v = swGetQueryObjectui64v;
+    glad_glGetInteger64v = swGetInteger64v;
+}
+
+bool SoftwareGL::installed()
+{
+    return state().rasterizer != nullptr;
+}
+
+SoftwareRasterizer& SoftwareGL::rasterizer()
+{
+    return *state().rasterizer;
+}
+
+void SoftwareGL::setDrawListener(function<void(const SoftwareDraw&)> listener)
+{
+    state().drawListener = listener;
+}
+
+glm::vec4 SoftwareGL::clearColor()
+{
+    return state().clearColor;
+}
@@ -0,0 +1,31 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: SoftwareGL.h                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Software implementation of the OpenGL calls this program makes. It is      //
+// installed in place of the driver's entry points, so the meshes, textures, shaders and  //
+// scene objects run unchanged and their draws go to the SoftwareRasterizer.               //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include "SoftwareRasterizer.h"
+#include <functional>
+
+// Fills glad's function pointers with a CPU backend, for machines without a GPU.
+// Only the entry points used by the scene, the offscreen target, frame capture and the
+// pacing fences are provided; timer queries report zero, framebuffers all alias the one
+// software surface, which takes the size of the last glViewport
+class SoftwareGL
+{
+public:
+    // Call instead of gladLoadGLLoader; no window system or context is needed
+    static void install(unsigned threadCount = 0);
+    static bool installed();
+
+    static SoftwareRasterizer& rasterizer();
+
+    // Sees every draw before it is rasterized, for renderers that need the whole scene
+    static void setDrawListener(std::function<void(const SoftwareDraw&)> listener);
+    static glm::vec4 clearColor();
+};
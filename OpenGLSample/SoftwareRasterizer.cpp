@@ -0,0 +1,635 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: SoftwareRasterizer.cpp                                                             //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: CPU renderer for machines without a GPU. Triangles are transformed and     //
+// clipped as they are drawn, binned into screen tiles, and the tiles are rasterized in    //
+// parallel with SSE edge and depth tests. The scene shaders are implemented in C++.       //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Texel index for a coordinate outside the image, per GL wrap mode
+    int wrapIndex(int index, int size, GLint mode)
+    {
+        if (mode == GL_REPEAT)
+            return ((index % size) + size) % size;
+        if (mode == GL_MIRRORED_REPEAT)
+        {
+            int period = ((index % (2 * size)) + 2 * size) % (2 * size);
+            return period < size ? period : 2 * size - 1 - period;
+        }
+        return index < 0 ? 0 : (index >= size ? size - 1 : index);
+    }
+
+    // One RGBA8 texel widened to four floats
+    __m128 fetch(const SoftwareTexture::Image& image, int x, int y)
+    {
+        int packed;
+        memcpy(&packed, &image.texels[((size_t)y * image.width + x) * 4], 4);
+        __m128i bytes = _mm_cvtsi32_si128(packed);
+        __m128i words = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128()));
+    }
+
+    glm::vec4 sampleImage(const SoftwareTexture::Image& image, float s, float t, GLint wrapS, GLint wrapT)
+    {
+        if (image.texels.empty())
+            return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        // texel centers are at half coordinates, GL_LINEAR blends the four around the sample
+        float u = s * image.width - 0.5f;
+        float v = t * image.height - 0.5f;
+        float baseU = floor(u);
+        float baseV = floor(v);
+        float fracU = u - baseU;
+        float fracV = v - baseV;
+        int x0 = (int)baseU, x1 = x0 + 1;
+        int y0 = (int)baseV, y1 = y0 + 1;
+        // most samples fall inside the image and need no wrapping
+        if (x0 < 0 || x1 >= image.width)
+        {
+            x0 = wrapIndex(x0, image.width, wrapS);
+            x1 = wrapIndex(x1, image.width, wrapS);
+        }
+        if (y0 < 0 || y1 >= image.height)
+        {
+            y0 = wrapIndex(y0, image.height, wrapT);
+            y1 = wrapIndex(y1, image.height, wrapT);
+        }
+
+        __m128 weightU = _mm_set1_ps(fracU);
+        __m128 bottom = fetch(image, x0, y0);
+        bottom = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(fetch(image, x1, y0), bottom), weightU));
+        __m128 top = fetch(image, x0, y1);
+        top = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(fetch(image, x1, y1), top), weightU));
+        __m128 blended = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), _mm_set1_ps(fracV)));
+
+        glm::vec4 result;
+        _mm_storeu_ps(&result[0], _mm_mul_ps(blended, _mm_set1_ps(1.0f / 255.0f)));
+        return result;
+    }
+
+    // An unbound or incomplete texture samples as opaque black in GL
+    glm::vec4 sampleOrBlack(const shared_ptr<const SoftwareTexture>& texture, const glm::vec2& uv)
+    {
+        return texture ? texture->sample(uv) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    float specularTerm(const glm::vec3& lightDir, const glm::vec3& normal, const glm::vec3& viewDir, float shininess)
+    {
+        glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+        return pow(max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    }
+
+    uint8_t toByte(float value)
+    {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return (uint8_t)(value * 255.0f + 0.5f);
+    }
+
+    // Sutherland-Hodgman needs at most one extra vertex per clip plane
+    const int MAX_CLIPPED = 4;
+}
+
+glm::vec4 SoftwareTexture::sample(const glm::vec2& uv) const
+{
+    return sampleImage(images[0], uv.x, uv.y, wrapS, wrapT);
+}
+
+// Face selection and face coordinates from the cube map table in the GL specification
+glm::vec4 SoftwareTexture::sampleCube(const glm::vec3& r) const
+{
+    float ax = fabs(r.x), ay = fabs(r.y), az = fabs(r.z);
+    int face;
+    float sc, tc, ma;
+    if (ax >= ay && ax >= az)
+    {
+        face = r.x >= 0.0f ? 0 : 1;
+        sc = r.x >= 0.0f ? -r.z : r.z;
+        tc = -r.y;
+        ma = ax;
+    }
+    else if (ay >= az)
+    {
+        face = r.y >= 0.0f ? 2 : 3;
+        sc = r.x;
+        tc = r.y >= 0.0f ? r.z : -r.z;
+        ma = ay;
+    }
+    else
+    {
+        face = r.z >= 0.0f ? 4 : 5;
+        sc = r.z >= 0.0f ? r.x : -r.x;
+        tc = -r.y;
+        ma = az;
+    }
+    if (ma == 0.0f)
+        return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float s = 0.5f * (sc / ma + 1.0f);
+    float t = 0.5f * (tc / ma + 1.0f);
+    return sampleImage(images[face], s, t, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+}
+
+size_t SoftwareDraw::vertexIndex(int i) const
+{
+    size_t element = (size_t)first + i;
+    if (!indices)
+        return element;
+    if (indexType == GL_UNSIGNED_SHORT)
+        return ((const uint16_t*)indices)[element];
+    if (indexType == GL_UNSIGNED_INT)
+        return ((const uint32_t*)indices)[element];
+    return ((const uint8_t*)indices)[element];
+}
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned threadCount)
+    : pool(threadCount > 1 ? threadCount - 1 : threadCount, "Rasterizer")
+{
+}
+
+void SoftwareRasterizer::resize(int width, int height)
+{
+    if (width == surfaceWidth && height == surfaceHeight)
+        return;
+    flush();
+    surfaceWidth = width;
+    surfaceHeight = height;
+    color.assign((size_t)width * height * 4, 0);
+    // depth rows are padded to whole SSE groups so the last group of a row can be loaded
+    depthStride = (width + 3) & ~3;
+    depth.assign((size_t)depthStride * height, 1.0f);
+
+    tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    tiles.assign((size_t)tilesX * tilesY, Tile());
+    for (int ty = 0; ty < tilesY; ++ty)
+    {
+        for (int tx = 0; tx < tilesX; ++tx)
+        {
+            Tile& tile = tiles[(size_t)ty * tilesX + tx];
+            tile.x0 = tx * TILE_SIZE;
+            tile.y0 = ty * TILE_SIZE;
+            tile.x1 = min(tile.x0 + TILE_SIZE, width);
+            tile.y1 = min(tile.y0 + TILE_SIZE, height);
+        }
+    }
+}
+
+void SoftwareRasterizer::clear(bool colorBit, bool depthBit, const glm::vec4& clearColor, float clearDepth)
+{
+    // a clear after draws has to wait for them, a clear after a clear replaces it
+    if (!triangles.empty())
+        flush();
+    if (colorBit)
+    {
+        clearColorPending = true;
+        for (int i = 0; i < 4; ++i)
+            clearRgba[i] = toByte(clearColor[i]);
+    }
+    if (depthBit)
+    {
+        clearDepthPending = true;
+        clearDepthValue = clearDepth;
+    }
+}
+
+void SoftwareRasterizer::draw(const SoftwareDraw& draw)
+{
+    if (surfaceWidth == 0 || draw.count < 3 || !draw.position.data)
+        return;
+    PROFILE_ZONE("software draw");
+    double start = nowMs();
+
+    int state = (int)states.size();
+    states.push_back(draw);
+
+    // vertex shader: indexed draws transform the whole buffer once, array draws just their range
+    glm::mat4 viewProjection = draw.projection * draw.view;
+    glm::mat4 modelViewProjection = viewProjection * draw.model;
+    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(draw.model)));
+    size_t begin = draw.indices ? 0 : (size_t)draw.first;
+    size_t end = draw.indices ? draw.vertexCount : min(draw.vertexCount, (size_t)draw.first + draw.count);
+    transformed.resize(end);
+    for (size_t i = begin; i < end; ++i)
+    {
+        const float* p = (const float*)(draw.position.data + i * draw.position.stride);
+        glm::vec4 position(p[0], p[1], p[2], 1.0f);
+        Vertex& vertex = transformed[i];
+        if (draw.shader == SoftwareShader::Skybox)
+        {
+            // gl_Position = pos.xyww keeps the sky on the far plane, the cube position is the lookup direction
+            vertex.clip = viewProjection * position;
+            vertex.clip.z = vertex.clip.w;
+            vertex.attributes[0] = p[0];
+            vertex.attributes[1] = p[1];
+            vertex.attributes[2] = p[2];
+            continue;
+        }
+
+        vertex.clip = modelViewProjection * position;
+        if (draw.shader != SoftwareShader::Phong)
+            continue;
+        glm::vec3 world = glm::vec3(draw.model * position);
+        glm::vec3 normal(0.0f);
+        if (draw.normal.data)
+        {
+            const float* n = (const float*)(draw.normal.data + i * draw.normal.stride);
+            normal = normalMatrix * glm::vec3(n[0], n[1], n[2]);
+        }
+        glm::vec2 uv(0.0f);
+        if (draw.texCoords.data)
+        {
+            const float* t = (const float*)(draw.texCoords.data + i * draw.texCoords.stride);
+            uv = glm::vec2(t[0], t[1]);
+        }
+        float* out = vertex.attributes;
+        out[0] = world.x; out[1] = world.y; out[2] = world.z;
+        out[3] = normal.x; out[4] = normal.y; out[5] = normal.z;
+        out[6] = uv.x; out[7] = uv.y;
+    }
+
+    // primitive assembly
+    for (int i = 0; i + 2 < draw.count; i += 3)
+    {
+        size_t index[3] = { draw.vertexIndex(i), draw.vertexIndex(i + 1), draw.vertexIndex(i + 2) };
+        if (index[0] >= end || index[1] >= end || index[2] >= end)
+            continue;
+        clipAndSetup(transformed[index[0]], transformed[index[1]], transformed[index[2]], state);
+    }
+
+    setupMs += nowMs() - start;
+}
+
+// Drops triangles outside one frustum plane and cuts the ones crossing the near plane.
+// The other planes need no clipping: the tile bounds clip x and y, the depth test clips far
+void SoftwareRasterizer::clipAndSetup(const Vertex& a, const Vertex& b, const Vertex& c, int state)
+{
+    const Vertex* input[3] = { &a, &b, &c };
+    int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    bool crossesNear = false;
+    for (const Vertex* vertex : input)
+    {
+        const glm::vec4& p = vertex->clip;
+        outside[0] += p.x < -p.w;
+        outside[1] += p.x > p.w;
+        outside[2] += p.y < -p.w;
+        outside[3] += p.y > p.w;
+        outside[4] += p.z < -p.w;
+        outside[5] += p.z > p.w;
+        crossesNear |= p.z < -p.w;
+    }
+    for (int plane = 0; plane < 6; ++plane)
+    {
+        if (outside[plane] == 3)
+            return;
+    }
+    if (!crossesNear)
+    {
+        setupTriangle(a, b, c, state);
+        return;
+    }
+
+    // keep the part with z >= -w, interpolating every attribute along the cut edges
+    ++trianglesClipped;
+    Vertex clipped[MAX_CLIPPED];
+    int clippedCount = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        const Vertex& current = *input[i];
+        const Vertex& next = *input[(i + 1) % 3];
+        float currentDistance = current.clip.z + current.clip.w;
+        float nextDistance = next.clip.z + next.clip.w;
+        if (currentDistance >= 0.0f)
+            clipped[clippedCount++] = current;
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+        {
+            float t = currentDistance / (currentDistance - nextDistance);
+            Vertex& cut = clipped[clippedCount++];
+            cut.clip = glm::mix(current.clip, next.clip, t);
+            for (int k = 0; k < 8; ++k)
+                cut.attributes[k] = current.attributes[k] + (next.attributes[k] - current.attributes[k]) * t;
+        }
+    }
+    for (int i = 1; i + 1 < clippedCount; ++i)
+        setupTriangle(clipped[0], clipped[i], clipped[i + 1], state);
+}
+
+void SoftwareRasterizer::setupTriangle(const Vertex& a, const Vertex& b, const Vertex& c, int state)
+{
+    const Vertex* input[3] = { &a, &b, &c };
+    Triangle triangle;
+    for (int i = 0; i < 3; ++i)
+    {
+        const glm::vec4& p = input[i]->clip;
+        if (p.w <= 0.0f)
+            return;
+        float invW = 1.0f / p.w;
+        triangle.x[i] = (p.x * invW * 0.5f + 0.5f) * surfaceWidth;
+        triangle.y[i] = (p.y * invW * 0.5f + 0.5f) * surfaceHeight;
+        triangle.z[i] = p.z * invW * 0.5f + 0.5f;
+        triangle.invW[i] = invW;
+        for (int k = 0; k < 8; ++k)
+            triangle.attributes[i][k] = input[i]->attributes[k] * invW;
+    }
+
+    // no face culling, like the GL path; clockwise triangles are turned around instead
+    double area = ((double)triangle.x[1] - triangle.x[0]) * ((double)triangle.y[2] - triangle.y[0])
+        - ((double)triangle.y[1] - triangle.y[0]) * ((double)triangle.x[2] - triangle.x[0]);
+    if (area == 0.0 || !isfinite(area))
+        return;
+    if (area < 0.0)
+    {
+        swap(triangle.x[1], triangle.x[2]);
+        swap(triangle.y[1], triangle.y[2]);
+        swap(triangle.z[1], triangle.z[2]);
+        swap(triangle.invW[1], triangle.invW[2]);
+        swap(triangle.attributes[1], triangle.attributes[2]);
+        area = -area;
+    }
+
+    // pixel centers are at +0.5, a pixel is covered when its center is inside
+    float minX = min(triangle.x[0], min(triangle.x[1], triangle.x[2]));
+    float maxX = max(triangle.x[0], max(triangle.x[1], triangle.x[2]));
+    float minY = min(triangle.y[0], min(triangle.y[1], triangle.y[2]));
+    float maxY = max(triangle.y[0], max(triangle.y[1], triangle.y[2]));
+    triangle.minX = max(0, (int)ceil(minX - 0.5f));
+    triangle.maxX = min(surfaceWidth - 1, (int)floor(maxX - 0.5f));
+    triangle.minY = max(0, (int)ceil(minY - 0.5f));
+    triangle.maxY = min(surfaceHeight - 1, (int)floor(maxY - 0.5f));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    // edge i is opposite vertex i, so its value over the area is that vertex's barycentric weight.
+    // C is taken at the first pixel center of the bounds so large coordinates keep their precision
+    double originX = triangle.minX + 0.5, originY = triangle.minY + 0.5;
+    for (int i = 0; i < 3; ++i)
+    {
+        int from = (i + 1) % 3, to = (i + 2) % 3;
+        double edgeA = (double)triangle.y[from] - triangle.y[to];
+        double edgeB = (double)triangle.x[to] - triangle.x[from];
+        triangle.edgeA[i] = (float)edgeA;
+        triangle.edgeB[i] = (float)edgeB;
+        triangle.edgeC[i] = (float)(edgeA * (originX - triangle.x[from]) + edgeB * (originY - triangle.y[from]));
+        // pixels exactly on an edge shared by two triangles go to one of them only
+        triangle.topLeft[i] = edgeA > 0.0 || (edgeA == 0.0 && edgeB > 0.0);
+    }
+    triangle.invArea = (float)(1.0 / area);
+    triangle.state = state;
+
+    int index = (int)triangles.size();
+    triangles.push_back(triangle);
+    ++trianglesBinned;
+
+    int tileX0 = triangle.minX / TILE_SIZE, tileX1 = triangle.maxX / TILE_SIZE;
+    int tileY0 = triangle.minY / TILE_SIZE, tileY1 = triangle.maxY / TILE_SIZE;
+    for (int ty = tileY0; ty <= tileY1; ++ty)
+    {
+        for (int tx = tileX0; tx <= tileX1; ++tx)
+        {
+            Tile& tile = tiles[(size_t)ty * tilesX + tx];
+            // skip tiles entirely outside one edge, tested at the tile corner furthest inside it
+            bool outside = false;
+            for (int i = 0; i < 3 && !outside; ++i)
+            {
+                float cornerX = (triangle.edgeA[i] > 0.0f ? tile.x1 - 1 : tile.x0) - triangle.minX;
+                float cornerY = (triangle.edgeB[i] > 0.0f ? tile.y1 - 1 : tile.y0) - triangle.minY;
+                outside = triangle.edgeC[i] + triangle.edgeA[i] * cornerX + triangle.edgeB[i] * cornerY < 0.0f;
+            }
+            if (!outside)
+                tile.triangles.push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::flush()
+{
+    bool clearPending = clearColorPending || clearDepthPending;
+    if (triangles.empty() && !clearPending)
+        return;
+    PROFILE_ZONE("software flush");
+    double start = nowMs();
+
+    pool.parallelFor((int)tiles.size(), [this, clearPending](int index) {
+        Tile& tile = tiles[index];
+        if (clearPending || !tile.triangles.empty())
+            rasterizeTile(tile);
+    });
+
+    for (Tile& tile : tiles)
+        tile.triangles.clear();
+    triangles.clear();
+    states.clear();
+    clearColorPending = false;
+    clearDepthPending = false;
+    ++flushes;
+    rasterMs += nowMs() - start;
+}
+
+void SoftwareRasterizer::rasterizeTile(Tile& tile)
+{
+    if (clearColorPending || clearDepthPending)
+    {
+        for (int y = tile.y0; y < tile.y1; ++y)
+        {
+            if (clearColorPending)
+            {
+                uint8_t* row = &color[((size_t)y * surfaceWidth + tile.x0) * 4];
+                for (int x = tile.x0; x < tile.x1; ++x, row += 4)
+                    memcpy(row, clearRgba, 4);
+            }
+            if (clearDepthPending)
+                fill(&depth[(size_t)y * depthStride + tile.x0], &depth[(size_t)y * depthStride + tile.x1], clearDepthValue);
+        }
+    }
+
+    const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for (int index : tile.triangles)
+    {
+        const Triangle& triangle = triangles[index];
+        const SoftwareDraw& state = states[triangle.state];
+        int x0 = max(triangle.minX, tile.x0), x1 = min(triangle.maxX, tile.x1 - 1);
+        int y0 = max(triangle.minY, tile.y0), y1 = min(triangle.maxY, tile.y1 - 1);
+        if (x0 > x1 || y0 > y1)
+            continue;
+        // groups of four start on a multiple of four, which never crosses a tile edge
+        int groupStart = x0 & ~3;
+
+        __m128 edgeStep[3], edgeLane[3], topLeft[3];
+        float rowStart[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            edgeStep[i] = _mm_set1_ps(triangle.edgeA[i] * 4.0f);
+            edgeLane[i] = _mm_mul_ps(_mm_set1_ps(triangle.edgeA[i]), lane);
+            topLeft[i] = triangle.topLeft[i] ? _mm_castsi128_ps(_mm_set1_epi32(-1)) : zero;
+            rowStart[i] = triangle.edgeC[i] + triangle.edgeA[i] * (groupStart - triangle.minX)
+                + triangle.edgeB[i] * (y0 - triangle.minY);
+        }
+        // depth is linear in screen space: z = z0 + (z1 - z0) * w1 + (z2 - z0) * w2
+        __m128 depthBase = _mm_set1_ps(triangle.z[0]);
+        __m128 depthDelta1 = _mm_set1_ps((triangle.z[1] - triangle.z[0]) * triangle.invArea);
+        __m128 depthDelta2 = _mm_set1_ps((triangle.z[2] - triangle.z[0]) * triangle.invArea);
+        bool lessEqual = state.depthFunc == GL_LEQUAL;
+        bool always = !state.depthTest || state.depthFunc == GL_ALWAYS;
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            __m128 e0 = _mm_add_ps(_mm_set1_ps(rowStart[0]), edgeLane[0]);
+            __m128 e1 = _mm_add_ps(_mm_set1_ps(rowStart[1]), edgeLane[1]);
+            __m128 e2 = _mm_add_ps(_mm_set1_ps(rowStart[2]), edgeLane[2]);
+            float* depthRow = &depth[(size_t)y * depthStride];
+            uint8_t* colorRow = &color[(size_t)y * surfaceWidth * 4];
+
+            for (int x = groupStart; x <= x1; x += 4)
+            {
+                // inside when every edge is positive, or zero on a top-left edge
+                __m128 inside = _mm_and_ps(
+                    _mm_or_ps(_mm_cmpgt_ps(e0, zero), _mm_and_ps(_mm_cmpeq_ps(e0, zero), topLeft[0])),
+                    _mm_or_ps(_mm_cmpgt_ps(e1, zero), _mm_and_ps(_mm_cmpeq_ps(e1, zero), topLeft[1])));
+                inside = _mm_and_ps(inside,
+                    _mm_or_ps(_mm_cmpgt_ps(e2, zero), _mm_and_ps(_mm_cmpeq_ps(e2, zero), topLeft[2])));
+                int mask = _mm_movemask_ps(inside);
+                // lanes outside the clipped bounds
+                if (x < x0)
+                    mask &= ~((1 << (x0 - x)) - 1);
+                if (x + 3 > x1)
+                    mask &= (1 << (x1 - x + 1)) - 1;
+
+                if (mask)
+                {
+                    __m128 z = _mm_add_ps(depthBase, _mm_add_ps(_mm_mul_ps(e1, depthDelta1), _mm_mul_ps(e2, depthDelta2)));
+                    __m128 stored = _mm_loadu_ps(depthRow + x);
+                    if (!always)
+                        mask &= _mm_movemask_ps(lessEqual ? _mm_cmple_ps(z, stored) : _mm_cmplt_ps(z, stored));
+
+                    if (mask)
+                    {
+                        float lanesE1[4], lanesE2[4], lanesZ[4];
+                        _mm_storeu_ps(lanesE1, e1);
+                        _mm_storeu_ps(lanesE2, e2);
+                        _mm_storeu_ps(lanesZ, z);
+                        for (int k = 0; k < 4; ++k)
+                        {
+                            if (!(mask & (1 << k)))
+                                continue;
+                            // perspective correct weights from the screen space ones
+                            float w1 = lanesE1[k] * triangle.invArea;
+                            float w2 = lanesE2[k] * triangle.invArea;
+                            float w0 = 1.0f - w1 - w2;
+                            float p0 = w0 * triangle.invW[0], p1 = w1 * triangle.invW[1], p2 = w2 * triangle.invW[2];
+                            float scale = 1.0f / (p0 + p1 + p2);
+                            float attributes[8];
+                            for (int a = 0; a < 8; ++a)
+                            {
+                                attributes[a] = (w0 * triangle.attributes[0][a] + w1 * triangle.attributes[1][a]
+                                    + w2 * triangle.attributes[2][a]) * scale;
+                            }
+
+                            glm::vec4 fragment = shade(state, attributes);
+                            uint8_t* pixel = colorRow + (size_t)(x + k) * 4;
+                            pixel[0] = toByte(fragment.x);
+                            pixel[1] = toByte(fragment.y);
+                            pixel[2] = toByte(fragment.z);
+                            pixel[3] = toByte(fragment.w);
+                            // like GL, depth is only written while the depth test is on
+                            if (state.depthTest)
+                                depthRow[x + k] = lanesZ[k];
+                        }
+                    }
+                }
+                e0 = _mm_add_ps(e0, edgeStep[0]);
+                e1 = _mm_add_ps(e1, edgeStep[1]);
+                e2 = _mm_add_ps(e2, edgeStep[2]);
+            }
+            for (int i = 0; i < 3; ++i)
+                rowStart[i] += triangle.edgeB[i];
+        }
+    }
+}
+
+// The fragment shaders, following the GLSL line by line so the images match
+glm::vec4 SoftwareRasterizer::shade(const SoftwareDraw& state, const float* attributes) const
+{
+    if (state.shader == SoftwareShader::Flat)
+        return glm::vec4(1.0f);
+    if (state.shader == SoftwareShader::Skybox)
+    {
+        glm::vec3 direction(attributes[0], attributes[1], attributes[2]);
+        return state.cubeMap ? state.cubeMap->sampleCube(direction) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    glm::vec3 fragPos(attributes[0], attributes[1], attributes[2]);
+    glm::vec3 norm = glm::normalize(glm::vec3(attributes[3], attributes[4], attributes[5]));
+    glm::vec2 uv = glm::vec2(attributes[6], attributes[7]) * state.uvScale;
+    glm::vec3 viewDir = glm::normalize(state.viewPos - fragPos);
+
+    // every light samples the same two maps, so sample them once
+    glm::vec3 diffuseMap = glm::vec3(sampleOrBlack(state.diffuse, uv));
+    glm::vec3 specularMap = glm::vec3(sampleOrBlack(state.specular, uv));
+    glm::vec4 overlay = sampleOrBlack(state.overlay, uv);
+    float shininess = state.shininess;
+
+    // phase 1: directional lighting
+    const SoftwareDraw::DirLight& dirLight = state.dirLight;
+    glm::vec3 lightDir = glm::normalize(-dirLight.direction);
+    float diff = max(glm::dot(norm, lightDir), 0.0f);
+    float spec = specularTerm(lightDir, norm, viewDir, shininess);
+    glm::vec3 result = dirLight.ambient * diffuseMap + dirLight.diffuse * diff * diffuseMap + dirLight.specular * spec * specularMap;
+
+    // phase 2: point lights
+    for (const SoftwareDraw::PointLight& light : state.pointLights)
+    {
+        glm::vec3 toLight = light.position - fragPos;
+        lightDir = glm::normalize(toLight);
+        diff = max(glm::dot(norm, lightDir), 0.0f);
+        spec = specularTerm(lightDir, norm, viewDir, shininess);
+        float distance = glm::length(toLight);
+        float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+        result += light.intensity * attenuation
+            * (light.ambient * diffuseMap + light.diffuse * diff * diffuseMap + light.specular * spec * specularMap);
+    }
+
+    // phase 3: spot light
+    const SoftwareDraw::SpotLight& spot = state.spotLight;
+    glm::vec3 toSpot = spot.position - fragPos;
+    lightDir = glm::normalize(toSpot);
+    diff = max(glm::dot(norm, lightDir), 0.0f);
+    spec = specularTerm(lightDir, norm, viewDir, shininess);
+    float distance = glm::length(toSpot);
+    float attenuation = 1.0f / (spot.constant + spot.linear * distance + spot.quadratic * (distance * distance));
+    float theta = glm::dot(lightDir, glm::normalize(-spot.direction));
+    float epsilon = spot.cutOff - spot.outerCutOff;
+    float intensity = glm::clamp((theta - spot.outerCutOff) / epsilon, 0.0f, 1.0f);
+    result += attenuation * intensity
+        * (spot.ambient * diffuseMap + spot.diffuse * diff * diffuseMap + spot.specular * spec * specularMap);
+
+    // overlap textures with alpha blending, unless the overlay unit is unbound
+    if (overlay != glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))
+        return overlay * overlay.w + glm::vec4(result, 1.0f) * (1.0f - overlay.w);
+    return glm::vec4(result, 1.0f);
+}
+
+void SoftwareRasterizer::printStats() const
+{
+    if (flushes == 0)
+        return;
+    cout << "Software rasterizer: " << threadCount() << " threads, " << TILE_SIZE << "px tiles, "
+        << trianglesBinned / flushes << " triangles per flush (" << trianglesClipped << " near clipped in total), "
+        << setupMs / flushes << "ms transform and binning, " << rasterMs / flushes << "ms rasterizing per flush" << endl;
+}
@@ -0,0 +1,188 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: SoftwareRasterizer.h                                                               //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: CPU renderer for machines without a GPU. Triangles are transformed and     //
+// clipped as they are drawn, binned into screen tiles, and the tiles are rasterized in    //
+// parallel with SSE edge and depth tests. The scene shaders are implemented in C++.       //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "ThreadPool.h"
+
+// Texture object as the software backend keeps it. Images are RGBA8 with the first uploaded
+// row at t = 0, like GL; 2D textures use images[0], cube maps one image per face
+struct SoftwareTexture
+{
+    struct Image
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> texels;
+    };
+
+    GLenum target = 0;
+    GLint wrapS = GL_REPEAT;
+    GLint wrapT = GL_REPEAT;
+    Image images[6];
+
+    // Bilinear lookup, what GL_LINEAR without mipmaps returns
+    glm::vec4 sample(const glm::vec2& uv) const;
+    glm::vec4 sampleCube(const glm::vec3& direction) const;
+};
+
+// The fragment shaders the scene uses, picked by SoftwareGL when a program is linked
+enum class SoftwareShader
+{
+    Phong,   // 6.multiple_lights.fs
+    Flat,    // 6.light_cube.fs
+    Skybox,  // skybox.fs
+};
+
+// Everything one draw call needs: geometry, uniforms and bound textures
+struct SoftwareDraw
+{
+    SoftwareShader shader = SoftwareShader::Flat;
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    bool depthTest = true;
+    GLenum depthFunc = GL_LESS;
+
+    // float attributes from glVertexAttribPointer, data is null when the attribute is disabled
+    struct Attribute
+    {
+        const uint8_t* data = nullptr;
+        int stride = 0;
+    };
+    Attribute position;   // location 0
+    Attribute normal;     // location 1
+    Attribute texCoords;  // location 2
+    size_t vertexCount = 0;  // vertices the buffers hold
+    // index buffer for glDrawElements, null for glDrawArrays
+    const void* indices = nullptr;
+    GLenum indexType = GL_UNSIGNED_SHORT;
+    int first = 0;
+    int count = 0;
+    // Vertex the i-th element of the draw refers to
+    size_t vertexIndex(int i) const;
+
+    // lights.glsl, as set by main
+    struct DirLight
+    {
+        glm::vec3 direction, ambient, diffuse, specular;
+    };
+    struct PointLight
+    {
+        glm::vec3 position;
+        float constant, linear, quadratic, intensity;
+        glm::vec3 ambient, diffuse, specular;
+    };
+    struct SpotLight
+    {
+        glm::vec3 position, direction;
+        float cutOff, outerCutOff;
+        float constant, linear, quadratic;
+        glm::vec3 ambient, diffuse, specular;
+    };
+    glm::vec3 viewPos = glm::vec3(0.0f);
+    DirLight dirLight = {};
+    PointLight pointLights[2] = {};
+    SpotLight spotLight = {};
+    float shininess = 32.0f;
+    glm::vec2 uvScale = glm::vec2(1.0f);
+
+    // null samples as an unbound texture, (0, 0, 0, 1)
+    std::shared_ptr<const SoftwareTexture> diffuse;
+    std::shared_ptr<const SoftwareTexture> specular;
+    std::shared_ptr<const SoftwareTexture> overlay;
+    std::shared_ptr<const SoftwareTexture> cubeMap;
+};
+
+// Tile binned, multithreaded rasterizer with a float depth buffer
+class SoftwareRasterizer
+{
+public:
+    // threadCount includes the thread that calls flush, so at least two; 0 uses every core
+    explicit SoftwareRasterizer(unsigned threadCount = 0);
+
+    // The framebuffer, RGBA8 with the bottom row first like glReadPixels returns it
+    void resize(int width, int height);
+    int width() const { return surfaceWidth; }
+    int height() const { return surfaceHeight; }
+    const uint8_t* colorBuffer() const { return color.data(); }
+    // Workers plus the thread that calls flush, which rasterizes tiles too
+    unsigned threadCount() const { return pool.size() + 1; }
+
+    // The clear is applied per tile on the next flush, before that tile's triangles
+    void clear(bool colorBit, bool depthBit, const glm::vec4& clearColor, float clearDepth = 1.0f);
+    // Transforms, clips and bins the triangles of one draw call
+    void draw(const SoftwareDraw& draw);
+    // Rasterizes everything binned so far
+    void flush();
+
+    void printStats() const;
+
+private:
+    static const int TILE_SIZE = 64;
+
+    // Post transform vertex with the attributes the shaders need
+    struct Vertex
+    {
+        glm::vec4 clip;
+        float attributes[8];  // world position, normal, uv; the skybox only uses the first three
+    };
+    // Screen space triangle ready for edge function rasterization
+    struct Triangle
+    {
+        float x[3], y[3], z[3];
+        float invW[3];
+        float attributes[3][8];  // premultiplied by invW for perspective correct interpolation
+        float edgeA[3], edgeB[3], edgeC[3];
+        bool topLeft[3];
+        float invArea;
+        int minX, minY, maxX, maxY;
+        int state;
+    };
+    struct Tile
+    {
+        int x0, y0, x1, y1;
+        std::vector<int> triangles;
+    };
+
+    void setupTriangle(const Vertex& a, const Vertex& b, const Vertex& c, int state);
+    void clipAndSetup(const Vertex& a, const Vertex& b, const Vertex& c, int state);
+    void rasterizeTile(Tile& tile);
+    glm::vec4 shade(const SoftwareDraw& state, const float* attributes) const;
+
+    ThreadPool pool;
+    int surfaceWidth = 0;
+    int surfaceHeight = 0;
+    std::vector<uint8_t> color;
+    std::vector<float> depth;
+    int depthStride = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+    std::vector<Tile> tiles;
+
+    // work since the last flush
+    std::vector<SoftwareDraw> states;
+    std::vector<Triangle> triangles;
+    std::vector<Vertex> transformed;  // scratch for one draw
+    bool clearColorPending = false;
+    bool clearDepthPending = false;
+    uint8_t clearRgba[4] = { 0, 0, 0, 0 };
+    float clearDepthValue = 1.0f;
+
+    // totals for printStats
+    unsigned long long flushes = 0;
+    unsigned long long trianglesBinned = 0;
+    unsigned long long trianglesClipped = 0;
+    double setupMs = 0.0;
+    double rasterMs = 0.0;
+};
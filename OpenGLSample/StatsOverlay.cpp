@@ -0,0 +1,32 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: StatsOverlay.cpp                                                                   //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Shows live statistics in the window title bar, which needs no font        //
+// rendering and stays readable at any render scale.                                       //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "StatsOverlay.h"
+#include <GLFW/glfw3.h>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Changing the title is a window system call, so don't do it every frame
+    const double UPDATE_SECONDS = 0.5;
+}
+
+void StatsOverlay::update(GLFWwindow* window, const string& baseTitle)
+{
+    if (!enabled)
+        return;
+    double now = glfwGetTime();
+    if (now - lastUpdate < UPDATE_SECONDS)
+        return;
+    lastUpdate = now;
+
+    string title = baseTitle;
+    for (auto& value : values)
+        title += " | " + value.first + " " + value.second;
+    glfwSetWindowTitle(window, title.c_str());
+}
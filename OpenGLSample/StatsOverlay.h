@@ -0,0 +1,28 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: StatsOverlay.h                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Shows live statistics in the window title bar, which needs no font        //
+// rendering and stays readable at any render scale.                                       //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <map>
+#include <string>
+
+struct GLFWwindow;
+
+// Collects named values and writes them into the window title a few times per second
+class StatsOverlay
+{
+public:
+    bool enabled = false;
+
+    void setValue(const std::string& name, const std::string& value) { values[name] = value; }
+    // Rewrites the title if enough time has passed since the last update
+    void update(GLFWwindow* window, const std::string& baseTitle);
+
+private:
+    std::map<std::string, std::string> values;
+    double lastUpdate = 0.0;
+};
@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureArrays.cpp                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Rebuilds the material textures as layers of a few 2D texture arrays, so    //
+// draws with different textures stop rebinding and only change a layer index.            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+#include "CpuProfiler.h"
+#include "RenderStats.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Set in a layer entry when the texture wraps with GL_MIRRORED_REPEAT
+    const int MIRRORED_BIT = 0x10000;
+
+    const char* LAYER_UNIFORMS[TextureArrays::UNITS] = { "textureLayers[0]", "textureLayers[1]", "textureLayers[2]" };
+
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int nearestPowerOfTwo(int size)
+    {
+        int power = (int)std::lround(std::log2((double)max(size, 1)));
+        return max(TextureArrays::MIN_LAYER_SIZE, min(TextureArrays::MAX_LAYER_SIZE, 1 << power));
+    }
+
+    // Texture with its mip chain, as GL_LINEAR_MIPMAP_* would need it
+    uint64_t mippedBytes(int width, int height, int bytesPerTexel)
+    {
+        uint64_t total = 0;
+        while (true)
+        {
+            total += (uint64_t)width * height * bytesPerTexel;
+            if (width == 1 && height == 1)
+                return total;
+            width = max(width / 2, 1);
+            height = max(height / 2, 1);
+        }
+    }
+
+    int wrapIndex(int index, int size, bool repeat)
+    {
+        if (repeat)
+            return ((index % size) + size) % size;
+        return min(max(index, 0), size - 1);
+    }
+
+    // Resamples RGBA8 source (top row first) to width x height with the bottom row first, like
+    // the flipped images Textures uploads. Each output texel averages a grid of bilinear taps
+    // covering its footprint, one tap when enlarging
+    void resample(const unsigned char* source, int sourceWidth, int sourceHeight, bool repeat,
+        int width, int height, vector<unsigned char>& out)
+    {
+        out.resize((size_t)width * height * 4);
+        float scaleX = (float)sourceWidth / width;
+        float scaleY = (float)sourceHeight / height;
+        int tapsX = max(1, (int)ceil(scaleX));
+        int tapsY = max(1, (int)ceil(scaleY));
+        float weight = 1.0f / (tapsX * tapsY);
+
+        for (int y = 0; y < height; ++y)
+        {
+            unsigned char* row = &out[(size_t)(height - 1 - y) * width * 4];
+            for (int x = 0; x < width; ++x)
+            {
+                float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (int ty = 0; ty < tapsY; ++ty)
+                {
+                    float sy = (y + (ty + 0.5f) / tapsY) * scaleY - 0.5f;
+                    int y0 = (int)floor(sy);
+                    float fy = sy - y0;
+                    const unsigned char* row0 = source + (size_t)wrapIndex(y0, sourceHeight, repeat) * sourceWidth * 4;
+                    const unsigned char* row1 = source + (size_t)wrapIndex(y0 + 1, sourceHeight, repeat) * sourceWidth * 4;
+                    for (int tx = 0; tx < tapsX; ++tx)
+                    {
+                        float sx = (x + (tx + 0.5f) / tapsX) * scaleX - 0.5f;
+                        int x0 = (int)floor(sx);
+                        float fx = sx - x0;
+                        int c0 = wrapIndex(x0, sourceWidth, repeat) * 4;
+                        int c1 = wrapIndex(x0 + 1, sourceWidth, repeat) * 4;
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            float top = row0[c0 + c] + (row0[c1 + c] - row0[c0 + c]) * fx;
+                            float bottom = row1[c0 + c] + (row1[c1 + c] - row1[c0 + c]) * fx;
+                            sum[c] += top + (bottom - top) * fy;
+                        }
+                    }
+                }
+                for (int c = 0; c < 4; ++c)
+                    row[x * 4 + c] = (unsigned char)min(255.0f, sum[c] * weight + 0.5f);
+            }
+        }
+    }
+}
+
+bool TextureArrays::build(const Textures& textures, int layerSize)
+{
+    PROFILE_ZONE("TextureArrays::build");
+    double start = nowMs();
+    destroy();
+
+    struct Image
+    {
+        const Textures::Source* source;
+        int width;
+        int height;
+    };
+    // grouped by layer size, in load order within a group; only the headers are read here so
+    // a single decoded image is held at a time
+    map<pair<int, int>, vector<Image>> groups;
+    for (const Textures::Source& source : textures.sources)
+    {
+        Image image = { &source, 0, 0 };
+        int channels;
+        if (!stbi_info(source.path, &image.width, &image.height, &channels))
+            continue;
+        separateBytes += mippedBytes(image.width, image.height, channels);
+        pair<int, int> size = layerSize > 0 ? make_pair(layerSize, layerSize)
+            : make_pair(nearestPowerOfTwo(image.width), nearestPowerOfTwo(image.height));
+        groups[size].push_back(image);
+    }
+    if (groups.empty())
+    {
+        cout << "No textures to put in arrays" << endl;
+        return false;
+    }
+
+    vector<unsigned char> layerPixels;
+    for (auto& group : groups)
+    {
+        Array array = { 0, group.first.first, group.first.second, (int)group.second.size() };
+        glGenTextures(1, &array.texture);
+        RenderStats::bindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, array.width, array.height, array.layers, 0,
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        for (int i = 0; i < array.layers; ++i)
+        {
+            const Image& image = group.second[i];
+            int width, height, channels;
+            unsigned char* pixels = stbi_load(image.source->path, &width, &height, &channels, 4);
+            bool mirrored = image.source->wrapMode == GL_MIRRORED_REPEAT;
+            if (pixels)
+            {
+                resample(pixels, width, height, !mirrored, array.width, array.height, layerPixels);
+                stbi_image_free(pixels);
+                layers[image.source->texture] = { (int)arrays.size(), i, mirrored };
+            }
+            else
+            {
+                // left out of the layer table, so it still samples like an empty unit
+                cout << "Texture failed to load at path: " << image.source->path << endl;
+                layerPixels.assign((size_t)array.width * array.height * 4, 0);
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, array.width, array.height, 1,
+                GL_RGBA, GL_UNSIGNED_BYTE, layerPixels.data());
+            RenderStats::countTextureUpload(layerPixels.size());
+        }
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        // mirrored textures fold their coordinates in the shader, so they repeat here too
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        arrayBytes += mippedBytes(array.width, array.height, 4) * array.layers;
+        arrays.push_back(array);
+    }
+    buildMs = nowMs() - start;
+    return true;
+}
+
+void TextureArrays::destroy()
+{
+    for (const Array& array : arrays)
+        glDeleteTextures(1, &array.texture);
+    arrays.clear();
+    layers.clear();
+    for (int unit = 0; unit < UNITS; ++unit)
+    {
+        boundArrays[unit] = 0;
+        boundEntries[unit] = INT32_MIN;
+    }
+    separateBytes = 0;
+    arrayBytes = 0;
+}
+
+void TextureArrays::bind(const Shader& shader, int unit, GLuint texture)
+{
+    ++bindRequests;
+    auto found = layers.find(texture);
+    int entry = -1;
+    if (found != layers.end())
+    {
+        const Layer& layer = found->second;
+        entry = layer.layer | (layer.mirrored ? MIRRORED_BIT : 0);
+        GLuint array = arrays[layer.array].texture;
+        if (boundArrays[unit] != array)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            RenderStats::bindTexture(GL_TEXTURE_2D_ARRAY, array);
+            boundArrays[unit] = array;
+            ++arrayBinds;
+        }
+    }
+    if (boundEntries[unit] != entry)
+    {
+        shader.setInt(LAYER_UNIFORMS[unit], entry);
+        boundEntries[unit] = entry;
+        ++layerChanges;
+    }
+}
+
+void TextureArrays::printStats() const
+{
+    if (arrays.empty())
+        return;
+    cout << "Texture arrays: " << layers.size() << " textures in " << arrays.size() << " arrays, built in "
+        << buildMs << "ms" << endl;
+    for (const Array& array : arrays)
+        cout << "  " << array.width << "x" << array.height << " x " << array.layers << " layers" << endl;
+    double overhead = separateBytes > 0 ? 100.0 * ((double)arrayBytes / separateBytes - 1.0) : 0.0;
+    cout << "  memory with mips: " << arrayBytes / (1024.0 * 1024.0) << " MB against "
+        << separateBytes / (1024.0 * 1024.0) << " MB as separate textures (" << (overhead >= 0.0 ? "+" : "")
+        << overhead << "%)" << endl;
+    cout << "  " << bindRequests << " material texture binds became " << arrayBinds << " array binds and "
+        << layerChanges << " layer uniform changes" << endl;
+}
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureArrays.h                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Rebuilds the material textures as layers of a few 2D texture arrays, so    //
+// draws with different textures stop rebinding and only change a layer index.            //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Textures.h"
+#include "shader.h"
+
+// Every loaded texture is resampled to RGBA8 at a power of two size, and textures of the
+// same size share an array. The lit shader is 6.multiple_lights_array.fs, which picks the
+// layer from textureLayers and emulates mirrored repeat, since wrapping is per array
+class TextureArrays
+{
+public:
+    // Units the lit shader samples: material.diffuse, material.specular and textureOverlay
+    static const int UNITS = 3;
+    // Limits of the per texture size in grouped mode
+    static const int MIN_LAYER_SIZE = 16;
+    static const int MAX_LAYER_SIZE = 2048;
+
+    // layerSize 0 groups the textures by their own size rounded to the nearest power of two,
+    // anything else resamples all of them to layerSize x layerSize into a single array
+    bool build(const Textures& textures, int layerSize);
+    void destroy();
+
+    // Stands in for glActiveTexture + glBindTexture of a material texture: binds the array
+    // holding it only if the unit has another one, then points the unit's layer at it.
+    // Textures that failed to load, and 0, sample black like an empty unit
+    void bind(const Shader& shader, int unit, GLuint texture);
+
+    // Arrays, memory against the separate textures, and binds saved so far
+    void printStats() const;
+
+private:
+    struct Layer
+    {
+        int array;
+        int layer;
+        bool mirrored;
+    };
+    struct Array
+    {
+        GLuint texture;
+        int width;
+        int height;
+        int layers;
+    };
+
+    std::vector<Array> arrays;
+    std::unordered_map<GLuint, Layer> layers;
+
+    // What each unit has now, so repeated binds cost nothing
+    GLuint boundArrays[UNITS] = { 0, 0, 0 };
+    int boundEntries[UNITS] = { INT32_MIN, INT32_MIN, INT32_MIN };
+
+    uint64_t separateBytes = 0;
+    uint64_t arrayBytes = 0;
+    double buildMs = 0.0;
+    uint64_t bindRequests = 0;
+    uint64_t arrayBinds = 0;
+    uint64_t layerChanges = 0;
+};
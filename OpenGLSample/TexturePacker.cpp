@@ -0,0 +1,208 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TexturePacker.cpp                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Offline packing of the scene's textures into block compressed .btex files  //
+// with full mip chains, encoded on all cores, reporting throughput and PSNR per texture.  //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TexturePacker.h"
+#include "CpuProfiler.h"
+#include "ImageRows.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    const char* formatName(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? "BC1" : format == BlockFormat::BC3 ? "BC3" : "BC4";
+    }
+
+    const char* usageName(Textures::Usage usage)
+    {
+        return usage == Textures::SPECULAR ? "specular" : usage == Textures::OVERLAY ? "overlay" : "color";
+    }
+
+    // One texture on its way through the packer; levels are RGBA, bottom row first
+    struct Job
+    {
+        const Textures::Source* source;
+        bool loaded = false;
+        vector<vector<unsigned char>> levels;
+        CompressedImage packed;
+        double encodeMs = 0.0;  // summed over the tasks
+        double psnr = 0.0;
+        bool written = false;
+    };
+
+    // Block rows [firstRow, endRow) of one level
+    struct Task
+    {
+        Job* job;
+        int level;
+        int firstRow;
+        int endRow;
+        double ms;
+    };
+}
+
+string TexturePacker::packedPath(const string& directory, const string& sourcePath)
+{
+    size_t nameStart = sourcePath.find_last_of("/\\");
+    string name = nameStart == string::npos ? sourcePath : sourcePath.substr(nameStart + 1);
+    return directory + "/" + name.substr(0, name.find_last_of('.')) + ".btex";
+}
+
+BlockFormat TexturePacker::chooseFormat(Textures::Usage usage, const unsigned char* rgba, int width, int height, bool& gray)
+{
+    gray = false;
+    size_t texels = (size_t)width * height;
+    if (usage == Textures::OVERLAY)
+        return BlockFormat::BC3;
+    if (usage == Textures::SPECULAR)
+    {
+        gray = true;
+        for (size_t i = 0; i < texels && gray; ++i)
+        {
+            const unsigned char* texel = rgba + i * 4;
+            int spread = max(texel[0], max(texel[1], texel[2])) - min(texel[0], min(texel[1], texel[2]));
+            gray = spread <= GRAY_TOLERANCE;
+        }
+        return gray ? BlockFormat::BC4 : BlockFormat::BC1;
+    }
+    for (size_t i = 0; i < texels; ++i)
+    {
+        if (rgba[i * 4 + 3] < 255)
+            return BlockFormat::BC3;
+    }
+    return BlockFormat::BC1;
+}
+
+bool TexturePacker::pack(const vector<Textures::Source>& sources, const string& directory, unsigned threadCount)
+{
+    PROFILE_ZONE("TexturePacker::pack");
+    ThreadPool pool(threadCount, "TexturePack");
+    double start = nowMs();
+
+    // decode and build the mip chains, a texture per task
+    vector<Job> jobs(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i)
+        jobs[i].source = &sources[i];
+    pool.parallelFor((int)jobs.size(), [&jobs](int i) {
+        Job& job = jobs[i];
+        int width, height, channels;
+        unsigned char* data = stbi_load(job.source->path, &width, &height, &channels, 4);
+        if (!data)
+            return;
+        job.levels.emplace_back((size_t)width * height * 4);
+        ImageRows::convert(data, job.levels[0].data(), width, height, 4, 4, true, false);
+        stbi_image_free(data);
+
+        job.packed.format = chooseFormat(job.source->usage, job.levels[0].data(), width, height, job.packed.gray);
+        job.packed.levels.push_back({ width, height, {} });
+        while (width > 1 || height > 1)
+        {
+            int levelWidth = max(width / 2, 1);
+            int levelHeight = max(height / 2, 1);
+            vector<unsigned char> level((size_t)levelWidth * levelHeight * 4);
+            ImageRows::downsample(job.levels.back().data(), level.data(), width, height, 4);
+            job.levels.push_back(move(level));
+            job.packed.levels.push_back({ levelWidth, levelHeight, {} });
+            width = levelWidth;
+            height = levelHeight;
+        }
+        for (CompressedImage::Level& level : job.packed.levels)
+            level.blocks.resize(BlockCompression::imageBytes(job.packed.format, level.width, level.height));
+        job.loaded = true;
+    });
+    double decoded = nowMs();
+
+    // encode in runs of block rows, so the two big textures spread over every core too
+    vector<Task> tasks;
+    for (Job& job : jobs)
+    {
+        for (int level = 0; job.loaded && level < (int)job.packed.levels.size(); ++level)
+        {
+            int blockRows = (job.packed.levels[level].height + 3) / 4;
+            for (int row = 0; row < blockRows; row += ROWS_PER_TASK)
+                tasks.push_back({ &job, level, row, min(row + ROWS_PER_TASK, blockRows), 0.0 });
+        }
+    }
+    pool.parallelFor((int)tasks.size(), [&tasks](int i) {
+        Task& task = tasks[i];
+        double taskStart = nowMs();
+        CompressedImage::Level& level = task.job->packed.levels[task.level];
+        BlockCompression::encodeRows(task.job->packed.format, task.job->levels[task.level].data(), level.width, level.height,
+            task.firstRow, task.endRow, level.blocks.data());
+        task.ms = nowMs() - taskStart;
+    });
+    for (const Task& task : tasks)
+        task.job->encodeMs += task.ms;
+    double encoded = nowMs();
+
+    // measure the top level against its source and write the files
+    pool.parallelFor((int)jobs.size(), [&jobs, &directory](int i) {
+        Job& job = jobs[i];
+        if (!job.loaded)
+            return;
+        const CompressedImage::Level& top = job.packed.levels[0];
+        vector<unsigned char> decodedTop((size_t)top.width * top.height * 4);
+        BlockCompression::decode(job.packed.format, top.blocks.data(), top.width, top.height, decodedTop.data());
+        job.psnr = BlockCompression::psnr(job.packed.format, job.levels[0].data(), decodedTop.data(), top.width, top.height);
+        job.written = BlockCompression::write(packedPath(directory, job.source->path), job.packed);
+        job.levels.clear();
+    });
+    double finished = nowMs();
+
+    cout << "Packed textures into " << directory << " on " << pool.size() + 1 << " threads" << endl;
+    cout << left << setw(20) << "file" << setw(10) << "usage" << right << setw(11) << "size" << setw(8) << "format"
+        << setw(10) << "RGBA MB" << setw(10) << "packed MB" << setw(10) << "encode ms" << setw(10) << "MPix/s" << setw(8) << "PSNR" << endl;
+    bool allWritten = true;
+    uint64_t totalRgba = 0;
+    uint64_t totalPacked = 0;
+    double totalPixels = 0.0;
+    double totalEncodeMs = 0.0;
+    for (const Job& job : jobs)
+    {
+        string name = string(job.source->path).substr(string(job.source->path).find_last_of("/\\") + 1);
+        if (!job.loaded)
+        {
+            cout << left << setw(20) << name << "could not be loaded" << right << endl;
+            continue;
+        }
+        allWritten = allWritten && job.written;
+        double pixels = 0.0;
+        for (const CompressedImage::Level& level : job.packed.levels)
+            pixels += (double)level.width * level.height;
+        uint64_t rgbaBytes = (uint64_t)(pixels * 4.0);
+        const CompressedImage::Level& top = job.packed.levels[0];
+        cout << left << setw(20) << name << setw(10) << usageName(job.source->usage) << right << setw(11)
+            << (to_string(top.width) + "x" + to_string(top.height)) << setw(8) << formatName(job.packed.format)
+            << fixed << setprecision(2) << setw(10) << rgbaBytes / (1024.0 * 1024.0) << setw(10) << job.packed.bytes() / (1024.0 * 1024.0)
+            << setprecision(1) << setw(10) << job.encodeMs << setw(10) << pixels / 1000.0 / max(job.encodeMs, 0.001)
+            << setw(8) << job.psnr << defaultfloat << setprecision(6) << endl;
+        totalRgba += rgbaBytes;
+        totalPacked += job.packed.bytes();
+        totalPixels += pixels;
+        totalEncodeMs += job.encodeMs;
+    }
+    cout << fixed << setprecision(2) << "total " << totalRgba / (1024.0 * 1024.0) << " MB as RGBA8 packed into "
+        << totalPacked / (1024.0 * 1024.0) << " MB (" << setprecision(1) << (double)totalRgba / max(totalPacked, (uint64_t)1)
+        << "x); " << totalPixels / 1000.0 / max(totalEncodeMs, 0.001) << " MPix/s per thread, "
+        << totalPixels / 1000.0 / max(encoded - decoded, 0.001) << " MPix/s overall" << endl;
+    cout << fixed << setprecision(0) << "  " << decoded - start << "ms decoding and building mips, " << encoded - decoded
+        << "ms encoding, " << finished - encoded << "ms checking and writing" << defaultfloat << setprecision(6) << endl;
+    return allWritten;
+}
@@ -0,0 +1,34 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TexturePacker.h                                                                    //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Offline packing of the scene's textures into block compressed .btex files  //
+// with full mip chains, encoded on all cores, reporting throughput and PSNR per texture.  //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <string>
+#include <vector>
+#include "BlockCompression.h"
+#include "Textures.h"
+
+// Formats follow usage: BC1 for color, BC4 for gray specular maps, BC3 where alpha matters
+class TexturePacker
+{
+public:
+    // Largest difference between the channels of a texel in an image that counts as gray
+    static const int GRAY_TOLERANCE = 8;
+    // Block rows encoded per task
+    static const int ROWS_PER_TASK = 16;
+
+    // Packs every source into directory, which must exist; threadCount 0 uses every core.
+    // Returns false when a file could not be written
+    static bool pack(const std::vector<Textures::Source>& sources, const std::string& directory, unsigned threadCount);
+
+    // directory/<file name without extension>.btex
+    static std::string packedPath(const std::string& directory, const std::string& sourcePath);
+
+    // BC3 for overlays and color images with transparent texels, BC4 for gray specular
+    // maps, BC1 for the rest
+    static BlockFormat chooseFormat(Textures::Usage usage, const unsigned char* rgba, int width, int height, bool& gray);
+};
@@ -0,0 +1,110 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureSamplers.cpp                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Sampler objects that filter the material textures through their mipmaps,   //
+// trilinear or anisotropic, in place of each texture's own filter and wrap settings.      //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TextureSamplers.h"
+#include <algorithm>
+#include <iostream>
+using namespace std; // Standard namespace
+
+// Core in GL 4.6, the same values as the EXT and ARB extensions
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+void TextureSamplers::create(const Textures& textures, float anisotropy, bool anisotropySupported)
+{
+    destroy();
+    appliedAnisotropy = 1.0f;
+    if (anisotropy > 1.0f)
+    {
+        if (anisotropySupported)
+        {
+            float maxAnisotropy = 1.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+            appliedAnisotropy = min(anisotropy, maxAnisotropy);
+        }
+        else
+            cout << "Anisotropic filtering is not supported, the textures are filtered trilinearly" << endl;
+    }
+
+    repeatSampler = createSampler(GL_REPEAT);
+    for (const Textures::Source& source : textures.sources)
+    {
+        auto found = samplerForWrap.find(source.wrapMode);
+        GLuint sampler = found != samplerForWrap.end() ? found->second : createSampler(source.wrapMode);
+        samplerForTexture[source.texture] = sampler;
+    }
+}
+
+GLuint TextureSamplers::createSampler(GLuint wrapMode)
+{
+    GLuint sampler;
+    glGenSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrapMode);
+    glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (appliedAnisotropy > 1.0f)
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, appliedAnisotropy);
+    samplerForWrap[wrapMode] = sampler;
+    return sampler;
+}
+
+void TextureSamplers::destroy()
+{
+    unbind();
+    for (auto& entry : samplerForWrap)
+        glDeleteSamplers(1, &entry.second);
+    samplerForWrap.clear();
+    samplerForTexture.clear();
+    repeatSampler = 0;
+}
+
+void TextureSamplers::bind(int unit, GLuint texture)
+{
+    if (repeatSampler == 0)
+        return;
+    ++bindRequests;
+    auto found = samplerForTexture.find(texture);
+    GLuint sampler = found != samplerForTexture.end() ? found->second : repeatSampler;
+    if (boundSamplers[unit] != sampler)
+    {
+        glBindSampler(unit, sampler);
+        boundSamplers[unit] = sampler;
+        ++samplerBinds;
+    }
+}
+
+GLuint TextureSamplers::samplerFor(GLuint texture) const
+{
+    auto found = samplerForTexture.find(texture);
+    return found != samplerForTexture.end() ? found->second : repeatSampler;
+}
+
+void TextureSamplers::unbind()
+{
+    for (int unit = 0; unit < UNITS; ++unit)
+    {
+        if (boundSamplers[unit] != 0)
+            glBindSampler(unit, 0);
+        boundSamplers[unit] = 0;
+    }
+}
+
+void TextureSamplers::printStats() const
+{
+    if (bindRequests == 0)
+        return;
+    cout << "Texture samplers: " << samplerForWrap.size() << " trilinear";
+    if (appliedAnisotropy > 1.0f)
+        cout << ", " << appliedAnisotropy << "x anisotropic";
+    cout << ", " << samplerBinds << " sampler binds for " << bindRequests << " texture binds" << endl;
+}
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureSamplers.h                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Sampler objects that filter the material textures through their mipmaps,   //
+// trilinear or anisotropic, in place of each texture's own filter and wrap settings.      //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <unordered_map>
+#include "Textures.h"
+
+// One sampler per wrap mode the textures use, since that is all that differs between
+// materials. Binding one to a unit overrides the bound texture's sampling parameters
+class TextureSamplers
+{
+public:
+    // anisotropy above 1 turns on anisotropic filtering, clamped to what the driver allows;
+    // anisotropySupported comes from GL_EXT/ARB_texture_filter_anisotropic
+    void create(const Textures& textures, float anisotropy, bool anisotropySupported);
+    void destroy();
+
+    // Binds the sampler for the texture's wrap mode to the unit if it has another one; textures
+    // that aren't known, like 0 or texture arrays, get the GL_REPEAT sampler
+    void bind(int unit, GLuint texture);
+    // Clears the units again, so textures drawn by anything else (the skybox has no mipmaps)
+    // are sampled with their own parameters
+    void unbind();
+    // The sampler bind() would give the texture, 0 before create
+    GLuint samplerFor(GLuint texture) const;
+
+    void printStats() const;
+
+private:
+    static const int UNITS = 3;
+
+    GLuint createSampler(GLuint wrapMode);
+
+    std::unordered_map<GLuint, GLuint> samplerForWrap;
+    std::unordered_map<GLuint, GLuint> samplerForTexture;
+    GLuint repeatSampler = 0;
+    GLuint boundSamplers[UNITS] = { 0, 0, 0 };
+
+    float appliedAnisotropy = 1.0f;
+    uint64_t bindRequests = 0;
+    uint64_t samplerBinds = 0;
+};
@@ -0,0 +1,239 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureStreamer.cpp                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Keeps the material textures inside a GPU memory budget. Only the small     //
+// mip levels are resident at first, finer levels are uploaded when draws need them on      //
+// screen, and the least recently needed levels are dropped to make room.                   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+#include "CpuProfiler.h"
+#include "ImageRows.h"
+#include "RenderStats.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+using namespace std; // Standard namespace
+
+namespace
+{
+    // Closest distance used for the screen size of an object the camera is in or near
+    const float NEAR_DISTANCE = 0.1f;
+
+    double megabytes(uint64_t bytes)
+    {
+        return bytes / (1024.0 * 1024.0);
+    }
+}
+
+void TextureStreamer::add(GLuint texture, const unsigned char* pixels, int width, int height, int channels)
+{
+    PROFILE_ZONE("TextureStreamer::add");
+    Entry entry;
+    entry.texture = texture;
+    entry.channels = channels;
+    entry.format = GL_RGBA;
+    entry.internalFormat = GL_RGBA8;
+    if (channels == 1)
+    {
+        entry.format = GL_RED;
+        entry.internalFormat = GL_R8;
+    }
+    else if (channels == 2)
+    {
+        entry.format = GL_RG;
+        entry.internalFormat = GL_RG8;
+    }
+    else if (channels == 3)
+    {
+        entry.format = GL_RGB;
+        entry.internalFormat = GL_RGB8;
+    }
+
+    // mip chain with a 2x2 box filter
+    entry.levels.push_back({ width, height, vector<unsigned char>(pixels, pixels + (size_t)width * height * channels) });
+    while (entry.levels.back().width > 1 || entry.levels.back().height > 1)
+    {
+        const Level& source = entry.levels.back();
+        Level level = { max(source.width / 2, 1), max(source.height / 2, 1), {} };
+        level.pixels.resize((size_t)level.width * level.height * channels);
+        ImageRows::downsample(source.pixels.data(), level.pixels.data(), source.width, source.height, channels);
+        entry.levels.push_back(move(level));
+    }
+    for (const Level& level : entry.levels)
+        counters.systemBytes += level.pixels.size();
+
+    int levelCount = (int)entry.levels.size();
+    entry.tailLevel = levelCount - 1;
+    while (entry.tailLevel > 0 && max(entry.levels[entry.tailLevel - 1].width, entry.levels[entry.tailLevel - 1].height) <= TAIL_SIZE)
+        --entry.tailLevel;
+    entry.baseLevel = levelCount;
+    entry.wantedLevel = levelCount;
+    entry.lastNeeded.assign(levelCount, 0);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    for (int level = levelCount - 1; level >= entry.tailLevel; --level)
+        uploadLevel(entry, level);
+
+    entryIndex[texture] = entries.size();
+    entries.push_back(move(entry));
+    counters.textures = (int)entries.size();
+    counters.budgetBytes = budgetBytes;
+}
+
+void TextureStreamer::destroy()
+{
+    entries.clear();
+    entryIndex.clear();
+}
+
+void TextureStreamer::beginFrame(const glm::vec3& cameraPosition, const glm::mat4& projection, int viewportHeight)
+{
+    ++frameNumber;
+    camera = cameraPosition;
+    // the w row of a perspective projection copies -z, an orthographic one leaves w at 1
+    perspective = projection[2][3] != 0.0f;
+    pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;
+    for (Entry& entry : entries)
+        entry.wantedLevel = (int)entry.levels.size();
+}
+
+void TextureStreamer::noteUse(GLuint texture, const glm::mat4& model)
+{
+    auto found = entryIndex.find(texture);
+    if (found == entryIndex.end())
+        return;
+    Entry& entry = entries[found->second];
+
+    // bounding sphere of the -1..1 cube under the model matrix
+    glm::vec3 center = glm::vec3(model[3]);
+    float radius = sqrt(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])) + glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))
+        + glm::dot(glm::vec3(model[2]), glm::vec3(model[2])));
+    float pixels = 2.0f * radius * pixelsPerUnit;
+    if (perspective)
+        pixels /= max(glm::length(center - camera) - radius, NEAR_DISTANCE);
+
+    int levelCount = (int)entry.levels.size();
+    float texels = (float)max(entry.levels[0].width, entry.levels[0].height);
+    int level = levelCount - 1;
+    if (pixels > 0.0f)
+        level = min(max((int)floor(log2(texels / pixels)) - LEVEL_BIAS, 0), levelCount - 1);
+    if (level < entry.wantedLevel)
+    {
+        for (int i = level; i < min(entry.wantedLevel, levelCount); ++i)
+            entry.lastNeeded[i] = frameNumber;
+        entry.wantedLevel = level;
+    }
+}
+
+void TextureStreamer::update()
+{
+    PROFILE_ZONE("TextureStreamer::update");
+    // the blurriest textures, compared to what they need, go first
+    vector<Entry*> pending;
+    for (Entry& entry : entries)
+    {
+        if (entry.wantedLevel < entry.baseLevel)
+            pending.push_back(&entry);
+    }
+    sort(pending.begin(), pending.end(), [](const Entry* a, const Entry* b) {
+        return a->baseLevel - a->wantedLevel > b->baseLevel - b->wantedLevel;
+    });
+
+    uint64_t uploaded = 0;
+    bool overBudget = false;
+    for (Entry* entry : pending)
+    {
+        while (entry->baseLevel > entry->wantedLevel)
+        {
+            int level = entry->baseLevel - 1;
+            uint64_t bytes = levelBytes(*entry, level);
+            if (uploaded > 0 && uploaded + bytes > uploadBytesPerFrame)
+                break;
+            while (budgetBytes > 0 && counters.residentBytes + bytes > budgetBytes && evictLeastRecent(frameNumber))
+                ;
+            if (budgetBytes > 0 && counters.residentBytes + bytes > budgetBytes)
+            {
+                overBudget = true;
+                break;
+            }
+            uploadLevel(*entry, level);
+            uploaded += bytes;
+        }
+    }
+    if (overBudget)
+        ++counters.overBudgetFrames;
+
+    counters.fullDetailTextures = 0;
+    for (const Entry& entry : entries)
+    {
+        if (entry.baseLevel == 0)
+            ++counters.fullDetailTextures;
+    }
+}
+
+void TextureStreamer::uploadLevel(Entry& entry, int level)
+{
+    const Level& image = entry.levels[level];
+    RenderStats::bindTexture(GL_TEXTURE_2D, entry.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    RenderStats::texImage2D(GL_TEXTURE_2D, level, entry.internalFormat, image.width, image.height,
+        entry.format, GL_UNSIGNED_BYTE, image.pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    entry.baseLevel = level;
+
+    uint64_t bytes = levelBytes(entry, level);
+    counters.residentBytes += bytes;
+    counters.peakResidentBytes = max(counters.peakResidentBytes, counters.residentBytes);
+    counters.uploadedBytes += bytes;
+    ++counters.levelUploads;
+}
+
+// Drops the finest resident level that went unneeded the longest, levels needed in this
+// frame and the tail stay
+bool TextureStreamer::evictLeastRecent(uint64_t frame)
+{
+    Entry* victim = nullptr;
+    for (Entry& entry : entries)
+    {
+        if (entry.baseLevel >= entry.tailLevel || entry.lastNeeded[entry.baseLevel] >= frame)
+            continue;
+        if (!victim || entry.lastNeeded[entry.baseLevel] < victim->lastNeeded[victim->baseLevel])
+            victim = &entry;
+    }
+    if (!victim)
+        return false;
+
+    // a 0x0 image releases the level's memory, the base level moves past it first
+    int level = victim->baseLevel;
+    RenderStats::bindTexture(GL_TEXTURE_2D, victim->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    RenderStats::texImage2D(GL_TEXTURE_2D, level, victim->internalFormat, 0, 0, victim->format, GL_UNSIGNED_BYTE, nullptr);
+    victim->baseLevel = level + 1;
+
+    uint64_t bytes = levelBytes(*victim, level);
+    counters.residentBytes -= bytes;
+    counters.evictedBytes += bytes;
+    ++counters.levelEvictions;
+    return true;
+}
+
+uint64_t TextureStreamer::levelBytes(const Entry& entry, int level)
+{
+    return entry.levels[level].pixels.size();
+}
+
+void TextureStreamer::printStats() const
+{
+    if (entries.empty())
+        return;
+    cout << "Texture streaming: " << counters.textures << " textures, " << counters.fullDetailTextures << " at full detail, "
+        << megabytes(counters.residentBytes) << " MB resident (peak " << megabytes(counters.peakResidentBytes) << " MB) of a "
+        << megabytes(counters.budgetBytes) << " MB budget" << endl;
+    cout << "  uploaded " << megabytes(counters.uploadedBytes) << " MB in " << counters.levelUploads << " levels, evicted "
+        << megabytes(counters.evictedBytes) << " MB in " << counters.levelEvictions << " levels, "
+        << counters.overBudgetFrames << " frames short of budget; " << megabytes(counters.systemBytes)
+        << " MB of mip chains in system memory" << endl;
+}
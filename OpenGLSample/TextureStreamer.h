@@ -0,0 +1,100 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureStreamer.h                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Keeps the material textures inside a GPU memory budget. Only the small     //
+// mip levels are resident at first, finer levels are uploaded when draws need them on      //
+// screen, and the least recently needed levels are dropped to make room.                   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Texture names never change, residency only moves GL_TEXTURE_BASE_LEVEL, so anything
+// holding one of them can keep binding it. The full mip chain of every texture is kept in
+// system memory, from where levels are uploaded
+class TextureStreamer
+{
+public:
+    // Levels this size and smaller are uploaded with the texture and never dropped
+    static const int TAIL_SIZE = 64;
+    // Levels finer than the screen estimate asked for, covering repeated UVs on an object
+    static const int LEVEL_BIAS = 1;
+
+    // Counters since the start; bytes are of the resident levels as uploaded
+    struct Stats
+    {
+        uint64_t budgetBytes = 0;
+        uint64_t residentBytes = 0;
+        uint64_t peakResidentBytes = 0;
+        uint64_t systemBytes = 0;
+        uint64_t uploadedBytes = 0;
+        uint64_t evictedBytes = 0;
+        uint64_t levelUploads = 0;
+        uint64_t levelEvictions = 0;
+        // frames where a needed level didn't fit because everything resident was in use
+        uint64_t overBudgetFrames = 0;
+        int textures = 0;
+        int fullDetailTextures = 0;
+    };
+
+    uint64_t budgetBytes = 0;
+    // Upload limit per frame so streaming doesn't stall it, at least one level always goes
+    uint64_t uploadBytesPerFrame = 8 * 1024 * 1024;
+
+    // Takes a copy of the image (tightly packed, as Textures uploads it), builds its mip chain
+    // and uploads the tail to the texture, which must be bound to GL_TEXTURE_2D
+    void add(GLuint texture, const unsigned char* pixels, int width, int height, int channels);
+    void destroy();
+
+    // Screen-space usage: beginFrame with the camera, then noteUse for every texture drawn
+    // with a model matrix (meshes are assumed to fit in -1..1), then update after the draws
+    void beginFrame(const glm::vec3& cameraPosition, const glm::mat4& projection, int viewportHeight);
+    void noteUse(GLuint texture, const glm::mat4& model);
+    // Uploads the levels the frame wanted, evicting the least recently needed ones to stay
+    // in budget. Leaves the GL_TEXTURE_2D binding of the active unit changed
+    void update();
+
+    const Stats& stats() const { return counters; }
+    void printStats() const;
+
+private:
+    struct Level
+    {
+        int width;
+        int height;
+        std::vector<unsigned char> pixels;
+    };
+    struct Entry
+    {
+        GLuint texture;
+        GLenum format;
+        GLenum internalFormat;
+        int channels;
+        std::vector<Level> levels;
+        int baseLevel;    // finest resident level
+        int tailLevel;    // first level that is always resident
+        int wantedLevel;  // finest level asked for this frame
+        // last frame each level was needed
+        std::vector<uint64_t> lastNeeded;
+    };
+
+    void uploadLevel(Entry& entry, int level);
+    bool evictLeastRecent(uint64_t frame);
+    static uint64_t levelBytes(const Entry& entry, int level);
+
+    std::vector<Entry> entries;
+    std::unordered_map<GLuint, size_t> entryIndex;
+
+    uint64_t frameNumber = 0;
+    glm::vec3 camera = glm::vec3(0.0f);
+    // screen pixels per world unit at distance 1 (perspective) or anywhere (orthographic)
+    float pixelsPerUnit = 1.0f;
+    bool perspective = true;
+
+    Stats counters;
+};
@@ -0,0 +1,247 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureUploader.cpp                                                                //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Loads textures off the GL thread. Worker threads decode the images and     //
+// copy them into a persistently mapped pixel buffer ring, from which the GL thread issues //
+// the uploads; ring space is reused once the fence of its upload has passed.              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TextureUploader.h"
+#include "CpuProfiler.h"
+#include "ImageRows.h"
+#include "stb_image.h"
+#include <chrono>
+#include <iostream>
+using namespace std; // Standard namespace
+
+// GL 4.4 / ARB_buffer_storage
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+namespace
+{
+    double nowMs()
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+void TextureUploader::start(unsigned threadCount, BufferStorageProc bufferStorage, bool inspectImages)
+{
+    this->inspectImages = inspectImages;
+    pool.reset(new ThreadPool(threadCount, "TextureLoad"));
+    workerCount = pool->size();
+    wallMs = nowMs();
+    if (!bufferStorage)
+        return;
+
+    // coherent, so the workers' copies are visible to the uploads without flushing
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &ring);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+    bufferStorage(GL_PIXEL_UNPACK_BUFFER, RING_BYTES, nullptr, flags);
+    mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, RING_BYTES, flags);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    persistent = mapped != nullptr;
+    if (!persistent)
+    {
+        cout << "Could not map the texture upload ring, images are uploaded from worker memory" << endl;
+        glDeleteBuffers(1, &ring);
+        ring = 0;
+    }
+}
+
+void TextureUploader::load(GLuint texture, const char* path, GLuint wrapMode)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++queued;
+    }
+    pool->submit([this, texture, path, wrapMode]() { decode(texture, path, wrapMode); });
+}
+
+// Worker side: decode, then flip (and expand) into the ring (or a buffer of its own when the image
+// doesn't fit), then queue it for the GL thread
+void TextureUploader::decode(GLuint texture, const char* path, GLuint wrapMode)
+{
+    PROFILE_ZONE("TextureUploader::decode");
+    double start = nowMs();
+    Ready item = { { texture, wrapMode, 0, 0, 0, nullptr, false, 0, false, { 0, 0, 0, 0 } }, path, 0, {}, false };
+    int width, height, channels;
+    unsigned char* data = stbi_load(path, &width, &height, &channels, 0);
+    double decoded = nowMs();
+    double waited = 0.0;
+    if (data)
+    {
+        item.image.width = width;
+        item.image.height = height;
+        item.image.channels = channels;
+        if (inspectImages)
+        {
+            item.image.pixels = data;
+            Textures::inspect(item.image);
+            item.image.pixels = nullptr;
+        }
+        int uploadChannels = expandToRGBA ? 4 : channels;
+        size_t imageBytes = (size_t)width * height * uploadChannels;
+
+        unsigned char* destination = nullptr;
+        if (mapped && imageBytes <= RING_BYTES)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            size_t offset;
+            double waitStart = nowMs();
+            while (!reserve(imageBytes, offset))
+                spaceFreed.wait(lock);
+            waited = nowMs() - waitStart;
+            item.segment = firstSegment + segments.size() - 1;
+            item.image.pixels = reinterpret_cast<const unsigned char*>((uintptr_t)offset);
+            item.image.inBuffer = true;
+            destination = mapped + offset;
+        }
+        else
+        {
+            item.pixels.resize(imageBytes);
+            destination = item.pixels.data();
+        }
+        ImageRows::convert(data, destination, width, height, channels, uploadChannels, true, false);
+        if (uploadChannels != channels)
+            Textures::expandedToRGBA(item.image);
+        stbi_image_free(data);
+    }
+    else
+        item.failed = true;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    decodeMs += decoded - start;
+    ringWaitMs += waited;
+    ready.push_back(move(item));
+    readyChanged.notify_one();
+}
+
+// Space after the newest segment, wrapping to the start when the end is too small. Call
+// with the mutex held
+bool TextureUploader::reserve(size_t size, size_t& offset)
+{
+    if (segments.empty())
+        head = 0;
+    size_t first = segments.empty() ? RING_BYTES : segments.front().offset;
+    bool wrapped = !segments.empty() && head <= first;
+    if (!wrapped && head + size <= RING_BYTES)
+        offset = head;
+    else if (!wrapped && size <= first && !segments.empty())
+        offset = 0;
+    else if (wrapped && head + size <= first)
+        offset = head;
+    else
+        return false;
+    head = offset + size;
+    segments.push_back({ offset, size, 0 });
+    return true;
+}
+
+// Frees the oldest segments whose uploads the GPU has finished. Call with the mutex held
+void TextureUploader::retireSegments()
+{
+    bool freed = false;
+    while (!segments.empty() && segments.front().fence)
+    {
+        GLenum status = glClientWaitSync(segments.front().fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(segments.front().fence);
+        segments.pop_front();
+        ++firstSegment;
+        freed = true;
+    }
+    if (freed)
+        spaceFreed.notify_all();
+}
+
+void TextureUploader::finish(const function<void(const Image&)>& upload)
+{
+    PROFILE_ZONE("TextureUploader::finish");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (queued > 0)
+    {
+        retireSegments();
+        if (ready.empty())
+        {
+            // wakes up now and then to retire segments for workers waiting on ring space
+            double waitStart = nowMs();
+            readyChanged.wait_for(lock, chrono::milliseconds(1));
+            blockedMs += nowMs() - waitStart;
+            continue;
+        }
+        Ready item = move(ready.front());
+        ready.pop_front();
+        lock.unlock();
+
+        double uploadStart = nowMs();
+        GLsync fence = 0;
+        if (item.failed)
+            cout << "Texture failed to load at path: " << item.path << endl;
+        else if (item.image.inBuffer)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+            upload(item.image);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        else
+        {
+            item.image.pixels = item.pixels.data();
+            upload(item.image);
+        }
+        uploadMs += nowMs() - uploadStart;
+
+        lock.lock();
+        if (!item.failed)
+        {
+            ++images;
+            bytes += (uint64_t)item.image.width * item.image.height * item.image.channels;
+        }
+        if (fence)
+        {
+            segments[(size_t)(item.segment - firstSegment)].fence = fence;
+            ++ringImages;
+        }
+        --queued;
+    }
+    lock.unlock();
+    wallMs = nowMs() - wallMs;
+
+    // the uploads still reading from the ring keep it alive after deletion
+    pool.reset();
+    for (const Segment& segment : segments)
+        glDeleteSync(segment.fence);
+    segments.clear();
+    if (ring)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &ring);
+        ring = 0;
+        mapped = nullptr;
+    }
+}
+
+void TextureUploader::printStats() const
+{
+    if (images == 0)
+        return;
+    cout << "Texture uploads: " << images << " images, " << bytes / (1024.0 * 1024.0) << " MB in " << wallMs << "ms on "
+        << workerCount << " workers, ";
+    if (persistent)
+        cout << ringImages << " through a " << RING_BYTES / (1024 * 1024) << " MB persistent ring" << endl;
+    else
+        cout << "from worker memory without a persistent ring" << endl;
+    cout << "  main thread: " << blockedMs << "ms blocked waiting for images, " << uploadMs << "ms issuing uploads; workers: "
+        << decodeMs << "ms decoding, " << ringWaitMs << "ms waiting for ring space" << endl;
+}
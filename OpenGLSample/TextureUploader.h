@@ -0,0 +1,95 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: TextureUploader.h                                                                  //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Loads textures off the GL thread. Worker threads decode the images and     //
+// copy them into a persistently mapped pixel buffer ring, from which the GL thread issues //
+// the uploads; ring space is reused once the fence of its upload has passed.              //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ThreadPool.h"
+#include "Textures.h"
+
+// Without glBufferStorage (GL 4.4 or ARB_buffer_storage) there is no persistent mapping,
+// and the workers hand over the decoded images in their own memory instead
+class TextureUploader
+{
+public:
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    static const size_t RING_BYTES = 64 * 1024 * 1024;
+
+    // A decoded image, already flipped bottom row first. When inBuffer, the ring is bound to
+    // GL_PIXEL_UNPACK_BUFFER and pixels is an offset into it
+    typedef Textures::Image Image;
+
+    // With inspectImages the workers also hash the images and find flat ones, see Textures::inspect
+    // Workers expand images without alpha to RGBA as they copy them, see Textures::expandToRGBA
+    bool expandToRGBA = false;
+
+    void start(unsigned threadCount, BufferStorageProc bufferStorage, bool inspectImages);
+    // Queues a file for the workers, its texture must already exist
+    void load(GLuint texture, const char* path, GLuint wrapMode);
+    // On the GL thread: calls upload for every image as it becomes ready, until all queued
+    // loads are done, then releases the ring and the workers
+    void finish(const std::function<void(const Image&)>& upload);
+
+    void printStats() const;
+
+private:
+    struct Segment
+    {
+        size_t offset;
+        size_t size;
+        GLsync fence;
+    };
+    struct Ready
+    {
+        Image image;
+        const char* path;
+        uint64_t segment;
+        std::vector<unsigned char> pixels;  // when not in the ring
+        bool failed;
+    };
+
+    void decode(GLuint texture, const char* path, GLuint wrapMode);
+    bool reserve(size_t bytes, size_t& offset);
+    void retireSegments();
+
+    std::unique_ptr<ThreadPool> pool;
+    bool inspectImages = false;
+
+    GLuint ring = 0;
+    unsigned char* mapped = nullptr;
+    // segments in the order they were reserved, the first is the oldest still in use
+    std::deque<Segment> segments;
+    uint64_t firstSegment = 0;
+    size_t head = 0;
+
+    std::mutex mutex;
+    std::condition_variable readyChanged;
+    std::condition_variable spaceFreed;
+    std::deque<Ready> ready;
+    int queued = 0;
+
+    // statistics, in milliseconds
+    unsigned workerCount = 0;
+    bool persistent = false;
+    int images = 0;
+    uint64_t bytes = 0;
+    uint64_t ringImages = 0;
+    double decodeMs = 0.0;      // summed over the workers
+    double ringWaitMs = 0.0;    // workers waiting for ring space
+    double wallMs = 0.0;
+    double blockedMs = 0.0;     // GL thread waiting for a decoded image
+    double uploadMs = 0.0;      // GL thread issuing the uploads
+};
@@ -8,58 +8,121 @@
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "Textures.h"
+#include "CpuProfiler.h"
+#include "RenderStats.h"
+#include "TextureStreamer.h"
+#include "TextureUploader.h"
+#include "TexturePacker.h"
+#include "BlockCompression.h"
+#include "ImageRows.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 using namespace std; // Standard namespace
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+// EXT_texture_compression_s3tc, which glad's core profile leaves out
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
 
-// Images are loaded with Y axis going down, but OpenGL's Y axis goes up, so let's flip it
-void Textures::flipImageVertically(unsigned char* image, int width, int height, int channels)
+
+// Hashes eight bytes at a time, and finds the mean color; a second pass over the texels
+// stops at the first one too far from it, so only flat images are read twice
+void Textures::inspect(Image& image)
 {
-    for (int j = 0; j < height / 2; ++j)
+    size_t bytes = (size_t)image.width * image.height * image.channels;
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ bytes;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8)
     {
-        int index1 = j * width * channels;
-        int index2 = (height - 1 - j) * width * channels;
+        uint64_t word;
+        memcpy(&word, image.pixels + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    for (; i < bytes; ++i)
+        hash = (hash ^ image.pixels[i]) * 0x100000001B3ull;
+    image.hash = hash;
 
-        for (int i = width * channels; i > 0; --i)
+    uint64_t sums[4] = { 0, 0, 0, 0 };
+    size_t texels = (size_t)image.width * image.height;
+    for (size_t texel = 0; texel < texels; ++texel)
+    {
+        for (int c = 0; c < image.channels; ++c)
+            sums[c] += image.pixels[texel * image.channels + c];
+    }
+    for (int c = 0; c < 4; ++c)
+        image.color[c] = c < image.channels && texels > 0 ? (unsigned char)((sums[c] + texels / 2) / texels) : 0;
+
+    image.flat = true;
+    for (size_t texel = 0; texel < texels && image.flat; ++texel)
+    {
+        for (int c = 0; c < image.channels; ++c)
         {
-            unsigned char tmp = image[index1];
-            image[index1] = image[index2];
-            image[index2] = tmp;
-            ++index1;
-            ++index2;
+            if (abs(image.pixels[texel * image.channels + c] - image.color[c]) > FLAT_TOLERANCE)
+                image.flat = false;
         }
     }
 }
 
 /*Generate and load the texture*/
-unsigned int Textures::loadTexture(char const* path, GLuint wrapMode)
+unsigned int Textures::loadTexture(char const* path, GLuint wrapMode, Usage usage)
 {
+    PROFILE_ZONE("Textures::loadTexture");
+    if (dedup)
+    {
+        auto loaded = pathTextures.find(make_pair(string(path), wrapMode));
+        if (loaded != pathTextures.end())
+        {
+            ++pathDuplicates;
+            return loaded->second;
+        }
+    }
     unsigned int textureID;
     glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
+    if (dedup)
+        pathTextures[make_pair(string(path), wrapMode)] = textureID;
+    sources.push_back({ textureID, path, wrapMode, usage });
+    if (!compressedDirectory.empty() && loadCompressed(textureID, path))
     {
-        flipImageVertically(data, width, height, nrComponents);
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
+    }
+    if (uploader)
+    {
+        uploader->load(textureID, path, wrapMode);
+        return textureID;
+    }
 
+    int width, height, nrComponents;
+    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+    if (data)
+    {
+        Image image = { textureID, wrapMode, width, height, nrComponents, data, false, 0, false, { 0, 0, 0, 0 } };
+        if (dedup)
+            inspect(image);
+        // images are loaded with Y axis going down, but OpenGL's Y axis goes up, so let's flip it
+        vector<unsigned char> expanded;
+        if (expandToRGBA && nrComponents != 4)
+        {
+            expanded.resize((size_t)width * height * 4);
+            ImageRows::convert(data, expanded.data(), width, height, nrComponents, 4, true, false);
+            expandedToRGBA(image);
+            image.pixels = expanded.data();
+        }
+        else
+            ImageRows::flipVertically(data, width, height, nrComponents);
+        uploadImage(image);
         stbi_image_free(data);
     }
     else
@@ -71,49 +134,286 @@ unsigned int Textures::loadTexture(char const* path, GLuint wrapMode)
     return textureID;
 }
 
+// Uploads the packed file of path with its whole mip chain, false when there isn't one
+bool Textures::loadCompressed(GLuint textureID, const char* path)
+{
+    string packedPath = TexturePacker::packedPath(compressedDirectory, path);
+    ifstream probe(packedPath);
+    if (!probe.is_open())
+        return false;
+    probe.close();
+    CompressedImage image;
+    if (!BlockCompression::read(packedPath, image))
+        return false;
+
+    GLenum internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (image.format == BlockFormat::BC3)
+        internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    else if (image.format == BlockFormat::BC4)
+        internalFormat = GL_COMPRESSED_RED_RGTC1;
+
+    RenderStats::bindTexture(GL_TEXTURE_2D, textureID);
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        const CompressedImage::Level& mip = image.levels[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, internalFormat, mip.width, mip.height, 0,
+            (GLsizei)mip.blocks.size(), mip.blocks.data());
+        RenderStats::countTextureUpload(mip.blocks.size());
+        decodedBytes += (uint64_t)mip.width * mip.height * 4;
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+    if (image.gray)
+    {
+        // the single channel is the gray of a specular map, which the shaders read as RGB
+        GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    ++compressedImages;
+    compressedBytes += image.bytes();
+    return true;
+}
+
+void Textures::expandedToRGBA(Image& image)
+{
+    image.channels = 4;
+    image.color[3] = 255;
+}
+
+// Gives the texture its image, unless an identical one was uploaded already
+void Textures::uploadImage(const Image& image)
+{
+    GLuint textureID = image.texture;
+    const unsigned char* data = image.pixels;
+    int width = image.width;
+    int height = image.height;
+    int nrComponents = image.channels;
+    GLuint wrapMode = image.wrapMode;
+    uint64_t imageBytes = (uint64_t)width * height * nrComponents;
+
+    unsigned char flatPixels[FLAT_SIZE * FLAT_SIZE * 4];
+    if (dedup)
+    {
+        auto key = make_tuple(image.hash, width, height, nrComponents, wrapMode);
+        auto uploaded = contentTextures.find(key);
+        if (uploaded != contentTextures.end())
+        {
+            duplicates[textureID] = uploaded->second;
+            ++contentDuplicates;
+            savedBytes += imageBytes * 4 / 3;
+            skippedUploadBytes += imageBytes;
+            return;
+        }
+        contentTextures[key] = textureID;
+
+        if (image.flat)
+        {
+            for (int texel = 0; texel < FLAT_SIZE * FLAT_SIZE; ++texel)
+                memcpy(flatPixels + texel * nrComponents, image.color, nrComponents);
+            // the small image is in client memory, not in the buffer
+            if (image.inBuffer)
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            data = flatPixels;
+            width = FLAT_SIZE;
+            height = FLAT_SIZE;
+            ++flatImages;
+            savedBytes += (imageBytes - FLAT_SIZE * FLAT_SIZE * nrComponents) * 4 / 3;
+            skippedUploadBytes += imageBytes - FLAT_SIZE * FLAT_SIZE * nrComponents;
+        }
+    }
+
+    GLenum format = GL_RGBA;
+    GLenum internalFormat = GL_RGBA8;
+    if (nrComponents == 1)
+    {
+        format = GL_RED;
+        internalFormat = GL_R8;
+    }
+    else if (nrComponents == 2)
+    {
+        format = GL_RG;
+        internalFormat = GL_RG8;
+    }
+    else if (nrComponents == 3)
+    {
+        format = GL_RGB;
+        internalFormat = GL_RGB8;
+    }
+
+    // rows are tightly packed, which only matches the default alignment of 4 when their size does
+    bool packedRows = (width * nrComponents) % 4 != 0;
+    if (packedRows)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    RenderStats::bindTexture(GL_TEXTURE_2D, textureID);
+    if (streamer)
+        streamer->add(textureID, data, width, height, nrComponents);
+    else if (texStorage2D)
+    {
+        int levels = 1;
+        while ((width >> levels) > 0 || (height >> levels) > 0)
+            ++levels;
+        texStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+        RenderStats::countTextureUpload(RenderStats::imageBytes(width, height, format, GL_UNSIGNED_BYTE));
+    }
+    else
+        RenderStats::texImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, format, GL_UNSIGNED_BYTE, data);
+    if (packedRows)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (!streamer)
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+    // the filter only applies without --texture-filter samplers, which override it
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// Every 2D texture with its member, in the order createTextures loads them
+namespace
+{
+    struct NamedTexture
+    {
+        GLuint Textures::* member;
+        const char* path;
+        GLuint wrapMode;
+        Textures::Usage usage;
+    };
+
+    const NamedTexture NAMED_TEXTURES[Textures::SKYBOX] = {
+        // Rawpixel.com. (n.d.). Vertical Wooden Slats Texture Background. Retrieved from https://www.rawpixel.com/image/13176502/photo-image-background-texture-pattern
+        { &Textures::gTextureFence, "../OpenGLSample/resources/textures/fence.jpg", GL_REPEAT, Textures::COLOR },
+        // Rawpixel.com. (n.d.). Free Green Grass Field. Retrieved from https://www.rawpixel.com/image/5911993/image-background-wallpaper-texture
+        { &Textures::gTextureGrass, "../OpenGLSample/resources/textures/grass.jpg", GL_REPEAT, Textures::COLOR },
+        // KaiPhotographer. (n.d). Seamless Texture Wood. Vecteezy. Retrieved from https://www.vecteezy.com/photo/3498716-seamless-texture-wood-old-oak-or-modern-wood-texture
+        { &Textures::gTextureDesk, "../OpenGLSample/resources/textures/desk.jpg", GL_REPEAT, Textures::COLOR },
+        // Denamorado. (n.d.). Brown Rusty Stone Metal Surface. FreePik. Retrieved from https://www.freepik.com/free-photo/empty-brown-rusty-stone-metal-surface-texture_6029183.htm#query=rusty%20metal%20texture&position=19&from_view=keyword&track=ais&uuid=016c81ac-8c79-4587-b8c7-3133403cbe20
+        { &Textures::gTextureHammerHead, "../OpenGLSample/resources/textures/hammerHead.jpg", GL_REPEAT, Textures::COLOR },
+        // hhh316. (n.d.). Seamless Metal Rust 02 Texture. DeviantArt. Retrieved from https://www.deviantart.com/hhh316/art/Seamless-metal-rust-02-texture-164163192
+        { &Textures::gSpecularHammerHead, "../OpenGLSample/resources/textures/specularHammer.jpg", GL_REPEAT, Textures::SPECULAR },
+        // SimoonMurray. (n.d.). Metal Scratched. DeviantArt. Retrieved from https://www.deviantart.com/simoonmurray/art/Metal-Scratched-Texture-149542845
+        { &Textures::gTextureWood, "../OpenGLSample/resources/textures/wood.jpg", GL_REPEAT, Textures::COLOR },
+        // PhotosPublicDomain. (n.d.). Bumpy Green Plastic Texture. Retrieved from https://www.photos-public-domain.com/2013/11/06/bumpy-green-plastic-texture/
+        { &Textures::gTextureGreen, "../OpenGLSample/resources/textures/green.jpg", GL_REPEAT, Textures::COLOR },
+        // Lifeforstock. (n.d.). Free Photo Gray Wall Textures. Freepik. Retrieved from https://www.freepik.com/free-photo/gray-wall-textures-background_3753132.htm#query=gray&position=4&from_view=search&track=sph&uuid=283eb317-83fa-4a7b-8c67-025ea6e795c5
+        { &Textures::gTextureClear, "../OpenGLSample/resources/textures/clear.jpg", GL_REPEAT, Textures::COLOR },
+        // No attribution required. Retrieved from https://pxhere.com/en/photo/1115674
+        { &Textures::gTextureOrange, "../OpenGLSample/resources/textures/orange.jpg", GL_REPEAT, Textures::COLOR },
+        // Hasan, M. (n.d.). Concrete Wall Yellow Color For Texture Background. Retrieved from https://www.vecteezy.com/vector-art/16596770-concrete-wall-yellow-color-for-texture-background-abstract-yellow-grunge-background-with-growing-effect-yellow-color-painting-background-vector-illustration
+        { &Textures::gTextureYellow, "../OpenGLSample/resources/textures/yellow.jpg", GL_REPEAT, Textures::COLOR },
+        { &Textures::gTextureEyes, "../OpenGLSample/resources/textures/eyes.png", GL_REPEAT, Textures::COLOR },
+        { &Textures::gTextureQuestion, "../OpenGLSample/resources/textures/questionMark.png", GL_REPEAT, Textures::COLOR },
+        // KaiPhotographer. (n.d). Gold Background Texture. Vecteezy. Retrieved from https://www.vecteezy.com/photo/3498769-gold-background-texture
+        { &Textures::gTextureBrass, "../OpenGLSample/resources/textures/brass.jpg", GL_MIRRORED_REPEAT, Textures::COLOR },
+        // Rawpixel.com. (n.d.). PNG Snowflake Backgrounds Shape. Retrieved from https://www.rawpixel.com/image/12752198/png-snowflake-backgrounds-shape-blue-generated-image-rawpixel
+        { &Textures::gTextureSnowflakes, "../OpenGLSample/resources/textures/snowflakes.png", GL_REPEAT, Textures::OVERLAY },
+        { &Textures::gTextureLeaf, "../OpenGLSample/resources/textures/bucketLeaf.png", GL_MIRRORED_REPEAT, Textures::COLOR },
+        { &Textures::gTextureLeaf2, "../OpenGLSample/resources/textures/bucketLeaf2.png", GL_MIRRORED_REPEAT, Textures::COLOR },
+        { &Textures::gTexture4Panel, "../OpenGLSample/resources/textures/4Panel.png", GL_REPEAT, Textures::COLOR },
+        { &Textures::gTextureDrinkFront, "../OpenGLSample/resources/textures/drinkFront.png", GL_REPEAT, Textures::COLOR },
+        { &Textures::gTextureDrinkTop, "../OpenGLSample/resources/textures/drinkTop.png", GL_REPEAT, Textures::COLOR },
+        // Rawpixel.com. (n.d.). Free Photo Glass Background with Frosted Pattern. Freepik. Retrieved from https://www.freepik.com/free-photo/glass-background-with-frosted-pattern_19075756.htm#query=smooth%20plastic%20texture&position=2&from_view=keyword&track=ais&uuid=86683cdd-bdd0-47e7-a250-21d13e106a77
+        { &Textures::gSpecularPlastic, "../OpenGLSample/resources/textures/specularPlastic.jpg", GL_REPEAT, Textures::SPECULAR },
+        // Rawpixel.com. (n.d.). Silver Gradient Backgrounds Reflection Abstract. Retrieved from https://www.rawpixel.com/image/13176471/image-background-abstract-texture
+        { &Textures::gSpecularMetal, "../OpenGLSample/resources/textures/specularMetal.jpg", GL_REPEAT, Textures::SPECULAR },
+        // Rawpixel.com. (n.d.). Silver Gradient Backgrounds Reflection Abstract. Retrieved from https://www.rawpixel.com/image/13176471/image-background-abstract-texture
+        { &Textures::gTextureBrick, "../OpenGLSample/resources/textures/brick.png", GL_REPEAT, Textures::COLOR }
+    };
+}
+
 // Assign textures
 void Textures::createTextures() {
+    PROFILE_ZONE("Textures::createTextures");
+    auto start = chrono::steady_clock::now();
+
+    for (const NamedTexture& named : NAMED_TEXTURES)
+        this->*named.member = loadTexture(named.path, named.wrapMode, named.usage);
 
-    // Rawpixel.com. (n.d.). Vertical Wooden Slats Texture Background. Retrieved from https://www.rawpixel.com/image/13176502/photo-image-background-texture-pattern
-    gTextureFence = loadTexture("../OpenGLSample/resources/textures/fence.jpg", GL_REPEAT);
-    // Rawpixel.com. (n.d.). Free Green Grass Field. Retrieved from https://www.rawpixel.com/image/5911993/image-background-wallpaper-texture
-    gTextureGrass = loadTexture("../OpenGLSample/resources/textures/grass.jpg", GL_REPEAT);
-    // KaiPhotographer. (n.d). Seamless Texture Wood. Vecteezy. Retrieved from https://www.vecteezy.com/photo/3498716-seamless-texture-wood-old-oak-or-modern-wood-texture
-    gTextureDesk = loadTexture("../OpenGLSample/resources/textures/desk.jpg", GL_REPEAT);
-    // Denamorado. (n.d.). Brown Rusty Stone Metal Surface. FreePik. Retrieved from https://www.freepik.com/free-photo/empty-brown-rusty-stone-metal-surface-texture_6029183.htm#query=rusty%20metal%20texture&position=19&from_view=keyword&track=ais&uuid=016c81ac-8c79-4587-b8c7-3133403cbe20
-    gTextureHammerHead = loadTexture("../OpenGLSample/resources/textures/hammerHead.jpg", GL_REPEAT);
-    // hhh316. (n.d.). Seamless Metal Rust 02 Texture. DeviantArt. Retrieved from https://www.deviantart.com/hhh316/art/Seamless-metal-rust-02-texture-164163192
-    gSpecularHammerHead = loadTexture("../OpenGLSample/resources/textures/specularHammer.jpg", GL_REPEAT);
-    // SimoonMurray. (n.d.). Metal Scratched. DeviantArt. Retrieved from https://www.deviantart.com/simoonmurray/art/Metal-Scratched-Texture-149542845
-    gTextureWood = loadTexture("../OpenGLSample/resources/textures/wood.jpg", GL_REPEAT);
-    // PhotosPublicDomain. (n.d.). Bumpy Green Plastic Texture. Retrieved from https://www.photos-public-domain.com/2013/11/06/bumpy-green-plastic-texture/
-    gTextureGreen = loadTexture("../OpenGLSample/resources/textures/green.jpg", GL_REPEAT);
-    // Lifeforstock. (n.d.). Free Photo Gray Wall Textures. Freepik. Retrieved from https://www.freepik.com/free-photo/gray-wall-textures-background_3753132.htm#query=gray&position=4&from_view=search&track=sph&uuid=283eb317-83fa-4a7b-8c67-025ea6e795c5
-    gTextureClear = loadTexture("../OpenGLSample/resources/textures/clear.jpg", GL_REPEAT);
-    // No attribution required. Retrieved from https://pxhere.com/en/photo/1115674
-    gTextureOrange = loadTexture("../OpenGLSample/resources/textures/orange.jpg", GL_REPEAT);
-    // Hasan, M. (n.d.). Concrete Wall Yellow Color For Texture Background. Retrieved from https://www.vecteezy.com/vector-art/16596770-concrete-wall-yellow-color-for-texture-background-abstract-yellow-grunge-background-with-growing-effect-yellow-color-painting-background-vector-illustration
-    gTextureYellow = loadTexture("../OpenGLSample/resources/textures/yellow.jpg", GL_REPEAT);
-    gTextureEyes = loadTexture("../OpenGLSample/resources/textures/eyes.png", GL_REPEAT);
-    gTextureQuestion = loadTexture("../OpenGLSample/resources/textures/questionMark.png", GL_REPEAT);
-    // KaiPhotographer. (n.d). Gold Background Texture. Vecteezy. Retrieved from https://www.vecteezy.com/photo/3498769-gold-background-texture
-    gTextureBrass = loadTexture("../OpenGLSample/resources/textures/brass.jpg", GL_MIRRORED_REPEAT);
-    // Rawpixel.com. (n.d.). PNG Snowflake Backgrounds Shape. Retrieved from https://www.rawpixel.com/image/12752198/png-snowflake-backgrounds-shape-blue-generated-image-rawpixel
-    gTextureSnowflakes = loadTexture("../OpenGLSample/resources/textures/snowflakes.png", GL_REPEAT);
-    gTextureLeaf = loadTexture("../OpenGLSample/resources/textures/bucketLeaf.png", GL_MIRRORED_REPEAT);
-    gTextureLeaf2 = loadTexture("../OpenGLSample/resources/textures/bucketLeaf2.png", GL_MIRRORED_REPEAT);
-    gTexture4Panel = loadTexture("../OpenGLSample/resources/textures/4Panel.png", GL_REPEAT);
-    gTextureDrinkFront = loadTexture("../OpenGLSample/resources/textures/drinkFront.png", GL_REPEAT);
-    gTextureDrinkTop = loadTexture("../OpenGLSample/resources/textures/drinkTop.png", GL_REPEAT);
-    // Rawpixel.com. (n.d.). Free Photo Glass Background with Frosted Pattern. Freepik. Retrieved from https://www.freepik.com/free-photo/glass-background-with-frosted-pattern_19075756.htm#query=smooth%20plastic%20texture&position=2&from_view=keyword&track=ais&uuid=86683cdd-bdd0-47e7-a250-21d13e106a77
-    gSpecularPlastic = loadTexture("../OpenGLSample/resources/textures/specularPlastic.jpg", GL_REPEAT);
-    // Rawpixel.com. (n.d.). Silver Gradient Backgrounds Reflection Abstract. Retrieved from https://www.rawpixel.com/image/13176471/image-background-abstract-texture
-    gSpecularMetal = loadTexture("../OpenGLSample/resources/textures/specularMetal.jpg", GL_REPEAT);
-    // Rawpixel.com. (n.d.). Silver Gradient Backgrounds Reflection Abstract. Retrieved from https://www.rawpixel.com/image/13176471/image-background-abstract-texture
-    gTextureBrick = loadTexture("../OpenGLSample/resources/textures/brick.png", GL_REPEAT);
+    if (uploader)
+    {
+        uploader->finish([this](const Image& image) { uploadImage(image); });
+    }
+    resolveDuplicates();
+    // everything above ran on the main thread, so this is how long loading held it up
+    std::cout << "Loaded " << sources.size() << " textures in "
+        << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << "ms" << std::endl;
+    if (dedup)
+    {
+        std::cout << "  dedup: " << pathDuplicates << " repeated paths, " << contentDuplicates << " identical images, "
+            << flatImages << " flat images collapsed to " << FLAT_SIZE << "x" << FLAT_SIZE << ", " << savedBytes / (1024.0 * 1024.0)
+            << " MB of texture memory and " << skippedUploadBytes / (1024.0 * 1024.0) << " MB of uploads saved" << std::endl;
+    }
+    if (compressedImages > 0)
+    {
+        std::cout << "  compressed: " << compressedImages << " textures from " << compressedDirectory << ", "
+            << compressedBytes / (1024.0 * 1024.0) << " MB instead of " << decodedBytes / (1024.0 * 1024.0) << " MB as RGBA8" << std::endl;
+    }
 
 };
 
+void Textures::resolveDuplicates()
+{
+    if (!duplicates.empty())
+    {
+        for (const NamedTexture& named : NAMED_TEXTURES)
+        {
+            GLuint& member = this->*named.member;
+            auto duplicate = duplicates.find(member);
+            if (duplicate != duplicates.end())
+                member = duplicate->second;
+        }
+        for (auto& duplicate : duplicates)
+            UDestroyTexture(duplicate.first);
+        sources.erase(remove_if(sources.begin(), sources.end(), [this](const Source& source) {
+            return duplicates.count(source.texture) > 0;
+        }), sources.end());
+    }
+    pathTextures.clear();
+    contentTextures.clear();
+    duplicates.clear();
+}
+
+GLuint Textures::load(Name name, uint64_t& bytes)
+{
+    PROFILE_ZONE("Textures::load");
+    uint64_t uploaded = RenderStats::current().textureBytes;
+    int compressed = compressedImages;
+    if (name == SKYBOX)
+    {
+        gTextureSkybox = loadSkyBox();
+        bytes = RenderStats::current().textureBytes - uploaded;
+        return gTextureSkybox;
+    }
+    const NamedTexture& named = NAMED_TEXTURES[name];
+    GLuint texture = loadTexture(named.path, named.wrapMode, named.usage);
+    this->*named.member = texture;
+    // packed files bring their mips along, glGenerateMipmap adds a third to the rest
+    bytes = RenderStats::current().textureBytes - uploaded;
+    if (compressedImages == compressed)
+        bytes = bytes * 4 / 3;
+    return texture;
+}
+
+void Textures::unload(Name name)
+{
+    GLuint& member = name == SKYBOX ? gTextureSkybox : this->*NAMED_TEXTURES[name].member;
+    UDestroyTexture(member);
+    sources.erase(remove_if(sources.begin(), sources.end(), [&member](const Source& source) {
+        return source.texture == member;
+    }), sources.end());
+    member = 0;
+}
+
+GLuint Textures::texture(Name name) const
+{
+    return name == SKYBOX ? gTextureSkybox : this->*NAMED_TEXTURES[name].member;
+}
+
+const char* Textures::path(Name name)
+{
+    return name == SKYBOX ? "../OpenGLSample/resources/skybox" : NAMED_TEXTURES[name].path;
+}
+
 // Destroys all textures
 void Textures::destroyTextures()
 {
@@ -140,6 +440,9 @@ void Textures::destroyTextures()
     UDestroyTexture(gSpecularPlastic);
     UDestroyTexture(gSpecularMetal);
     UDestroyTexture(gTextureBrick);
+    UDestroyTexture(gTextureSkybox);
+    gTextureSkybox = 0;
+    sources.clear();
 }
 
 // Destroys a texture
@@ -162,7 +465,7 @@ unsigned int Textures::loadSkyBox()
     };
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    RenderStats::bindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++)
@@ -170,8 +473,8 @@ unsigned int Textures::loadSkyBox()
         unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
         if (data)
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
+            RenderStats::texImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                0, GL_RGB, width, height, GL_RGB, GL_UNSIGNED_BYTE, data
             );
             stbi_image_free(data);
         }
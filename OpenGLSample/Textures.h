@@ -10,10 +10,18 @@
 #pragma once
 #include <iostream>
 #include <glad/glad.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 
+class TextureStreamer;
+class TextureUploader;
+
 // Generate, load, hold, and destroy textures that can be applied to 3D objects
 class Textures
 {
@@ -41,13 +49,122 @@ public:
     GLuint gSpecularPlastic;
     GLuint gSpecularMetal;
     GLuint gTextureBrick;
+    GLuint gTextureSkybox = 0;
+
+    // Names of the textures above, the 2D ones first; createTextures loads every 2D one, load
+    // any of them on its own
+    enum Name
+    {
+        FENCE, GRASS, DESK, HAMMER_HEAD, SPECULAR_HAMMER_HEAD, WOOD, GREEN, CLEAR, ORANGE, YELLOW, EYES,
+        QUESTION, BRASS, SNOWFLAKES, LEAF, LEAF2, PANEL4, DRINK_FRONT, DRINK_TOP, SPECULAR_PLASTIC,
+        SPECULAR_METAL, BRICK,
+        SKYBOX,     // the cube map
+        NAME_COUNT
+    };
+
+    // What the shaders read from a texture, which decides how it may be compressed
+    enum Usage
+    {
+        COLOR,      // diffuse color, alpha unused
+        SPECULAR,   // specular strength, often gray
+        OVERLAY     // blended over the lit color by its alpha
+    };
+
+    // Where each texture was loaded from, for code that rebuilds them in another layout
+    struct Source
+    {
+        GLuint texture;
+        const char* path;
+        GLuint wrapMode;
+        Usage usage;
+    };
+    vector<Source> sources;
+
+    // A decoded image, flipped bottom row first. When inBuffer, pixels is an offset into the
+    // bound GL_PIXEL_UNPACK_BUFFER
+    struct Image
+    {
+        GLuint texture;
+        GLuint wrapMode;
+        int width;
+        int height;
+        int channels;
+        const unsigned char* pixels;
+        bool inBuffer;
+        // from inspect: content hash, and whether every texel is within FLAT_TOLERANCE of color
+        uint64_t hash;
+        bool flat;
+        unsigned char color[4];
+    };
+    // Largest difference from the mean color, per channel, of an image that counts as flat
+    static const int FLAT_TOLERANCE = 12;
+    // Flat images are uploaded at this size in their mean color
+    static const int FLAT_SIZE = 4;
+    // Fills in hash, flat and color of an image whose pixels are in client memory
+    static void inspect(Image& image);
+
+    // Gives an inspected image the four channels and opaque flat color of its RGBA expansion
+    static void expandedToRGBA(Image& image);
+
+    // Images with the same path or content and wrap mode share one texture, and flat ones are
+    // collapsed; --no-texture-dedup clears it
+    bool dedup = true;
+    // Expand images without alpha to RGBA while flipping them, so every upload has 4 byte
+    // texels and rows in the layout drivers store them; set by --texture-rgba
+    bool expandToRGBA = false;
+
+    // glTexStorage2D from GL 4.2 or ARB_texture_storage, set before createTextures to give
+    // textures immutable storage with every mip level allocated up front. While it's null they
+    // are uploaded with glTexImage2D
+    typedef void (APIENTRYP TexStorage2DProc)(GLenum target, GLsizei levels, GLenum internalFormat, GLsizei width, GLsizei height);
+    TexStorage2DProc texStorage2D = nullptr;
+    // Directory of .btex files packed by --pack-textures; textures with a packed file there are
+    // uploaded block compressed instead of decoded. Set by --compressed-textures, needs S3TC
+    string compressedDirectory;
+    // When set before createTextures, the images go to the streamer, which uploads only their
+    // small mip levels and streams the rest; the texture names stay the same
+    TextureStreamer* streamer = nullptr;
+    // When set before createTextures, its workers decode the images and createTextures only
+    // issues the uploads; it can't be combined with the streamer, which needs the images in memory
+    TextureUploader* uploader = nullptr;
 
     void createTextures();
     void destroyTextures();
     unsigned int loadSkyBox();
 
+    // Loads a single texture into its member and returns it, for loading textures as they are
+    // needed; bytes is what it takes on the GPU, mips included. Call it without dedup, uploader
+    // or streamer, whose sharing and batching only createTextures resolves
+    GLuint load(Name name, uint64_t& bytes);
+    // Deletes the texture and clears its member
+    void unload(Name name);
+    // The member of a name
+    GLuint texture(Name name) const;
+    // File a texture is loaded from, the folder of the faces for the skybox
+    static const char* path(Name name);
+
 private:
-    void flipImageVertically(unsigned char* image, int width, int height, int channels);
-    unsigned int loadTexture(const char* filename, GLuint wrapMode);
+    unsigned int loadTexture(const char* filename, GLuint wrapMode, Usage usage = COLOR);
+    bool loadCompressed(GLuint textureID, const char* path);
+    void uploadImage(const Image& image);
+    // Points the members at the textures their duplicates were folded into
+    void resolveDuplicates();
     void UDestroyTexture(GLuint textureId);
+
+    // Only used while createTextures runs
+    map<pair<string, GLuint>, GLuint> pathTextures;
+    map<tuple<uint64_t, int, int, int, GLuint>, GLuint> contentTextures;
+    unordered_map<GLuint, GLuint> duplicates;
+
+    // what dedup saved, GPU bytes include the mip chain
+    int pathDuplicates = 0;
+    int contentDuplicates = 0;
+    int flatImages = 0;
+    uint64_t savedBytes = 0;
+    uint64_t skippedUploadBytes = 0;
+
+    // textures uploaded from compressedDirectory, and what they would have taken decoded
+    int compressedImages = 0;
+    uint64_t compressedBytes = 0;
+    uint64_t decodedBytes = 0;
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ThreadPool.cpp                                                                     //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Fixed set of worker threads for background jobs (image encoding) and for  //
+// splitting loops over tiles or rows across every core.                                   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+#include "CpuProfiler.h"
+#include <atomic>
+#include <memory>
+using namespace std; // Standard namespace
+
+ThreadPool::ThreadPool(unsigned threadCount, const char* name)
+{
+    if (threadCount == 0)
+    {
+        unsigned hardware = thread::hardware_concurrency();
+        threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+    for (unsigned i = 0; i < threadCount; ++i)
+        threads.emplace_back(&ThreadPool::workerLoop, this, string(name) + " " + to_string(i + 1));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (thread& worker : threads)
+        worker.join();
+}
+
+void ThreadPool::submit(function<void()> task)
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(move(task));
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::workerLoop(string threadName)
+{
+    PROFILE_THREAD_NAME(threadName.c_str());
+    (void)threadName;  // only read when profiling is compiled in
+    for (;;)
+    {
+        function<void()> task;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = move(tasks.front());
+            tasks.pop_front();
+            ++running;
+        }
+
+        task();
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            --running;
+            if (tasks.empty() && running == 0)
+                idle.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int count, const function<void(int)>& body)
+{
+    if (count <= 0)
+        return;
+
+    // shared by the helpers; they may still be starting after the caller ran out of work
+    struct Job
+    {
+        atomic<int> next{ 0 };
+        atomic<int> done{ 0 };
+        int count = 0;
+        const function<void(int)>* body = nullptr;
+        std::mutex mutex;
+        condition_variable finished;
+    };
+    auto job = make_shared<Job>();
+    job->count = count;
+    job->body = &body;
+
+    auto work = [job]() {
+        int completed = 0;
+        for (int i = job->next.fetch_add(1); i < job->count; i = job->next.fetch_add(1))
+        {
+            (*job->body)(i);
+            ++completed;
+        }
+        if (completed > 0 && job->done.fetch_add(completed) + completed == job->count)
+        {
+            lock_guard<std::mutex> lock(job->mutex);
+            job->finished.notify_all();
+        }
+    };
+
+    unsigned helpers = (unsigned)count - 1 < size() ? (unsigned)count - 1 : size();
+    for (unsigned i = 0; i < helpers; ++i)
+        submit(work);
+    work();
+
+    unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job] { return job->done.load() == job->count; });
+}
@@ -0,0 +1,49 @@
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Name: ThreadPool.h                                                                       //
+// Author: Michael Gagujas                                                                  //
+//                                                                                          //
+// Description: Fixed set of worker threads for background jobs (image encoding) and for  //
+// splitting loops over tiles or rows across every core.                                   //
+//////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs submitted tasks on a fixed number of threads
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread, minus one for the thread that submits work
+    explicit ThreadPool(unsigned threadCount = 0, const char* name = "Worker");
+    // Finishes the queued tasks, then joins the threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned)threads.size(); }
+
+    void submit(std::function<void()> task);
+    // Blocks until the queue is empty and no task is running
+    void wait();
+    // Calls body(i) for every i in [0, count). Indices are handed out one at a time, so
+    // uneven items balance themselves; the calling thread helps and returns when all are done
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+private:
+    void workerLoop(std::string threadName);
+
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskReady;
+    std::condition_variable idle;
+    unsigned running = 0;
+    bool stopping = false;
+};
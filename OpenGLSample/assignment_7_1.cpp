@@ -41,8 +41,35 @@
 #include "MeshCreator.h"
 #include "Textures.h"
 #include "SceneObjects.h"
+#include "AppOptions.h"
+#include "FrameScheduler.h"
+#include "SimulationClock.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "StatsOverlay.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "RenderStats.h"
+#include "Benchmark.h"
+#include "InputLog.h"
+#include "OffscreenTarget.h"
+#include "ImageWriter.h"
+#include "FrameCapture.h"
+#include "PoseList.h"
+#include "SoftwareGL.h"
+#include "ImageDiff.h"
+#include "PathTracer.h"
+#include "TextureArrays.h"
+#include "TextureSamplers.h"
+#include "TextureStreamer.h"
+#include "TextureUploader.h"
+#include "ImageRows.h"
+#include "TexturePacker.h"
+#include "BindlessMaterials.h"
+#include "ResourceManager.h"
 
 #include <iostream>
+#include <sstream>
 using namespace::std;
 
 // Unnamed namespace
@@ -51,6 +78,11 @@ namespace
 	// Window settings
 	const unsigned int SCR_WIDTH = 800;
 	const unsigned int SCR_HEIGHT = 600;
+	const char* WINDOW_TITLE = "7-1 Michael Gagujas";
+
+	// Current framebuffer size, can differ from the window size on high-DPI displays
+	int framebufferWidth = SCR_WIDTH;
+	int framebufferHeight = SCR_HEIGHT;
 
 	// Meshes data
 	MeshCreator gMesh;
@@ -61,15 +93,17 @@ namespace
 	// Creates objects for scene
 	SceneObjects builder;
 
+	// Holds the meshes and textures by reference count, creating them as they are needed
+	ResourceManager resources(gMesh, gTexture);
+
 	// Camera
 	Camera camera(glm::vec3(0.0f, 2.8f, 4.8f));
 	float lastX = SCR_WIDTH / 2.0f;
 	float lastY = SCR_HEIGHT / 2.0f;
 	bool firstMouse = true;
 
-	// Timing
-	float deltaTime = 0.0f;
-	float lastFrame = 0.0f;
+	// Timing, movement runs in fixed steps and rendering interpolates between them
+	SimulationClock simClock;
 
 	// Positions of the point lights
 	glm::vec3 pointLightPositions[] = {
@@ -77,26 +111,143 @@ namespace
 		glm::vec3(2.0f, 2.2f, 1.7f),
 	};
 
+	// Simulation state from the step before the current one
+	glm::vec3 prevCameraPosition = camera.Position;
+	glm::vec3 prevPointLightPositions[] = {
+		pointLightPositions[0],
+		pointLightPositions[1],
+	};
+
 	// Default status values
 	int lightNumber = 1;
 	bool showPerspective = true;
 	bool showFlashlight = true;
 	bool showSkybox = false;
+
+	// Decides when a new frame actually needs to be drawn
+	FrameScheduler scheduler;
+	// Limits and measures how fast frames are presented
+	FramePacer pacer;
+	// Lowers the render resolution when the GPU can't keep up
+	DynamicResolution dynamicResolution;
+	// Live numbers in the title bar
+	StatsOverlay overlay;
+	// GPU timings per pass and per scene object
+	GpuProfiler& gpuProfiler = GpuProfiler::shared();
+	RenderStats renderStats;
+
+	// Scripted camera path rendered offscreen instead of live input
+	bool benchmarkMode = false;
+	Benchmark benchmark;
+
+	// Frames go into a framebuffer instead of a visible window
+	bool offscreenMode = false;
+	OffscreenTarget offscreenTarget;
+
+	// Video or image sequence recording
+	FrameCapture frameCapture;
+
+	// One image per listed camera pose, readback and PNG encoding overlap the next poses
+	bool batchMode = false;
+	PoseList batchPoses;
+	size_t batchIndex = 0;
+
+	// Offline reference still of the last frame, built from the draws the software backend sees
+	unique_ptr<PathTracer> pathTracer;
+
+	// Material textures as array layers, see --texture-arrays
+	TextureArrays textureArrays;
+	BindlessMaterials bindlessMaterials;
+	// Trilinear or anisotropic samplers for the material textures, see --texture-filter
+	TextureSamplers textureSamplers;
+	// Material texture mips streamed within a GPU memory budget, see --texture-budget
+	TextureStreamer textureStreamer;
+	// Decodes the textures on worker threads at startup, see --texture-threads
+	TextureUploader textureUploader;
+
+	// Input recording and replay; bit i of a key mask is the state of POLLED_KEYS[i]
+	InputLog inputLog;
+	const int POLLED_KEYS[] = {
+		GLFW_KEY_ESCAPE, GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_Q, GLFW_KEY_E,
+		GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_I, GLFW_KEY_K, GLFW_KEY_J, GLFW_KEY_L, GLFW_KEY_U, GLFW_KEY_O,
+	};
+	uint32_t replayKeys = 0;
+	float replayAlpha = 0.0f;
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-void processInput(GLFWwindow* window);
+void processInput(GLFWwindow* window, float stepTime);
 void moveLight(string direction, float time);
 void toggleEvent(GLFWwindow* window, int key, int scancode, int action, int mods);
+void window_refresh_callback(GLFWwindow* window);
+void applyBenchmarkFrame(const BenchmarkFrame& frame);
+bool replayToNextFrame(GLFWwindow* window);
 
 
-int main()
+int main(int argc, char* argv[])
 {
+	AppOptions options;
+	if (!parseOptions(argc, argv, options))
+		return -1;
+	options.resolve();
+	scheduler.onDemand = options.onDemand;
+	scheduler.maxIdleSeconds = options.maxIdleSeconds;
+	simClock.setStepSeconds(1.0 / options.simulationHz);
+
+	if (!options.batchPath.empty())
+	{
+		if (!batchPoses.load(options.batchPath))
+			return -1;
+		batchMode = true;
+		options.frameLimit = (int)batchPoses.poses().size();
+	}
+	else if (!options.benchmarkPath.empty())
+	{
+		if (!benchmark.load(options.benchmarkPath))
+			return -1;
+		benchmarkMode = true;
+	}
+	else if (!options.replayPath.empty())
+	{
+		if (!inputLog.startReplay(options.replayPath))
+			return -1;
+		simClock.setStepSeconds(inputLog.stepSeconds());
+	}
+
+	// offscreen rendering, for benchmarks, batches, image output and machines without a display
+	int offscreenWidth = options.offscreenWidth > 0 ? options.offscreenWidth : SCR_WIDTH;
+	int offscreenHeight = options.offscreenHeight > 0 ? options.offscreenHeight : SCR_HEIGHT;
+	if (benchmarkMode)
+	{
+		offscreenWidth = benchmark.width;
+		offscreenHeight = benchmark.height;
+	}
+	else if (batchMode)
+	{
+		offscreenWidth = batchPoses.width;
+		offscreenHeight = batchPoses.height;
+	}
+	bool headless = !options.headlessApi.empty();
+	offscreenMode = options.offscreen();
+
 	// glfw: initialize and configure
 	// ------------------------------
-	glfwInit();
+	if (headless || options.software)
+	{
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+		// no X11/Wayland/Win32 at all; the context comes from EGL (surfaceless on Mesa) or OSMesa
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#else
+		cout << "--headless needs GLFW 3.4 or newer, falling back to a hidden window" << endl;
+#endif
+	}
+	if (!glfwInit())
+	{
+		cout << "Failed to initialize GLFW" << endl;
+		return -1;
+	}
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -104,29 +255,54 @@ int main()
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+	// offscreen modes draw into their own framebuffer, the window only provides the context
+	if (offscreenMode)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	if (options.software)
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	else if (headless)
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, options.headlessApi == "osmesa" ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
 
 	// glfw window creation
 	// --------------------
-	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "7-1 Michael Gagujas", NULL, NULL);
+	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, WINDOW_TITLE, NULL, NULL);
 	if (window == NULL)
 	{
 		std::cout << "Failed to create GLFW window" << std::endl;
 		glfwTerminate();
 		return -1;
 	}
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
-	glfwSetKeyCallback(window, toggleEvent);
-
+	if (!options.software)
+		glfwMakeContextCurrent(window);
+	if (!offscreenMode)
+	{
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSetWindowRefreshCallback(window, window_refresh_callback);
+	}
+	// live input would disturb a scripted or replayed run
+	if (!offscreenMode && !inputLog.replaying())
+	{
+		glfwSetCursorPosCallback(window, mouse_callback);
+		glfwSetScrollCallback(window, scroll_callback);
+		glfwSetKeyCallback(window, toggleEvent);
 
-	// tell GLFW to capture our mouse
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		// tell GLFW to capture our mouse
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	}
 
-	// glad: load all OpenGL function pointers
-	// ---------------------------------------
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	// glad: load all OpenGL function pointers, or point them at the CPU renderer
+	// ---------------------------------------------------------------------------
+	if (options.software)
+	{
+		SoftwareGL::install(options.softwareThreads > 0 ? options.softwareThreads : 0);
+		if (options.pathTraceSamples > 0)
+		{
+			pathTracer.reset(new PathTracer(options.softwareThreads > 0 ? options.softwareThreads : 0));
+			pathTracer->maxBounces = options.pathTraceBounces;
+			SoftwareGL::setDrawListener([](const SoftwareDraw& draw) { pathTracer->addDraw(draw); });
+		}
+	}
+	else if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
@@ -135,18 +311,166 @@ int main()
 	// configure global opengl state
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
+	pacer.configure(options.targetFps, options.swapInterval, options.maxFramesAhead, options.frameLogSeconds, options.adaptiveFps);
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	if (offscreenMode)
+	{
+		framebufferWidth = offscreenWidth;
+		framebufferHeight = offscreenHeight;
+		if (!offscreenTarget.create(framebufferWidth, framebufferHeight, options.msaaSamples))
+		{
+			cout << "Failed to create the offscreen framebuffer" << endl;
+			glfwTerminate();
+			return -1;
+		}
+		cout << "Rendering offscreen at " << framebufferWidth << "x" << framebufferHeight;
+		if (options.msaaSamples > 1)
+			cout << " with " << options.msaaSamples << "x MSAA";
+		cout << " on " << glGetString(GL_RENDERER) << endl;
+	}
+
+	dynamicResolution.enabled = options.dynamicResolution;
+	dynamicResolution.budgetMs = options.gpuBudgetMs;
+	dynamicResolution.minScale = options.minScale;
+	if (dynamicResolution.enabled)
+		dynamicResolution.init();
+	overlay.enabled = options.showStats;
+
+	if (!options.renderStatsPath.empty())
+		renderStats.openStream(options.renderStatsPath);
+
+	// CPU zones are only recorded when a trace was asked for
+	CpuProfiler::setCapturing(!options.tracePath.empty());
+	PROFILE_BEGIN("startup");
+
+	// the software renderer has no timer queries, --trace only records the CPU zones there
+	gpuProfiler.enabled = options.gpuProfile || (!options.tracePath.empty() && !options.software);
+	gpuProfiler.setTraceCapture(!options.tracePath.empty());
+	if (gpuProfiler.enabled)
+		gpuProfiler.init();
 
 	// build and compile our shader zprogram
 	// ------------------------------------
-	Shader lightingShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", "../OpenGLSample/shaderfiles/6.multiple_lights.fs");
+	// bindless materials need the extension's entry points, without them materials are bound per draw
+	bool bindless = false;
+	if (options.bindless)
+	{
+		bindless = glfwExtensionSupported("GL_ARB_bindless_texture") && bindlessMaterials.load((GLADloadproc)glfwGetProcAddress);
+		if (!bindless)
+			cout << "No bindless texture support, materials are bound per draw" << endl;
+	}
+	Shader lightingShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", bindless
+		? "../OpenGLSample/shaderfiles/6.multiple_lights_bindless.fs" : options.textureArraySize >= 0
+		? "../OpenGLSample/shaderfiles/6.multiple_lights_array.fs" : "../OpenGLSample/shaderfiles/6.multiple_lights.fs");
 	Shader lightCubeShader("../OpenGLSample/shaderfiles/6.light_cube.vs", "../OpenGLSample/shaderfiles/6.light_cube.fs");
 	Shader skyboxShader("../OpenGLSample/shaderfiles/skybox.vs", "../OpenGLSample/shaderfiles/skybox.fs");
 
-	// Create meshes
-	gMesh.createMeshes();
+	// programs are linked, so the cached shader objects are no longer needed
+	ShaderCache::shared().printStats();
+	ShaderCache::shared().releaseStages();
 
-	// Load textures
-	gTexture.createTextures();
+	// Create meshes, all of them up front unless each is created when first drawn
+	vector<MeshHandle> preloadedMeshes;
+	if (!options.lazyResources)
+	{
+		for (int kind = 0; kind < MeshCreator::MESH_COUNT; ++kind)
+			preloadedMeshes.push_back(resources.acquire((MeshCreator::Kind)kind));
+	}
+	MeshHandle lampMesh = resources.acquire(MeshCreator::CUBE);
+	MeshHandle skyboxMesh;
+	TextureHandle skyboxTexture;
+	// De-allocate all resources once they've outlived their purpose, on every way out from here
+	auto destroyResources = [&]() {
+		// Release what refers to the textures while they still exist
+		bindlessMaterials.destroy();
+		textureArrays.destroy();
+		textureSamplers.destroy();
+		textureStreamer.destroy();
+
+		// Release meshes data, and the textures created as they were needed
+		builder.releaseResources(resources);
+		resources.release(lampMesh);
+		resources.releaseAll();
+
+		// Release textures
+		gTexture.destroyTextures();
+	};
+
+	// Load textures, into immutable storage where the driver has it, unless streaming changes their levels
+	if (options.textureBudgetMB > 0.0f)
+	{
+		textureStreamer.budgetBytes = (uint64_t)(options.textureBudgetMB * 1024.0f * 1024.0f);
+		gTexture.streamer = &textureStreamer;
+		builder.textureStreamer = &textureStreamer;
+	}
+	else if (!options.software && glfwExtensionSupported("GL_ARB_texture_storage"))
+		gTexture.texStorage2D = (Textures::TexStorage2DProc)glfwGetProcAddress("glTexStorage2D");
+	if (options.textureThreads > 0)
+	{
+		// the ring needs persistent mapping, without it the workers hand over their own copies
+		TextureUploader::BufferStorageProc bufferStorage = nullptr;
+		if (!options.software && glfwExtensionSupported("GL_ARB_buffer_storage"))
+			bufferStorage = (TextureUploader::BufferStorageProc)glfwGetProcAddress("glBufferStorage");
+		textureUploader.expandToRGBA = options.textureRGBA;
+		textureUploader.start(options.textureThreads, bufferStorage, options.textureDedup);
+		gTexture.uploader = &textureUploader;
+	}
+	// textures loaded one by one can't be compared against the rest
+	gTexture.dedup = options.textureDedup && !options.lazyResources;
+	gTexture.expandToRGBA = options.textureRGBA;
+	if (!options.compressedTexturesDir.empty())
+	{
+		if (glfwExtensionSupported("GL_EXT_texture_compression_s3tc"))
+			gTexture.compressedDirectory = options.compressedTexturesDir;
+		else
+			cout << "No S3TC support, --compressed-textures is ignored" << endl;
+	}
+	if (options.lazyResources)
+		builder.acquireResources(resources);
+	else
+		gTexture.createTextures();
+	if (!options.packTexturesDir.empty())
+	{
+		bool packed = TexturePacker::pack(gTexture.sources, options.packTexturesDir, 0);
+		gTexture.destroyTextures();
+		glfwTerminate();
+		return packed ? 0 : -1;
+	}
+	if (options.imageBenchmarkRepeats > 0)
+	{
+		// the files the scene loads, which is every texture in resources/textures
+		vector<string> paths;
+		for (const Textures::Source& source : gTexture.sources)
+			paths.push_back(source.path);
+		ImageRows::runBenchmark(paths, options.imageBenchmarkRepeats);
+		gTexture.destroyTextures();
+		glfwTerminate();
+		return 0;
+	}
+	if (options.textureFilter > 0)
+	{
+		textureSamplers.create(gTexture, (float)options.textureFilter, glfwExtensionSupported("GL_EXT_texture_filter_anisotropic")
+			|| glfwExtensionSupported("GL_ARB_texture_filter_anisotropic"));
+		builder.textureSamplers = &textureSamplers;
+	}
+	if (options.textureArraySize >= 0 && textureArrays.build(gTexture, options.textureArraySize))
+		builder.textureArrays = &textureArrays;
+	if (bindless)
+		builder.bindlessMaterials = &bindlessMaterials;
+	builder.createMaterials(gTexture);
+	if (options.materialBenchmarkDraws > 0)
+	{
+		// the bind path draws with the regular lit shader
+		Shader bindShader("../OpenGLSample/shaderfiles/6.multiple_lights.vs", "../OpenGLSample/shaderfiles/6.multiple_lights.fs");
+		bindShader.use();
+		bindShader.setInt("material.diffuse", 0);
+		bindShader.setInt("material.specular", 1);
+		bindShader.setInt("textureOverlay", 2);
+		builder.runMaterialBenchmark(gMesh, gTexture, bindShader, lightingShader, options.materialBenchmarkDraws);
+		destroyResources();
+		glfwTerminate();
+		return 0;
+	}
 
 	// shader configuration
 	// --------------------
@@ -154,30 +478,138 @@ int main()
 	lightingShader.setInt("material.diffuse", 0);
 	lightingShader.setInt("material.specular", 1);
 	lightingShader.setInt("textureOverlay", 2);
+	PROFILE_END();
 
 	// render loop
 	// -----------
+	simClock.reset(glfwGetTime());
+	double lastFrameEnd = glfwGetTime();
+	if (!options.capturePath.empty())
+		frameCapture.start(options.capturePath, options.captureFps);
+	double batchStart = glfwGetTime();
+	if (batchMode)
+	{
+		// named frames land next to this path; every pose must be saved, so never drop one
+		if (!frameCapture.start(options.batchOutputDir + "/batch.png", 0))
+		{
+			offscreenTarget.destroy();
+			pacer.release();
+			if (dynamicResolution.enabled)
+				dynamicResolution.release();
+			if (gpuProfiler.enabled)
+				gpuProfiler.release();
+			destroyResources();
+			glfwTerminate();
+			return -1;
+		}
+		frameCapture.setBlocking(true);
+	}
+	if (!options.recordPath.empty() && !benchmarkMode && !inputLog.replaying())
+		inputLog.startRecording(options.recordPath, simClock.stepSeconds(), glfwGetTime());
 	while (!glfwWindowShouldClose(window))
 	{
+		// wait on the GPU before input is sampled, so the wait doesn't add to the input latency
+		PROFILE_BEGIN("pacing wait");
+		pacer.beginFrame();
+		PROFILE_END();
+
 		// per-frame time logic
 		// --------------------
-		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		simClock.advance(glfwGetTime());
+		if (pathTracer)
+			pathTracer->beginScene();
+
+		// input and movement, in fixed steps
+		// ----------------------------------
+		PROFILE_BEGIN("input");
+		if (benchmarkMode)
+		{
+			// the scripted path decides the scene state, frame by frame
+			applyBenchmarkFrame(benchmark.nextFrame());
+		}
+		else if (batchMode)
+		{
+			const CameraPose& pose = batchPoses.poses()[batchIndex];
+			BenchmarkFrame frame{};
+			frame.cameraPosition = pose.position;
+			frame.yaw = pose.yaw;
+			frame.pitch = pose.pitch;
+			applyBenchmarkFrame(frame);
+		}
+		else if (inputLog.replaying())
+		{
+			// the recorded steps up to the next recorded frame, stops at the end of the log
+			if (!replayToNextFrame(window))
+				glfwSetWindowShouldClose(window, true);
+		}
+		else
+		{
+			while (simClock.step())
+			{
+				prevCameraPosition = camera.Position;
+				prevPointLightPositions[0] = pointLightPositions[0];
+				prevPointLightPositions[1] = pointLightPositions[1];
+				processInput(window, simClock.stepSeconds());
+			}
+			// until a step catches the previous state up, the frame blends two poses and the
+			// resting one still has to be drawn
+			if (prevCameraPosition != camera.Position || prevPointLightPositions[0] != pointLightPositions[0]
+				|| prevPointLightPositions[1] != pointLightPositions[1])
+				scheduler.invalidate();
+		}
+		PROFILE_END();
 
-		// input
-		// -----
-		processInput(window);
+		// nothing changed since the last frame, go back to waiting for events
+		if (!scheduler.beginFrame())
+		{
+			if (scheduler.pollEvents())
+			{
+				simClock.reset(glfwGetTime());
+				pacer.resetTimer();
+			}
+			continue;
+		}
+
+		// a minimized window has no framebuffer to draw into
+		if (framebufferWidth == 0 || framebufferHeight == 0)
+		{
+			glfwWaitEvents();
+			simClock.reset(glfwGetTime());
+			pacer.resetTimer();
+			continue;
+		}
+		PROFILE_BEGIN("frame");
+		gpuProfiler.beginFrame();
+		gpuProfiler.beginScope("frame");
+
+		if (offscreenMode)
+			offscreenTarget.bind();
+
+		// draw offscreen at a reduced resolution when dynamic resolution is on
+		if (dynamicResolution.enabled)
+			dynamicResolution.beginFrame(framebufferWidth, framebufferHeight);
+
+		// blend the last two simulation steps by how far into the next step we are
+		float alpha = inputLog.replaying() ? replayAlpha : simClock.alpha();
+		if (inputLog.recording())
+			inputLog.recordFrame((uint32_t)simClock.steps(), glfwGetTime(), alpha);
+		glm::vec3 cameraPosition = glm::mix(prevCameraPosition, camera.Position, alpha);
+		glm::vec3 lightPositions[] = {
+			glm::mix(prevPointLightPositions[0], pointLightPositions[0], alpha),
+			glm::mix(prevPointLightPositions[1], pointLightPositions[1], alpha),
+		};
 
 		// render
 		// ------
+		PROFILE_BEGIN("uniform setup");
+		gpuProfiler.beginScope("setup");
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
 		// be sure to activate shader when setting uniforms/drawing objects
 		lightingShader.use();
-		lightingShader.setVec3("viewPos", camera.Position);
+		lightingShader.setVec3("viewPos", cameraPosition);
 
 		// default shininess, rough materials
 		lightingShader.setFloat("material.shininess", 2.0f);
@@ -198,7 +630,7 @@ int main()
 		lightingShader.setVec3("dirLight.diffuse", 0.2f, 0.2f, 0.2f);
 		lightingShader.setVec3("dirLight.specular", 0.1f, 0.1f, 0.1f);
 		// point light 1, orange light at 70%
-		lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
+		lightingShader.setVec3("pointLights[0].position", lightPositions[0]);
 		lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
 		lightingShader.setVec3("pointLights[0].diffuse", 1.0f, 0.5f, 0.0f);
 		lightingShader.setVec3("pointLights[0].specular", 1.0f, 0.5f, 0.0f);
@@ -208,7 +640,7 @@ int main()
 		// multiplies ambient, diffuse, and specular light by intensity strength
 		lightingShader.setFloat("pointLights[0].intensity", 0.7f); // 70%
 		// point light 2, whitish-yellow at 100%
-		lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
+		lightingShader.setVec3("pointLights[1].position", lightPositions[1]);
 		lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
 		lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.7f);
 		lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
@@ -218,7 +650,7 @@ int main()
 		// multiplies ambient, diffuse, and specular light by intensity strength
 		lightingShader.setFloat("pointLights[1].intensity", 1.0f); // 100%
 		// spotLight
-		lightingShader.setVec3("spotLight.position", camera.Position);
+		lightingShader.setVec3("spotLight.position", cameraPosition);
 		lightingShader.setVec3("spotLight.direction", camera.Front);
 		lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
 		if (showFlashlight) {
@@ -239,12 +671,12 @@ int main()
 		// View/projection transformations
 		glm::mat4 projection;
 		if (showPerspective) {
-			projection = glm::perspective(glm::radians(60.0f), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+			projection = glm::perspective(glm::radians(60.0f), (float)framebufferWidth / (float)framebufferHeight, 0.1f, 100.0f);
 		}
 		else {
 			projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
 		}
-		glm::mat4 view = camera.GetViewMatrix();
+		glm::mat4 view = camera.GetViewMatrix(cameraPosition);
 		lightingShader.setMat4("projection", projection);
 		lightingShader.setMat4("view", view);
 
@@ -253,28 +685,45 @@ int main()
 		lightingShader.setMat4("model", model);
 
 
+		gpuProfiler.endScope();
+		PROFILE_END();
+
 		// Draw the lamp object(s)
+		PROFILE_BEGIN("light cubes");
+		gpuProfiler.beginScope("light cubes");
 		lightCubeShader.use();
 		lightCubeShader.setMat4("projection", projection);
 		lightCubeShader.setMat4("view", view);
 		// Draw as many light bulbs as we have point lights.
-		glBindVertexArray(gMesh.gCubeMesh.vao);
+		const MeshCreator::GLMesh* lamp = resources.mesh(lampMesh);
+		RenderStats::bindVertexArray(lamp->vao);
 		for (unsigned int i = 0; i < 2; i++)
 		{
 			model = glm::mat4(1.0f);
-			model = glm::translate(model, pointLightPositions[i]);
+			model = glm::translate(model, lightPositions[i]);
 			model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
 			lightCubeShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, gMesh.gCubeMesh.nVertices);
+			RenderStats::drawArrays(GL_TRIANGLES, 0, lamp->nVertices);
 		}
 
 		// Deactivate the Vertex Array Object
-		glBindVertexArray(0);
+		RenderStats::bindVertexArray(0);
+		gpuProfiler.endScope();
+		PROFILE_END();
 
 		// Draw scene objects and environment
+		PROFILE_BEGIN("scene");
+		gpuProfiler.beginScope("scene");
 		lightingShader.use();
 		Transform transformData;
-		builder.createScene(gMesh, gTexture, lightingShader, transformData);
+		if (builder.textureStreamer)
+			textureStreamer.beginFrame(cameraPosition, projection, framebufferHeight);
+		builder.createScene(gMesh, lightingShader, transformData);
+		// the mips this frame asked for are there from the next one on
+		if (builder.textureStreamer)
+			textureStreamer.update();
+		gpuProfiler.endScope();
+		PROFILE_END();
 
 		// Example for reusing scene objects multiple times
 		// creates another fire flower cup on the grass to the right of desk
@@ -286,101 +735,270 @@ int main()
 		//transformData1.translation = glm::translate(glm::vec3(5.5f, -1.7f, -3.5f));
 		//builder.renderFireFlower(gMesh, gTexture, lightingShader, transformData1);
 
-		// Display skybox
+		// Display skybox, which is only resident while it is shown
+		if (showSkybox && !skyboxTexture.valid())
+		{
+			skyboxMesh = resources.acquire(MeshCreator::SKYBOX);
+			skyboxTexture = resources.acquire(Textures::SKYBOX);
+		}
+		else if (!showSkybox && skyboxTexture.valid())
+		{
+			resources.release(skyboxMesh);
+			resources.release(skyboxTexture);
+		}
 		if (showSkybox) {
-			unsigned int cubemapTexture = gTexture.loadSkyBox();
+			PROFILE_ZONE("skybox");
+			GPU_SCOPE("skybox");
+			unsigned int cubemapTexture = resources.texture(skyboxTexture);
+			const MeshCreator::GLMesh* skybox = resources.mesh(skyboxMesh);
 			glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
 			skyboxShader.use();
 
-			view = glm::mat4(glm::mat3(camera.GetViewMatrix()));
+			view = glm::mat4(glm::mat3(camera.GetViewMatrix(cameraPosition)));
 			view = glm::rotate(view, glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f)); // Rotate the view matrix by 180 degrees around the y-axis
 			skyboxShader.setMat4("projection", projection);
 			skyboxShader.setMat4("view", view);
-			glBindVertexArray(gMesh.gSkyboxMesh.vao);
+			RenderStats::bindVertexArray(skybox->vao);
 			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
+			RenderStats::bindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
 			model = glm::mat4(1.0f);
 			skyboxShader.setMat4("model", model);
 
-			glDrawArrays(GL_TRIANGLES, 0, gMesh.gSkyboxMesh.nVertices);
+			RenderStats::drawArrays(GL_TRIANGLES, 0, skybox->nVertices);
 
 			glDepthFunc(GL_LESS); // set depth function back to default
 
 			// Deactivate the Vertex Array Object
-			glBindVertexArray(0);
+			RenderStats::bindVertexArray(0);
+		}
+
+
+		// scale the offscreen image up to the window
+		if (dynamicResolution.enabled)
+		{
+			dynamicResolution.endFrame(offscreenMode ? offscreenTarget.drawFramebuffer() : 0);
+
+			ostringstream scaleText, gpuText;
+			scaleText << (int)(dynamicResolution.scale() * 100.0f + 0.5f) << "%";
+			gpuText.precision(3);
+			gpuText << dynamicResolution.gpuTimeMs() << "ms";
+			overlay.setValue("scale", scaleText.str());
+			overlay.setValue("GPU", gpuText.str());
+		}
+		gpuProfiler.endScope();
 
-			glDeleteTextures(1, &cubemapTexture);
+		// profiler bars go on top of the final image, after any upscaling
+		if (gpuProfiler.enabled)
+		{
+			gpuProfiler.drawOverlay(framebufferWidth, framebufferHeight);
+			overlay.setValue("passes", gpuProfiler.summary());
+		}
+		if (overlay.enabled)
+		{
+			const FrameStats& counts = RenderStats::current();
+			overlay.setValue("draws", to_string(counts.drawCalls));
+			overlay.setValue("tris", to_string(counts.triangles));
+			if (builder.textureStreamer)
+			{
+				const TextureStreamer::Stats& streaming = textureStreamer.stats();
+				overlay.setValue("textures", to_string(streaming.residentBytes >> 20) + "/" + to_string(streaming.budgetBytes >> 20) + " MB");
+			}
 		}
+		overlay.update(window, WINDOW_TITLE);
 
+		// queue the finished image for the capture encoders, it is read back a few frames later
+		if (frameCapture.active())
+		{
+			GLuint finished = offscreenMode ? offscreenTarget.resolve() : 0;
+			if (batchMode)
+				frameCapture.captureFrame(finished, framebufferWidth, framebufferHeight, batchPoses.poses()[batchIndex++].name);
+			else
+				frameCapture.captureFrame(finished, framebufferWidth, framebufferHeight);
+		}
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		PROFILE_BEGIN("swap");
+		if (offscreenMode)
+			glFlush();
+		else
+			glfwSwapBuffers(window);
+		PROFILE_END();
+		PROFILE_BEGIN("pacing sleep");
+		pacer.endFrame();
+		PROFILE_END();
+		PROFILE_END();
+		if (benchmarkMode)
+		{
+			double frameEnd = glfwGetTime();
+			benchmark.recordFrame((frameEnd - lastFrameEnd) * 1000.0, RenderStats::current());
+			lastFrameEnd = frameEnd;
+			if (benchmark.finished())
+				glfwSetWindowShouldClose(window, true);
+		}
+		renderStats.endFrame(glfwGetTime());
+		if (options.frameLimit > 0 && (int)renderStats.framesRendered() >= options.frameLimit)
+			glfwSetWindowShouldClose(window, true);
+		scheduler.endFrame();
+		// restart the frame timer after sleeping so the next movement doesn't jump
+		PROFILE_BEGIN("events");
+		if (scheduler.pollEvents())
+		{
+			simClock.reset(glfwGetTime());
+			pacer.resetTimer();
+		}
+		PROFILE_END();
 	}
 
+	scheduler.printStats();
+	pacer.printStats();
+	renderStats.printStats();
+	inputLog.close();
+	frameCapture.finish();
+	int exitCode = 0;
+	if (batchMode)
+	{
+		// images that failed to encode or write don't count
+		double seconds = glfwGetTime() - batchStart;
+		uint64_t written = frameCapture.written();
+		cout << "Wrote " << written << " of " << batchPoses.poses().size() << " images in " << seconds << "s ("
+			<< written / seconds << " images/s)" << endl;
+		if (written < batchPoses.poses().size())
+			exitCode = -1;
+	}
+	if (benchmarkMode)
+		benchmark.writeResults(options.benchmarkResultsPath);
+	if (offscreenMode)
+	{
+		// the target still holds the last frame
+		vector<uint8_t> pixels;
+		if (pathTracer)
+		{
+			pathTracer->setBackground(glm::vec3(SoftwareGL::clearColor()));
+			pathTracer->render(offscreenTarget.width(), offscreenTarget.height(), options.pathTraceSamples, pixels);
+			pathTracer->printStats();
+		}
+		else if (!options.outputPath.empty() || !options.comparePath.empty())
+			offscreenTarget.readPixels(pixels);
+		if (!options.outputPath.empty())
+		{
+			if (ImageWriter::write(options.outputPath, pixels.data(), offscreenTarget.width(), offscreenTarget.height(), 4, true))
+				cout << "Saved the last frame to " << options.outputPath << endl;
+		}
+		if (!options.comparePath.empty())
+			ImageDiff::compare(options.comparePath, pixels.data(), offscreenTarget.width(), offscreenTarget.height(), true);
+		offscreenTarget.destroy();
+	}
+	if (options.software)
+		SoftwareGL::rasterizer().printStats();
+	textureArrays.printStats();
+	bindlessMaterials.printStats();
+	resources.printStats();
+	textureSamplers.printStats();
+	textureStreamer.printStats();
+	textureUploader.printStats();
+	pacer.release();
+	if (dynamicResolution.enabled)
+		dynamicResolution.release();
+	if (gpuProfiler.enabled)
+		gpuProfiler.printStats();
+	if (!options.tracePath.empty())
+	{
+		CpuProfiler::printStats();
+		CpuProfiler::writeTrace(options.tracePath, &gpuProfiler);
+	}
+	if (gpuProfiler.enabled)
+		gpuProfiler.release();
+
 
 	// De-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
-	
-	// Release meshes data
-	gMesh.destroyMeshes();
-
-	// Release textures
-	gTexture.destroyTextures();
+	destroyResources();
 
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
-	return 0;
+	return exitCode;
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processInput(GLFWwindow* window)
+void processInput(GLFWwindow* window, float stepTime)
 {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	// the keys come from the log when replaying, and go into it when recording
+	uint32_t keys = 0;
+	if (inputLog.replaying())
+	{
+		keys = replayKeys;
+	}
+	else
+	{
+		for (int i = 0; i < (int)(sizeof(POLLED_KEYS) / sizeof(POLLED_KEYS[0])); i++)
+		{
+			if (glfwGetKey(window, POLLED_KEYS[i]) == GLFW_PRESS)
+				keys |= 1u << i;
+		}
+		if (inputLog.recording())
+			inputLog.recordKeyState((uint32_t)simClock.steps(), glfwGetTime(), keys);
+	}
+	auto pressed = [keys](int key) {
+		for (int i = 0; i < (int)(sizeof(POLLED_KEYS) / sizeof(POLLED_KEYS[0])); i++)
+		{
+			if (POLLED_KEYS[i] == key)
+				return (keys & (1u << i)) != 0;
+		}
+		return false;
+	};
+
+	if (pressed(GLFW_KEY_ESCAPE))
 		glfwSetWindowShouldClose(window, true);
 
 	// Camera movement
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		camera.ProcessKeyboard(RIGHT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
-		camera.ProcessKeyboard(DOWN, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
-		camera.ProcessKeyboard(UP, deltaTime);
+	glm::vec3 oldPosition = camera.Position;
+	if (pressed(GLFW_KEY_W))
+		camera.ProcessKeyboard(FORWARD, stepTime);
+	if (pressed(GLFW_KEY_S))
+		camera.ProcessKeyboard(BACKWARD, stepTime);
+	if (pressed(GLFW_KEY_A))
+		camera.ProcessKeyboard(LEFT, stepTime);
+	if (pressed(GLFW_KEY_D))
+		camera.ProcessKeyboard(RIGHT, stepTime);
+	if (pressed(GLFW_KEY_Q))
+		camera.ProcessKeyboard(DOWN, stepTime);
+	if (pressed(GLFW_KEY_E))
+		camera.ProcessKeyboard(UP, stepTime);
+	if (camera.Position != oldPosition)
+		scheduler.invalidateContinuous();
 
 	// Point light selection
-	if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+	if (pressed(GLFW_KEY_1))
 		lightNumber = 1;
-	if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+	if (pressed(GLFW_KEY_2))
 		lightNumber = 2;
 
 	// Animate point lights
-	if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
-		moveLight("forward", deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
-		moveLight("backward", deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_J) == GLFW_PRESS)
-		moveLight("left", deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
-		moveLight("right", deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS)
-		moveLight("down", deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
-		moveLight("up", deltaTime);
+	if (pressed(GLFW_KEY_I))
+		moveLight("forward", stepTime);
+	if (pressed(GLFW_KEY_K))
+		moveLight("backward", stepTime);
+	if (pressed(GLFW_KEY_J))
+		moveLight("left", stepTime);
+	if (pressed(GLFW_KEY_L))
+		moveLight("right", stepTime);
+	if (pressed(GLFW_KEY_U))
+		moveLight("down", stepTime);
+	if (pressed(GLFW_KEY_O))
+		moveLight("up", stepTime);
 
 }
 
 // Toggles perspective and ortho projection, or toggles flashlight
 void toggleEvent(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	// events arrive between frames, so they first affect the next simulation step
+	if (inputLog.recording())
+		inputLog.recordKey((uint32_t)simClock.steps() + 1, glfwGetTime(), key, action);
+
 	if (key == GLFW_KEY_P && action == GLFW_PRESS) {
 		showPerspective = !showPerspective;
 	}
@@ -390,6 +1008,85 @@ void toggleEvent(GLFWwindow* window, int key, int scancode, int action, int mods
 	if (key == GLFW_KEY_B && action == GLFW_PRESS) {
 		showSkybox = !showSkybox;
 	}
+	if ((key == GLFW_KEY_P || key == GLFW_KEY_F || key == GLFW_KEY_B) && action == GLFW_PRESS)
+		scheduler.invalidate();
+
+	// a wake restarts the clock with no step pending, so keep polling until the steps see a held key
+	if (action == GLFW_PRESS || action == GLFW_REPEAT)
+	{
+		for (int polled : POLLED_KEYS)
+		{
+			if (polled == key)
+				scheduler.invalidateContinuous();
+		}
+	}
+}
+
+// Puts the camera, lights and toggles where the benchmark path wants them this frame
+void applyBenchmarkFrame(const BenchmarkFrame& frame)
+{
+	camera.Position = frame.cameraPosition;
+	camera.SetOrientation(frame.yaw, frame.pitch);
+	for (int i = 0; i < 2; i++)
+	{
+		if (frame.moveLight[i])
+			pointLightPositions[i] = frame.lightPositions[i];
+	}
+	for (const string& toggle : frame.toggles)
+	{
+		if (toggle == "perspective")
+			showPerspective = !showPerspective;
+		else if (toggle == "flashlight")
+			showFlashlight = !showFlashlight;
+		else if (toggle == "skybox")
+			showSkybox = !showSkybox;
+	}
+
+	// no interpolation, every frame shows exactly the scripted pose
+	prevCameraPosition = camera.Position;
+	prevPointLightPositions[0] = pointLightPositions[0];
+	prevPointLightPositions[1] = pointLightPositions[1];
+}
+
+// Runs one simulation step with the replayed key state
+void replayStep(GLFWwindow* window)
+{
+	simClock.forceStep();
+	prevCameraPosition = camera.Position;
+	prevPointLightPositions[0] = pointLightPositions[0];
+	prevPointLightPositions[1] = pointLightPositions[1];
+	processInput(window, simClock.stepSeconds());
+}
+
+// Feeds the log back in recorded order: each event is applied just before the step it was
+// stamped with, and the steps stop at the next recorded frame, which also gives its alpha.
+// Returns false once the log is used up
+bool replayToNextFrame(GLFWwindow* window)
+{
+	InputEvent event;
+	while (inputLog.next(event))
+	{
+		if (event.type == InputEvent::FRAME)
+		{
+			while (simClock.steps() < event.step)
+				replayStep(window);
+			replayAlpha = (float)event.x;
+			return true;
+		}
+
+		while (simClock.steps() + 1 < event.step)
+			replayStep(window);
+
+		if (event.type == InputEvent::MOUSE_MOVE)
+			mouse_callback(window, event.x, event.y);
+		else if (event.type == InputEvent::SCROLL)
+			scroll_callback(window, event.x, event.y);
+		else if (event.type == InputEvent::KEY)
+			toggleEvent(window, event.key, 0, event.action, 0);
+		else if (event.type == InputEvent::KEY_STATE)
+			replayKeys = event.keys;
+	}
+	return false;
 }
 
 // Processes input received from any keyboard-like input system.
@@ -410,6 +1107,9 @@ void moveLight(string direction, float time)
 		light.y -= speed; // Move down
 	if (direction == "up")
 		light.y += speed; // Move up
+
+	// keep drawing while the key is held, even if no new events arrive
+	scheduler.invalidateContinuous();
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -419,12 +1119,25 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 	// make sure the viewport matches the new window dimensions; note that width and 
 	// height will be significantly larger than specified on retina displays.
 	glViewport(0, 0, width, height);
+	framebufferWidth = width;
+	framebufferHeight = height;
+	scheduler.invalidate();
+}
+
+// glfw: whenever the window contents need to be redrawn (uncovered, restored), this callback is called
+// ---------------------------------------------------------------------------------------------
+void window_refresh_callback(GLFWwindow* window)
+{
+	scheduler.invalidate();
 }
 
 // glfw: whenever the mouse moves, this callback is called
 // -------------------------------------------------------
 void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 {
+	if (inputLog.recording())
+		inputLog.recordMouse((uint32_t)simClock.steps() + 1, glfwGetTime(), xpos, ypos);
+
 	if (firstMouse)
 	{
 		lastX = xpos;
@@ -439,11 +1152,15 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 	lastY = ypos;
 
 	camera.ProcessMouseMovement(xoffset, yoffset);
+	scheduler.invalidate();
 }
 
 // glfw: whenever the mouse scroll wheel scrolls, this callback is called
 // ----------------------------------------------------------------------
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
+	if (inputLog.recording())
+		inputLog.recordScroll((uint32_t)simClock.steps() + 1, glfwGetTime(), xoffset, yoffset);
+
 	camera.ProcessMouseScroll(yoffset);
 }
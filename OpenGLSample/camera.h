@@ -70,6 +70,12 @@ public:
 		return glm::lookAt(Position, Position + Front, Up);
 	}
 
+	// Same as above but looking from another position, used to render an interpolated camera
+	glm::mat4 GetViewMatrix(const glm::vec3& position)
+	{
+		return glm::lookAt(position, position + Front, Up);
+	}
+
 	// processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 	{
@@ -110,6 +116,14 @@ public:
 		updateCameraVectors();
 	}
 
+	// sets the Euler angles directly, used by scripted camera paths
+	void SetOrientation(float yaw, float pitch)
+	{
+		Yaw = yaw;
+		Pitch = pitch;
+		updateCameraVectors();
+	}
+
 	// processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
 	void ProcessMouseScroll(float yoffset)
 	{
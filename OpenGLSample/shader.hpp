@@ -1,6 +1,9 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <glad/glad.h>
+
+// Builds a program through ShaderCache::shared(); returns the program ID
 GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
 
 #endif
@@ -7,42 +7,8 @@ struct Material {
     float shininess;
 }; 
 
-struct DirLight {
-    vec3 direction;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-    float intensity;
-
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
-    float constant;
-    float linear;
-    float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
-};
+// DirLight, PointLight and SpotLight are shared with any shader that lights the scene
+#include "lights.glsl"
 
 #define NR_POINT_LIGHTS 2
 
@@ -59,10 +25,19 @@ uniform vec2 uvScale;
 uniform sampler2D textureOverlay;
 
 
-// function prototypes
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+// Material texture lookups used by phong.glsl
+vec3 diffuseColor()
+{
+    return vec3(texture(material.diffuse, TexCoords * uvScale));
+}
+
+vec3 specularColor()
+{
+    return vec3(texture(material.specular, TexCoords * uvScale));
+}
+
+// CalcDirLight, CalcPointLight and CalcSpotLight
+#include "phong.glsl"
 
 void main()
 {    
@@ -95,67 +70,3 @@ void main()
         FragColor = vec4(result, 1.0);
     }
 }
-
-// calculates the color when using a directional light.
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
-{
-    vec3 lightDir = normalize(-light.direction);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords * uvScale));
-    return (ambient + diffuse + specular);
-}
-
-// calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
-    // combine results
-    vec3 ambient = light.intensity * light.ambient * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 diffuse = light.intensity * light.diffuse * diff * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 specular = light.intensity * light.specular * spec * vec3(texture(material.specular, TexCoords * uvScale));
-    ambient *= attenuation;
-    diffuse *= attenuation;
-    specular *= attenuation;
-    return (ambient + diffuse + specular);
-}
-
-// calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
-{
-    vec3 lightDir = normalize(light.position - fragPos);
-    // diffuse shading
-    float diff = max(dot(normal, lightDir), 0.0);
-    // specular shading
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    // attenuation
-    float distance = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
-    // spotlight intensity
-    float theta = dot(lightDir, normalize(-light.direction)); 
-    float epsilon = light.cutOff - light.outerCutOff;
-    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
-    // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords * uvScale));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords * uvScale));
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
-}
\ No newline at end of file
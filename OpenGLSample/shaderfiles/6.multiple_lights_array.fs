@@ -0,0 +1,88 @@
+#version 330 core
+out vec4 FragColor;
+
+// 6.multiple_lights.fs with every material texture a layer of a texture array, so draws that
+// use different textures can share the same bound arrays
+struct Material {
+    sampler2DArray diffuse;
+    sampler2DArray specular;
+    float shininess;
+}; 
+
+// DirLight, PointLight and SpotLight are shared with any shader that lights the scene
+#include "lights.glsl"
+
+#define NR_POINT_LIGHTS 2
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+uniform PointLight pointLights[NR_POINT_LIGHTS];
+uniform SpotLight spotLight;
+uniform Material material;
+uniform vec2 uvScale;
+uniform sampler2DArray textureOverlay;
+// Layer of the diffuse, specular and overlay texture. Bit 16 asks for mirrored repeat, which
+// the arrays can't wrap with per layer, and -1 is a unit with no texture
+uniform int textureLayers[3];
+
+
+// Samples like an unbound unit would when entry is -1
+vec4 sampleLayer(sampler2DArray textures, int entry)
+{
+    if (entry < 0)
+        return vec4(0.0, 0.0, 0.0, 1.0);
+    vec2 uv = TexCoords * uvScale;
+    if ((entry & 0x10000) != 0)
+        uv = 1.0 - abs(mod(uv, 2.0) - 1.0);
+    return texture(textures, vec3(uv, float(entry & 0xFFFF)));
+}
+
+// Material texture lookups used by phong.glsl
+vec3 diffuseColor()
+{
+    return vec3(sampleLayer(material.diffuse, textureLayers[0]));
+}
+
+vec3 specularColor()
+{
+    return vec3(sampleLayer(material.specular, textureLayers[1]));
+}
+
+// CalcDirLight, CalcPointLight and CalcSpotLight
+#include "phong.glsl"
+
+void main()
+{    
+    // properties
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    
+    vec4 overlay = sampleLayer(textureOverlay, textureLayers[2]);
+
+    // == =====================================================
+    // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
+    // For each phase, a calculate function is defined that calculates the corresponding color
+    // per lamp. In the main() function we take all the calculated colors and sum them up for
+    // this fragment's final color.
+    // == =====================================================
+    // phase 1: directional lighting
+    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    // phase 2: point lights
+    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    // phase 3: spot light
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
+    vec4 defaultTexture = vec4(0.0, 0.0, 0.0, 1.0);
+
+    if (overlay != defaultTexture) {
+        // Overlap textures with alpha blending
+        FragColor = overlay * overlay.a + vec4(result, 1.0) * (1.0 - overlay.a);
+    }
+    else {
+        FragColor = vec4(result, 1.0);
+    }
+}
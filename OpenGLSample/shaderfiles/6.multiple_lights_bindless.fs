@@ -0,0 +1,94 @@
+#version 330 core
+#extension GL_ARB_bindless_texture : require
+out vec4 FragColor;
+
+// 6.multiple_lights.fs with the material read from a table of resident texture handles, so a
+// draw picks its textures with one index instead of binding them
+
+// Set from the table in main(), phong.glsl reads the shininess
+struct Material {
+    float shininess;
+};
+
+// DirLight, PointLight and SpotLight are shared with any shader that lights the scene
+#include "lights.glsl"
+
+#define NR_POINT_LIGHTS 2
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+uniform PointLight pointLights[NR_POINT_LIGHTS];
+uniform SpotLight spotLight;
+// Three texels per material: the diffuse and specular handles, the overlay handle and the
+// shininess bits, the UV scale bits. A zero handle is a unit with no texture
+uniform usamplerBuffer materialTable;
+uniform int materialIndex;
+
+Material material;
+uvec4 handles[2];
+vec2 uvScale;
+
+
+// Samples like an unbound unit would when handle is zero
+vec4 sampleHandle(uvec2 handle)
+{
+    if (handle == uvec2(0u))
+        return vec4(0.0, 0.0, 0.0, 1.0);
+    return texture(sampler2D(handle), TexCoords * uvScale);
+}
+
+// Material texture lookups used by phong.glsl
+vec3 diffuseColor()
+{
+    return vec3(sampleHandle(handles[0].xy));
+}
+
+vec3 specularColor()
+{
+    return vec3(sampleHandle(handles[0].zw));
+}
+
+// CalcDirLight, CalcPointLight and CalcSpotLight
+#include "phong.glsl"
+
+void main()
+{    
+    // properties
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // material
+    handles[0] = texelFetch(materialTable, materialIndex * 3);
+    handles[1] = texelFetch(materialTable, materialIndex * 3 + 1);
+    material.shininess = uintBitsToFloat(handles[1].z);
+    uvScale = uintBitsToFloat(texelFetch(materialTable, materialIndex * 3 + 2).xy);
+    
+    vec4 overlay = sampleHandle(handles[1].xy);
+
+    // == =====================================================
+    // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
+    // For each phase, a calculate function is defined that calculates the corresponding color
+    // per lamp. In the main() function we take all the calculated colors and sum them up for
+    // this fragment's final color.
+    // == =====================================================
+    // phase 1: directional lighting
+    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    // phase 2: point lights
+    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    // phase 3: spot light
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
+    vec4 defaultTexture = vec4(0.0, 0.0, 0.0, 1.0);
+
+    if (overlay != defaultTexture) {
+        // Overlap textures with alpha blending
+        FragColor = overlay * overlay.a + vec4(result, 1.0) * (1.0 - overlay.a);
+    }
+    else {
+        FragColor = vec4(result, 1.0);
+    }
+}